@@ -67,7 +67,7 @@ AppMenu::AppMenu(QWidget* parent) : QMenu(parent)
     APPS.clear();
     start(); // do the initial run during session init so things are responsive immediately.
     connect(QApplication::instance(), SIGNAL(LocaleChanged()), this, SLOT(watcherUpdate()) );
-    connect(QApplication::instance(), SIGNAL(IconThemeChanged()), this, SLOT(watcherUpdate()) );
+    // NOTE: No rebuild on IconThemeChanged(), the icon cache updates the changed icons in place
 }
 
 AppMenu::~AppMenu()
@@ -83,7 +83,7 @@ void AppMenu::updateAppList()
 {
     // Make sure the title/icon are updated as well (in case of locale/icon change)
     this->setTitle(tr("Applications"));
-    this->setIcon( LXDG::findIcon("system-run","") );
+    ICONS->applyIcon(this, "system-run");
 
     // Now update the lists
     this->clear();
@@ -137,7 +137,7 @@ void AppMenu::updateAppList()
 
         QMenu *menu = new QMenu(name, this);
         //menu->setIcon( ICONS->loadIcon(icon) );
-        menu->setIcon(LXDG::findIcon(icon,""));
+        ICONS->applyIcon(menu, icon);
         connect(menu, SIGNAL(triggered(QAction*)), this, SLOT(launchApp(QAction*)) );
         QList<XDGDesktop*> appL = APPS.value(cats[i]);
 
@@ -146,7 +146,7 @@ void AppMenu::updateAppList()
                 // Just a single entry point - no extra actions
                 QAction *act = new QAction(appL[a]->name, this);
                 //ICONS->loadIcon(act, appL[a]->icon);
-                act->setIcon(LXDG::findIcon(appL[a]->icon, ""));
+                ICONS->applyIcon(act, appL[a]->icon);
                 act->setToolTip(appL[a]->comment);
                 act->setWhatsThis(appL[a]->filePath);
                 menu->addAction(act);
@@ -154,11 +154,11 @@ void AppMenu::updateAppList()
                 // This app has additional actions - make this a sub menu
                 // - first the main menu/action
                 QMenu *submenu = new QMenu(appL[a]->name, this);
-                submenu->setIcon( /*ICONS->loadIcon(appL[a]->icon )*/ LXDG::findIcon(appL[a]->icon));
+                ICONS->applyIcon(submenu, appL[a]->icon);
                 // This is the normal behavior - not a special sub-action (although it needs to be at the top of the new menu)
                 QAction *act = new QAction(appL[a]->name, this);
                 //ICONS->loadIcon(act, appL[a]->icon);
-                act->setIcon(LXDG::findIcon(appL[a]->icon, ""));
+                ICONS->applyIcon(act, appL[a]->icon);
                 act->setToolTip(appL[a]->comment);
                 act->setWhatsThis(appL[a]->filePath);
                 submenu->addAction(act);
@@ -167,7 +167,7 @@ void AppMenu::updateAppList()
                     QAction *sact = new QAction( appL[a]->actions[sa].name, this);
                     //if (ICONS->exists(appL[a]->actions[sa].icon)) { ICONS->loadIcon(sact, appL[a]->actions[sa].icon); }
                     //else { ICONS->loadIcon(sact, appL[a]->icon); }
-                    sact->setIcon(LXDG::findIcon(appL[a]->actions[sa].icon, ""));
+                    ICONS->applyIcon(sact, appL[a]->actions[sa].icon);
                     sact->setToolTip(appL[a]->comment);
                     sact->setWhatsThis("-action \""+appL[a]->actions[sa].ID+"\" \""+appL[a]->filePath+"\"");
                     submenu->addAction(sact);
@@ -86,7 +86,8 @@ QPixmap LDesktopBackground::setBackground(const QString& bgFile,
         painter.drawRect(dx, dy, drawWidth, drawHeight);
     }
     //this->repaint(); //make sure the entire thing gets repainted right away
-   //LSession::handle()->XCB->paintRoot(geom, &bgPixmap);
+    // Also keep the root background in sync (_XROOTPMAP_ID for pseudo-transparent clients)
+    LSession::handle()->XCB->paintRoot(geom, &bgPixmap);
     return bgPixmap;
     //show();
 }
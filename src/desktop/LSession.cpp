@@ -77,6 +77,7 @@ LSession::LSession(int &argc, char ** argv) :
   , XCB(Q_NULLPTR)
   , watcher(Q_NULLPTR)
   , screenTimer(Q_NULLPTR)
+  , geomTimer(Q_NULLPTR)
   , xchange(false)
   , appmenu(Q_NULLPTR)
   //, settingsmenu(Q_NULLPTR)
@@ -91,8 +92,10 @@ LSession::LSession(int &argc, char ** argv) :
   , TrayDmgError(0)
   , TrayStopping(false)
   , lastActiveWin(0)
+  , winModel(Q_NULLPTR)
   , startupApps(true)
   , pm(Q_NULLPTR)
+  , power(Q_NULLPTR)
 {
     // Get the currently-set theme
     QString cTheme = QIcon::themeName();
@@ -139,6 +142,13 @@ LSession::LSession(int &argc, char ** argv) :
                 SIGNAL(timeout()),
                 this,
                 SLOT(updateDesktops()));
+        geomTimer = new QTimer(this);
+        geomTimer->setSingleShot(true);
+        geomTimer->setInterval(50);
+        connect(geomTimer,
+                SIGNAL(timeout()),
+                this,
+                SLOT(checkWindowGeoms()));
 
         // check for clean session and startup apps
         for (int i=1; i<argc; i++) {
@@ -149,8 +159,19 @@ LSession::LSession(int &argc, char ** argv) :
             }
         }
 
-        ICONS = new LIconCache(this);
+        ICONS = LIconCache::instance(); // same cache as LXDG::findIcon()
+        connect(ICONS,
+                SIGNAL(IconThemeSwitched(QString,QStringList)),
+                this,
+                SLOT(iconThemeSwitched(QString,QStringList)));
         XCB = new LXCB(); //need access to XCB data/functions right away
+        winModel = new LWindowModel(XCB, this);
+        connect(winModel, SIGNAL(WindowAdded(WId)), this, SLOT(windowAdded(WId)));
+        connect(winModel, SIGNAL(WindowRemoved(WId)), this, SLOT(windowRemoved(WId)));
+        connect(winModel, SIGNAL(CurrentWorkspaceChanged(uint)), this, SLOT(windowWorkspaceChanged()));
+        // Listen for property changes on the windows which are already open
+        QList<WId> wins = winModel->windows(true);
+        for (int i=0; i<wins.length(); i++) { XCB->SelectInput(wins[i]); }
 
         // Setup the event filter
         evFilter =  new XCBEventFilter(this);
@@ -183,6 +204,8 @@ LSession::LSession(int &argc, char ** argv) :
                                   Draco::powerSessionPath(),
                                   Draco::powerSessionName(),
                                   QDBusConnection::sessionBus(), this);
+        power = new PowerStateClient(this);
+        connect(power, SIGNAL(stateChanged()), this, SIGNAL(PowerStateChanged()));
 
     //} // end check for primary process
 }
@@ -216,6 +239,9 @@ void LSession::setupSession()
                                   .arg(DE_PLUGIN_SETTINGS)
                                   .arg(DE_DESKTOP_SETTINGS));
 
+    // How often the X event updates are sent out (0 -> once per display frame)
+    evFilter->setCoalesceInterval(sessionsettings->value("EventCoalesceInterval", 0).toInt());
+
     // Initialize the internal variables
     DESKTOPS.clear();
 
@@ -281,8 +307,7 @@ void LSession::setupSession()
             SLOT(SessionEnding()));
 
     // Check gtk config
-    Draco::checkGtk2Conf(QIcon::themeName(), QApplication::font());
-    Draco::checkGtk3Conf(QIcon::themeName(), QApplication::font());
+    syncGtkConf();
 
     // Initialize startup applications
     launchStartupApps();
@@ -435,34 +460,56 @@ void LSession::lockScreen()
 
 void LSession::reloadIconTheme()
 {
-    // Wait a moment for things to settle before sending out the signal to the interfaces
-    QApplication::processEvents();
-    QApplication::processEvents();
-    emit IconThemeChanged();
+    // The icon cache prepares the new theme in the background and only updates
+    // the icons that changed, IconThemeChanged() is sent once it has been swapped in
+    QSettings conf(Draco::themeSettingsFile(), QSettings::IniFormat);
+    QString theme = conf.value("Appearance/icon_theme", QIcon::themeName()).toString();
+    if (!ICONS->switchIconTheme(theme)) { syncGtkConf(); } // same icon theme, fonts might have changed
+}
+
+void LSession::iconThemeSwitched(const QString &theme, const QStringList &changed)
+{
+    Q_UNUSED(theme)
+    syncGtkConf(); // QIcon::themeName() is the new theme now
+    if (!changed.isEmpty()) { emit IconThemeChanged(); }
+}
+
+void LSession::syncGtkConf()
+{
+    Draco::checkGtk2Conf(QIcon::themeName(), QApplication::font());
+    Draco::checkGtk3Conf(QIcon::themeName(), QApplication::font());
 }
 
 bool LSession::canShutdown()
 {
+    if (power->isValid()) { return power->canPowerOff(); }
+    // state not received yet, ask once directly
     if (pm->isValid()) { return PowerClient::canPowerOff(pm); }
-    return false; //pm->CanPowerOff();
+    return false;
 }
 
 bool LSession::canReboot()
 {
+    if (power->isValid()) { return power->canRestart(); }
+    // state not received yet, ask once directly
     if (pm->isValid()) { return PowerClient::canRestart(pm); }
-    return false; //pm->CanRestart();
+    return false;
 }
 
 bool LSession::canSuspend()
 {
+    if (power->isValid()) { return power->canSuspend(); }
+    // state not received yet, ask once directly
     if (pm->isValid()) { return PowerClient::canSuspend(pm); }
-    return false; //pm->CanSuspend();
+    return false;
 }
 
 bool LSession::canHibernate()
 {
+    if (power->isValid()) { return power->canHibernate(); }
+    // state not received yet, ask once directly
     if (pm->isValid()) { return PowerClient::canHibernate(pm); }
-    return false; //pm->CanHibernate();
+    return false;
 }
 
 void LSession::watcherChange(QString changed)
@@ -474,8 +521,7 @@ void LSession::watcherChange(QString changed)
     if (changed.contains(Draco::windowManagerConf())) { refreshWindowManager(); }
     if (changed.contains(Draco::dracoStyleConf())) { emit IconThemeChanged(); }
     if (changed.contains(Draco::themeSettingsFile())) {
-        Draco::checkGtk2Conf(QIcon::themeName(), QApplication::font()); // update gtk2 conf
-        Draco::checkGtk3Conf(QIcon::themeName(), QApplication::font()); // update gtk3 conf
+        reloadIconTheme(); // gtk confs are updated once the new icon theme is in place
     }
     if (changed.endsWith(QString("%1.conf").arg(DE_SESSION_SETTINGS)) ) {
         sessionsettings->sync();
@@ -527,12 +573,40 @@ void LSession::screenResized(int scrn)
 
 void LSession::checkWindowGeoms()
 {
-    //Only do one window per run (this will be called once per new window - with time delays between)
-    if (checkWin.isEmpty()) { return; }
-    WId win = checkWin.takeFirst();
-    if (RunningApps.contains(win) ) { //just to make sure it did not close during the delay
-        adjustWindowGeom( win );
+    // All the windows which showed up since the last run are checked in one pass
+    QList<WId> wins;
+    for (int i=0; i<checkWin.length(); i++) {
+        if (winModel->contains(checkWin[i])) { wins << checkWin[i]; } // just to make sure it did not close during the delay
     }
+    checkWin.clear();
+    if (wins.isEmpty()) { return; }
+    QList<LXCB::window_geometry> geoms = XCB->WindowGeometries(wins);
+    for (int i=0; i<geoms.length(); i++) { adjustWindowGeom(geoms[i]); }
+    xcb_flush(QX11Info::connection()); // send all the move/resize requests together
+}
+
+void LSession::windowAdded(WId win)
+{
+    if (!TrayStopping) {
+        // Perform sanity checks on any new window geometries
+        if (!checkWin.contains(win)) { checkWin << win; }
+        XCB->SelectInput(win); // make sure we get property/focus events for this window
+        qDebug() << "New Window - check geom in a moment:" << winModel->info(win).rec.wclass;
+        if (!geomTimer->isActive()) { geomTimer->start(); } // not restarted: a burst of windows is handled together
+    }
+    emit WindowListEvent();
+}
+
+void LSession::windowRemoved(WId win)
+{
+    checkWin.removeAll(win);
+    XCB->ForgetWindow(win); // unmanaged windows never send us DestroyNotify
+    emit WindowListEvent();
+}
+
+void LSession::windowWorkspaceChanged()
+{
+    emit WindowListEvent();
 }
 
 void LSession::setupFallbackDesktop(QSettings *dset)
@@ -684,20 +758,26 @@ void LSession::registerDesktopWindows()
 
 // REMOVE?
 void LSession::adjustWindowGeom(WId win, bool maximize){
+  QList<LXCB::window_geometry> geoms = XCB->WindowGeometries(QList<WId>() << win);
+  if(geoms.isEmpty()){ return; }
+  adjustWindowGeom(geoms.first(), maximize);
+}
+
+void LSession::adjustWindowGeom(const LXCB::window_geometry &info, bool maximize){
   //return; //temporary disable
-  qDebug() << "AdjustWindowGeometry():" << win << maximize << XCB->WindowClass(win);
-  if(XCB->WindowIsFullscreen(win) >=0 ){ return; } //don't touch it
+  WId win = info.id;
+  qDebug() << "AdjustWindowGeometry():" << win << maximize << winModel->info(win).rec.wclass;
   //Quick hack for making sure that new windows are not located underneath any panels
-  // Get the window location
-  QRect geom = XCB->WindowGeometry(win, false);
-  //Get the frame size
-  QList<int> frame = XCB->WindowFrameGeometry(win); //[top,bottom,left,right] sizes of the frame
+  // Window location and frame size: [top,bottom,left,right]
+  QRect geom = info.geom;
+  QList<int> frame = info.frame;
   //Calculate the full geometry (window + frame)
   QRect fgeom = QRect(geom.x()-frame[2], geom.y()-frame[0], geom.width()+frame[2]+frame[3], geom.height()+frame[0]+frame[1]);
 
-    qDebug() << "Check Window Geometry:" << XCB->WindowClass(win) << !geom.isNull() << geom << fgeom;
+    qDebug() << "Check Window Geometry:" << winModel->info(win).rec.wclass << !geom.isNull() << geom << fgeom;
 
   if(geom.isNull()){ return; } //Could not get geometry for some reason
+  if(XCB->WindowIsFullscreen(win, geom) >=0 ){ return; } //don't touch it
   //Get the available geometry for the screen the window is on
   QRect desk;
   for(int i=0; i<DESKTOPS.length(); i++){
@@ -819,23 +899,29 @@ QSettings* LSession::DesktopPluginSettings()
     return DPlugSettings;
 }
 
+LWindowModel* LSession::windowModel()
+{
+    return winModel;
+}
+
 WId LSession::activeWindow()
 {
     // Check the last active window pointer first
-    WId active = XCB->ActiveWindow();
+    QList<WId> apps = winModel->windows();
+    WId active = winModel->activeWindow();
     qDebug() << "Check Active Window:" << active << lastActiveWin;
-    if (RunningApps.contains(active)) { lastActiveWin = active; }
-    else if (RunningApps.contains(lastActiveWin) && XCB->WindowState(lastActiveWin) >= LXCB::VISIBLE){} //no change needed
-    else if (RunningApps.contains(lastActiveWin) && RunningApps.length()>1){
-        int start = RunningApps.indexOf(lastActiveWin);
-        if (start<1) { lastActiveWin = RunningApps.length()-1; } // wrap around to the last item
-        else { lastActiveWin = RunningApps[start-1]; }
+    if (apps.contains(active)) { lastActiveWin = active; }
+    else if (apps.contains(lastActiveWin) && winModel->info(lastActiveWin).status >= LXCB::VISIBLE){} //no change needed
+    else if (apps.contains(lastActiveWin) && apps.length()>1){
+        int start = apps.indexOf(lastActiveWin);
+        if (start<1) { lastActiveWin = apps.last(); } // wrap around to the last item
+        else { lastActiveWin = apps[start-1]; }
     } else {
         // Need to change the last active window - find the first one which is visible
         lastActiveWin = 0; // fallback value - nothing active
-        for (int i=0; i<RunningApps.length(); i++) {
-            if (XCB->WindowState(RunningApps[i]) >= LXCB::VISIBLE) {
-                lastActiveWin = RunningApps[i];
+        for (int i=0; i<apps.length(); i++) {
+            if (winModel->info(apps[i]).status >= LXCB::VISIBLE) {
+                lastActiveWin = apps[i];
                 break;
             }
         }
@@ -882,37 +968,42 @@ void LSession::RootSizeChange()
 void LSession::WindowPropertyEvent()
 {
     qDebug() << "Window Property Event";
-    QList<WId> newapps = XCB->WindowList();
-    if (RunningApps.length() < newapps.length()) {
-        // New Window found
-        qDebug() << "New window found";
-        // Perform sanity checks on any new window geometries
-        for (int i=0; i<newapps.length() && !TrayStopping; i++) {
-            if (!RunningApps.contains(newapps[i])) {
-                checkWin << newapps[i];
-                XCB->SelectInput(newapps[i]); // make sure we get property/focus events for this window
-                qDebug() << "New Window - check geom in a moment:" << XCB->WindowClass(newapps[i]);
-                QTimer::singleShot(50, this, SLOT(checkWindowGeoms()) );
-            }
-        }
-    }
-
-    // Now save the list and send out the event
-    RunningApps = newapps;
-    emit WindowListEvent();
+    // The model only emits signals for the windows which actually changed
+    winModel->refresh();
 }
 
 void LSession::WindowPropertyEvent(WId win)
 {
     // Emit the single-app signal if the window in question is one used by the task manager
-    if (RunningApps.contains(win)) {
-        qDebug() << "Single-window property event";
-        WindowPropertyEvent(); // Run through the entire routine for window checks
-    } else if (RunningTrayApps.contains(win)) {
+    if (RunningTrayApps.contains(win)) {
         emit TrayIconChanged(win);
+    } else if (winModel->contains(win)) {
+        qDebug() << "Single-window property event";
+        winModel->propertyChanged(win, XCB_ATOM_NONE); // re-read just this window
     }
 }
 
+void LSession::WindowPropertyEvent(WId win, xcb_atom_t atom)
+{
+    if (RunningTrayApps.contains(win)) { emit TrayIconChanged(win); }
+    else { winModel->propertyChanged(win, atom); } // only that window/property gets re-read
+}
+
+void LSession::ClientListEvent()
+{
+    winModel->clientListChanged();
+}
+
+void LSession::WorkspaceEvent()
+{
+    winModel->workspaceChanged();
+}
+
+void LSession::ActiveWindowEvent()
+{
+    winModel->activeWindowChanged();
+}
+
 void LSession::SysTrayDockRequest(WId win)
 {
     if (TrayStopping) { return; }
@@ -921,27 +1012,32 @@ void LSession::SysTrayDockRequest(WId win)
 
 void LSession::WindowClosedEvent(WId win)
 {
+    winModel->windowClosed(win);
     if (TrayStopping) { return; }
     removeTrayWindow(win); // Check to see if the window is a tray app
 }
 
+void LSession::WindowInvalidEvent(WId win)
+{
+    if (TrayStopping) { return; }
+    removeTrayWindow(win); // tray app died before we could watch it
+}
+
 void LSession::WindowConfigureEvent(WId win)
 {
     if (TrayStopping){ return; }
     if (RunningTrayApps.contains(win)) {
         qDebug() << "SysTray: Configure Event";
         emit TrayIconChanged(win); // trigger a repaint event
-    } else if (RunningApps.contains(win)) {
-        WindowPropertyEvent();
     }
+    // NOTE: Moving/resizing an application window does not change anything in the window model
 }
 
-void LSession::WindowDamageEvent(WId win)
+void LSession::WindowDamageEvent(WId win, QRect area)
 {
     if (TrayStopping) { return; }
     if (RunningTrayApps.contains(win)) {
-        qDebug() << "SysTray: Damage Event";
-        emit TrayIconChanged(win); // trigger a repaint event
+        emit TrayIconDamaged(win, area); // only that part of the icon needs to be re-read
     }
 }
 
@@ -979,10 +1075,7 @@ void LSession::unregisterVisualTray(WId visualTray)
 QList<WId> LSession::currentTrayApps(WId visualTray)
 {
     if (visualTray==VisualTrayID) {
-        // Check the validity of all the current tray apps (make sure nothing closed erratically)
-        for (int i=0; i<RunningTrayApps.length(); i++) {
-            if (XCB->WindowClass(RunningTrayApps[i]).isEmpty()) { RunningTrayApps.removeAt(i); i--; }
-        }
+        // Dead tray apps are already dropped by the X events (DestroyNotify/BadWindow)
         return RunningTrayApps;
     }
     else if (registerVisualTray(visualTray)) {
@@ -1040,6 +1133,9 @@ void LSession::attachTrayWindow(WId win)
     if (TrayStopping) { return; }
     if (RunningTrayApps.contains(win)) { return; } // already managed
     qDebug() << "Session Tray: Window Added";
+    // Watch the structure of the window right away (DestroyNotify even before it gets embedded)
+    // - a window which is already gone comes back as a BadWindow error instead
+    XCB->SelectInput(win, true);
     RunningTrayApps << win;
     qDebug() << "Tray List Changed";
     emit TrayListChanged();
@@ -80,6 +80,8 @@
 #include "LuminaX11.h"
 //#include "LuminaSingleApplication.h"
 #include "LIconCache.h"
+#include "LWindowModel.h"
+#include "org.dracolinux.Power.Client.h"
 
 // SYSTEM TRAY STANDARD DEFINITIONS
 #define SYSTEM_TRAY_REQUEST_DOCK 0
@@ -111,10 +113,15 @@ public:
     void RootSizeChange();
     void WindowPropertyEvent();
     void WindowPropertyEvent(WId);
+    void WindowPropertyEvent(WId, xcb_atom_t);
+    void ClientListEvent();
+    void WorkspaceEvent();
+    void ActiveWindowEvent();
     void SysTrayDockRequest(WId);
     void WindowClosedEvent(WId);
+    void WindowInvalidEvent(WId); // BadWindow error for this window
     void WindowConfigureEvent(WId);
-    void WindowDamageEvent(WId);
+    void WindowDamageEvent(WId win, QRect area);
     void WindowSelectionClearEvent(WId);
 
     // System Access
@@ -134,6 +141,7 @@ public:
     //SettingsMenu* settingsMenu();
 
     LXCB *XCB; //class for XCB usage
+    LWindowModel* windowModel(); // cached state of all the application windows
 
     QSettings* sessionSettings();
     QSettings* DesktopPluginSettings();
@@ -147,12 +155,14 @@ public:
     // REMOVE?
     // Window Adjustment Routine (due to Fluxbox not respecting _NET_WM_STRUT)
     void adjustWindowGeom(WId win, bool maximize = false);
+    void adjustWindowGeom(const LXCB::window_geometry &info, bool maximize = false); // geometry already known
 
 private:
     // WMProcess *WM;
     QList<LDesktop*> DESKTOPS;
     QFileSystemWatcher *watcher;
     QTimer *screenTimer;
+    QTimer *geomTimer; // new window geometry checks (one batched pass per tick)
     QRect screenRect;
     bool xchange; //flag for when the x11 session was adjusted
 
@@ -176,7 +186,7 @@ private:
 
     // Task Manager Variables
     WId lastActiveWin;
-    QList<WId> RunningApps;
+    LWindowModel *winModel;
     QList<WId> checkWin;
     QFileInfoList desktopFiles;
 
@@ -187,6 +197,7 @@ private:
 
     //PowerKit *pm;
     QDBusInterface *pm;
+    PowerStateClient *power;
 
 public slots:
     void StartLogout();
@@ -205,10 +216,16 @@ private slots:
     void NewCommunication(QStringList);
     void launchStartupApps(); //used during initialization
     void watcherChange(QString);
+    void iconThemeSwitched(const QString &theme, const QStringList &changed);
     void screensChanged();
     void screenResized(int);
     void checkWindowGeoms();
 
+    // Window model
+    void windowAdded(WId);
+    void windowRemoved(WId);
+    void windowWorkspaceChanged();
+
     // System Tray Functions
     void startSystemTray();
     void stopSystemTray(bool detachall = false);
@@ -217,6 +234,7 @@ private slots:
 
     // Internal simplification functions
     void refreshWindowManager();
+    void syncGtkConf();
     void updateDesktops();
     void registerDesktopWindows();
 
@@ -231,24 +249,25 @@ signals:
     void VisualTrayAvailable(); //new Visual Tray Plugin can be registered
     void TrayListChanged(); //Item added/removed from the list
     void TrayIconChanged(WId); //WinID of Tray App
+    void TrayIconDamaged(WId, QRect); //only this area of the Tray App changed
 
     // Start Button signals
     void StartButtonAvailable();
     void StartButtonActivated();
 
     // Task Manager Signals
-    void WindowListEvent(WId);
-    void WindowListEvent();
+    void WindowListEvent(); // windows added/removed (per-window changes: windowModel()->WindowChanged())
 
     // General Signals
     void LocaleChanged();
-    void IconThemeChanged();
+    void IconThemeChanged(); // style change, or an icon theme switch that changed icons in use
     void DesktopConfigChanged();
     void SessionConfigChanged();
     void FavoritesChanged();
     void DesktopFilesChanged();
     void MediaFilesChanged();
     void WorkspaceChanged();
+    void PowerStateChanged();
 };
 
 #endif
@@ -12,10 +12,12 @@
 #include "LSession.h"
 
 // Information Retrieval
-// Don't cache these results because they can change regularly
+// These come from the session window model when it knows the window (no round trips)
 QString  LWinInfo::text()
 {
     if (window==0) { return ""; }
+    LWindowModel *model = LSession::handle()->windowModel();
+    if (model->contains(window)) { return model->info(window).text; }
     QString nm = LSession::handle()->XCB->WindowVisibleIconName(window);
     if (nm.simplified().isEmpty()) { nm = LSession::handle()->XCB->WindowIconName(window); }
     if (nm.simplified().isEmpty()) { nm = LSession::handle()->XCB->WindowVisibleName(window); }
@@ -27,11 +29,11 @@ QString  LWinInfo::text()
     return nm;
 }
 
-QIcon LWinInfo::icon(bool &noicon)
+QIcon LWinInfo::icon(bool &noicon, int size)
 {
     if (window==0) { noicon = true; return QIcon();}
     noicon = false;
-    QIcon ico = LSession::handle()->XCB->WindowIcon(window);
+    QIcon ico = LSession::handle()->XCB->WindowIcon(window, size);
     // Check for a null icon, and supply one if necessary
     if (ico.isNull()) { ico = LXDG::findIcon( this->Class().toLower(),""); }
     if (ico.isNull()) {ico = LXDG::findIcon("preferences-system-windows",""); noicon=true;}
@@ -40,6 +42,8 @@ QIcon LWinInfo::icon(bool &noicon)
 
 QString LWinInfo::Class()
 {
+    LWindowModel *model = LSession::handle()->windowModel();
+    if (model->contains(window)) { return model->info(window).rec.wclass; }
     return LSession::handle()->XCB->WindowClass(window);
 }
 
@@ -47,7 +51,9 @@ LXCB::WINDOWVISIBILITY LWinInfo::status(bool update)
 {
     if (window==0) { return LXCB::IGNORE; }
     if (update || cstate == LXCB::IGNORE) {
-        cstate = LSession::handle()->XCB->WindowState(window);
+        LWindowModel *model = LSession::handle()->windowModel();
+        if (model->contains(window)) { cstate = model->info(window).status; }
+        else { cstate = LSession::handle()->XCB->WindowState(window); }
     }
     return cstate;
 }
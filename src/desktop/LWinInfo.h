@@ -45,7 +45,7 @@ public:
     // Information Retrieval
     // Don't cache these results because they can change regularly
     QString  text();
-    QIcon icon(bool &noicon);
+    QIcon icon(bool &noicon, int size = 64); // window icon is cached by LXCB
     QString Class();
     LXCB::WINDOWVISIBILITY status(bool update = false);
 };
@@ -0,0 +1,259 @@
+/*
+#
+# Draco Desktop Environment <https://dracolinux.org>
+# Copyright (c) 2019, Ole-André Rodlie <ole.andre.rodlie@gmail.com>
+# All rights reserved.
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>
+#
+*/
+
+#include "LWindowModel.h"
+
+#include <QDebug>
+
+LWindowModel::LWindowModel(LXCB *xcb, QObject *parent)
+    : QObject(parent)
+    , XCB(xcb)
+    , seeded(false)
+    , wkspace(0)
+    , activeWin(0)
+{
+}
+
+QList<WId> LWindowModel::windows(bool rawlist)
+{
+    if (!seeded) { seed(); }
+    if (rawlist) { return ORDER; }
+    QList<WId> output;
+    for (int i=0; i<ORDER.length(); i++) {
+        if (WINDOWS[ORDER[i]].rec.desktop == wkspace) { output << ORDER[i]; }
+    }
+    return output;
+}
+
+bool LWindowModel::contains(WId win)
+{
+    if (!seeded) { seed(); }
+    return WINDOWS.contains(win);
+}
+
+window_data LWindowModel::info(WId win)
+{
+    if (!seeded) { seed(); }
+    return WINDOWS.value(win);
+}
+
+unsigned int LWindowModel::currentWorkspace()
+{
+    if (!seeded) { seed(); }
+    return wkspace;
+}
+
+WId LWindowModel::activeWindow()
+{
+    if (!seeded) { seed(); }
+    return activeWin;
+}
+
+void LWindowModel::clientListChanged()
+{
+    if (!seeded) { seed(); return; }
+    QList<WId> list = XCB->ClientList();
+    QSet<WId> current = list.toSet();
+
+    // Closed windows
+    QList<WId> removed;
+    for (int i=0; i<ORDER.length(); i++) {
+        if (!current.contains(ORDER[i])) { removed << ORDER[i]; }
+    }
+    IGNORED.intersect(current);
+
+    // New windows (only these get queried)
+    QList<WId> added;
+    for (int i=0; i<list.length(); i++) {
+        if (!WINDOWS.contains(list[i]) && !IGNORED.contains(list[i])) { added << list[i]; }
+    }
+    QList<window_data> data = fetch(added);
+    for (int i=0; i<data.length(); i++) {
+        if (IGNORED.contains(data[i].rec.id)) { added.removeAll(data[i].rec.id); }
+        else { WINDOWS.insert(data[i].rec.id, data[i]); }
+    }
+    for (int i=0; i<removed.length(); i++) { WINDOWS.remove(removed[i]); }
+
+    // Keep the stacking order from the WM
+    ORDER.clear();
+    for (int i=0; i<list.length(); i++) {
+        if (WINDOWS.contains(list[i])) { ORDER << list[i]; }
+    }
+
+    for (int i=0; i<removed.length(); i++) { emit WindowRemoved(removed[i]); }
+    for (int i=0; i<added.length(); i++) { emit WindowAdded(added[i]); }
+}
+
+void LWindowModel::propertyChanged(WId win, xcb_atom_t atom)
+{
+    if (!seeded) { seed(); return; }
+    if (!WINDOWS.contains(win)) { return; }
+    window_data data = WINDOWS.value(win);
+    int props = 0;
+    if (atom == XCB_ATOM_NONE) {
+        QList<window_data> fresh = fetch(QList<WId>() << win);
+        if (fresh.isEmpty()) { return; }
+        data = fresh.first();
+        props = LWindowModel::ICON; // no way to tell - assume the icon changed as well
+    } else if (atom == XCB->EWMH._NET_WM_NAME ||
+               atom == XCB->EWMH._NET_WM_VISIBLE_NAME ||
+               atom == XCB->EWMH._NET_WM_ICON_NAME ||
+               atom == XCB->EWMH._NET_WM_VISIBLE_ICON_NAME ||
+               atom == XCB_ATOM_WM_NAME ||
+               atom == XCB_ATOM_WM_ICON_NAME)
+    {
+        data.text = XCB->WindowTitles(QList<WId>() << win).value(0);
+    } else if (atom == XCB->EWMH._NET_WM_ICON) {
+        props = LWindowModel::ICON; // LXCB drops the cached icon itself
+    } else if (atom == XCB->EWMH._NET_WM_STATE ||
+               atom == XCB->EWMH._NET_WM_DESKTOP ||
+               atom == XCB->EWMH._NET_WM_WINDOW_TYPE ||
+               atom == XCB_ATOM_WM_CLASS)
+    {
+        QList<LXCB::window_record> recs = XCB->WindowRecords(QList<WId>() << win);
+        if (recs.isEmpty()) { return; }
+        data.rec = recs.first();
+    } else {
+        return; // not something the model keeps track of
+    }
+    update(data, props);
+}
+
+void LWindowModel::workspaceChanged()
+{
+    if (!seeded) { seed(); return; }
+    unsigned int wk = XCB->CurrentWorkspace();
+    if (wk == wkspace) { return; }
+    wkspace = wk;
+    // Sticky windows follow the current workspace
+    QList<WId> wins = WINDOWS.keys();
+    for (int i=0; i<wins.length(); i++) {
+        if (WINDOWS[wins[i]].rec.states.contains(LXCB::S_STICKY)) { WINDOWS[wins[i]].rec.desktop = wkspace; }
+        updateStatus(wins[i]); // only the windows which actually changed get reported
+    }
+    emit CurrentWorkspaceChanged(wkspace);
+}
+
+void LWindowModel::activeWindowChanged()
+{
+    if (!seeded) { seed(); return; }
+    WId old = activeWin;
+    activeWin = XCB->ActiveWindow();
+    if (old == activeWin) { return; }
+    updateStatus(old);
+    updateStatus(activeWin);
+}
+
+void LWindowModel::windowClosed(WId win)
+{
+    if (!WINDOWS.contains(win)) { IGNORED.remove(win); return; }
+    WINDOWS.remove(win);
+    ORDER.removeAll(win);
+    if (activeWin == win) { activeWin = 0; }
+    emit WindowRemoved(win);
+}
+
+void LWindowModel::refresh()
+{
+    if (!seeded) { seed(); return; }
+    clientListChanged();
+    unsigned int wk = XCB->CurrentWorkspace();
+    if (wk != wkspace) { wkspace = wk; emit CurrentWorkspaceChanged(wkspace); }
+    activeWin = XCB->ActiveWindow();
+    QList<window_data> data = fetch(ORDER);
+    for (int i=0; i<data.length(); i++) { update(data[i]); }
+}
+
+void LWindowModel::seed()
+{
+    seeded = true;
+    qDebug() << "Seed window model";
+    wkspace = XCB->CurrentWorkspace();
+    activeWin = XCB->ActiveWindow();
+    QList<window_data> data = fetch(XCB->ClientList());
+    for (int i=0; i<data.length(); i++) {
+        if (IGNORED.contains(data[i].rec.id)) { continue; }
+        ORDER << data[i].rec.id;
+        WINDOWS.insert(data[i].rec.id, data[i]);
+    }
+}
+
+QList<window_data> LWindowModel::fetch(QList<WId> wins)
+{
+    // Two batched requests for the whole list
+    QList<window_data> output;
+    if (wins.isEmpty()) { return output; }
+    QList<LXCB::window_record> recs = XCB->WindowRecords(wins);
+    QStringList titles = XCB->WindowTitles(wins);
+    QString deClass = QString("%1 Desktop Environment").arg(DESKTOP_APP_NAME);
+    for (int i=0; i<recs.length(); i++) {
+        if (recs[i].wclass == deClass) { IGNORED << recs[i].id; } // our own panels/desktops
+        window_data data;
+        data.rec = recs[i];
+        data.text = titles.value(i);
+        data.status = visibility(data);
+        output << data;
+    }
+    return output;
+}
+
+void LWindowModel::update(window_data data, int props)
+{
+    WId win = data.rec.id;
+    if (!WINDOWS.contains(win)) { return; }
+    data.status = visibility(data);
+    props |= compare(WINDOWS.value(win), data);
+    WINDOWS.insert(win, data);
+    if (props != 0) { emit WindowChanged(win, props); }
+}
+
+LXCB::WINDOWVISIBILITY LWindowModel::visibility(const window_data &data)
+{
+    // Same priorities as LXCB::WindowState(), without the round trips
+    if (data.rec.states.contains(LXCB::S_ATTENTION)) { return LXCB::ATTENTION; }
+    if (data.rec.states.contains(LXCB::S_HIDDEN)) { return LXCB::INVISIBLE; }
+    if (data.rec.id == activeWin) { return LXCB::ACTIVE; }
+    if (data.rec.desktop != wkspace) { return LXCB::INVISIBLE; }
+    return LXCB::VISIBLE;
+}
+
+int LWindowModel::compare(const window_data &before, const window_data &after)
+{
+    int props = 0;
+    if (before.text != after.text) { props |= LWindowModel::NAME; }
+    if (before.status != after.status || before.rec.states != after.rec.states) { props |= LWindowModel::STATE; }
+    if (before.rec.desktop != after.rec.desktop) { props |= (LWindowModel::DESKTOP | LWindowModel::LISTING); }
+    if (before.rec.wclass != after.rec.wclass) { props |= (LWindowModel::CLASS | LWindowModel::LISTING); }
+    if (before.rec.types != after.rec.types) { props |= (LWindowModel::TYPE | LWindowModel::LISTING); }
+    if (before.rec.states.contains(LXCB::S_SKIP_TASKBAR) != after.rec.states.contains(LXCB::S_SKIP_TASKBAR)) {
+        props |= LWindowModel::LISTING;
+    }
+    return props;
+}
+
+void LWindowModel::updateStatus(WId win)
+{
+    if (!WINDOWS.contains(win)) { return; }
+    LXCB::WINDOWVISIBILITY status = visibility(WINDOWS[win]);
+    if (status == WINDOWS[win].status) { return; }
+    WINDOWS[win].status = status;
+    emit WindowChanged(win, LWindowModel::STATE);
+}
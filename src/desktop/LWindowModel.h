@@ -0,0 +1,101 @@
+/*
+#
+# Draco Desktop Environment <https://dracolinux.org>
+# Copyright (c) 2019, Ole-André Rodlie <ole.andre.rodlie@gmail.com>
+# All rights reserved.
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>
+#
+*/
+
+#ifndef LWINDOWMODEL_H
+#define LWINDOWMODEL_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QSet>
+#include <QString>
+
+#include <LuminaX11.h>
+
+// Everything the session knows about a single window
+struct window_data
+{
+    LXCB::window_record rec; // id, class, desktop, states and types
+    QString text; // title (same order of preference as LWinInfo::text())
+    LXCB::WINDOWVISIBILITY status;
+};
+
+// Window model for the session
+// It is seeded once from X and then kept up to date from the X events
+// (_NET_CLIENT_LIST diffs and single property changes), so consumers
+// can read the window state without any round trips of their own.
+class LWindowModel : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Property
+    {
+        NAME = 0x1,
+        ICON = 0x2,
+        STATE = 0x4,
+        DESKTOP = 0x8,
+        CLASS = 0x10,
+        TYPE = 0x20,
+        LISTING = 0x40 // the window might need to be added to/removed from task lists
+    };
+
+    explicit LWindowModel(LXCB *xcb, QObject *parent = Q_NULLPTR);
+
+    // Window information
+    QList<WId> windows(bool rawlist = false); // _NET_CLIENT_LIST order (rawlist -> all workspaces)
+    bool contains(WId win);
+    window_data info(WId win);
+    unsigned int currentWorkspace();
+    WId activeWindow();
+
+    // Updates from the XCB event filter (through LSession)
+    void clientListChanged(); // _NET_CLIENT_LIST: diff against the known windows
+    void propertyChanged(WId win, xcb_atom_t atom); // XCB_ATOM_NONE -> re-read the whole window
+    void workspaceChanged(); // _NET_CURRENT_DESKTOP
+    void activeWindowChanged(); // _NET_ACTIVE_WINDOW
+    void windowClosed(WId win); // DestroyNotify
+    void refresh(); // re-read everything (for events without any details)
+
+private:
+    LXCB *XCB;
+    bool seeded;
+    QList<WId> ORDER; // _NET_CLIENT_LIST order (desktop windows excluded)
+    QHash<WId, window_data> WINDOWS;
+    QSet<WId> IGNORED; // our own desktop windows
+    unsigned int wkspace;
+    WId activeWin;
+
+    void seed();
+    QList<window_data> fetch(QList<WId> wins);
+    void update(window_data data, int props = 0);
+    LXCB::WINDOWVISIBILITY visibility(const window_data &data);
+    int compare(const window_data &before, const window_data &after);
+    void updateStatus(WId win);
+
+signals:
+    void WindowAdded(WId);
+    void WindowRemoved(WId);
+    void WindowChanged(WId, int); // LWindowModel::Property flags
+    void CurrentWorkspaceChanged(unsigned int);
+};
+
+#endif // LWINDOWMODEL_H
@@ -13,12 +13,19 @@
 //    session->XCB->(do something)
 #include <LuminaX11.h>
 #include <QDebug>
+#include <QGuiApplication>
+#include <QScreen>
 
-XCBEventFilter::XCBEventFilter(LSession *sessionhandle) : QAbstractNativeEventFilter()
+XCBEventFilter::XCBEventFilter(LSession *sessionhandle) : QObject(sessionhandle), QAbstractNativeEventFilter()
 {
     session = sessionhandle; // save this for interaction with the session later
     TrayDmgFlag = 0;
     stopping = false;
+    dirtyRootSize = dirtyClientList = dirtyWorkspace = dirtyActive = false;
+    flushTimer = new QTimer(this);
+    flushTimer->setSingleShot(true);
+    connect(flushTimer, SIGNAL(timeout()), this, SLOT(flushEvents()));
+    setCoalesceInterval(0);
     session->XCB->SelectInput(QX11Info::appRootWindow()); // make sure we get root window events
     InitAtoms();
 }
@@ -26,7 +33,67 @@ XCBEventFilter::XCBEventFilter(LSession *sessionhandle) : QAbstractNativeEventFi
 void XCBEventFilter::setTrayDamageFlag(int flag)
 {
     // Special flag for system tray damage events
-    TrayDmgFlag = flag + XCB_DAMAGE_NOTIFY; // save the whole flag (no calculations later)
+    if (flag == 0) { TrayDmgFlag = 0; return; }
+    // Damage events are numbered from the extension's first event (not the damage ID)
+    const xcb_query_extension_reply_t *ext = xcb_get_extension_data(QX11Info::connection(), &xcb_damage_id);
+    if (ext == 0 || !ext->present) { TrayDmgFlag = 0; return; }
+    TrayDmgFlag = ext->first_event + XCB_DAMAGE_NOTIFY; // save the whole flag (no calculations later)
+}
+
+void XCBEventFilter::setCoalesceInterval(int ms)
+{
+    if (ms < 1) {
+        // One frame of the primary screen
+        qreal rate = 60;
+        if (QGuiApplication::primaryScreen() && QGuiApplication::primaryScreen()->refreshRate() > 1) {
+            rate = QGuiApplication::primaryScreen()->refreshRate();
+        }
+        ms = qMax(1, qRound(1000/rate));
+    }
+    flushTimer->setInterval(ms);
+}
+
+void XCBEventFilter::scheduleFlush()
+{
+    // Not restarted while running - the first event of a burst sets the deadline
+    if (!flushTimer->isActive()) { flushTimer->start(); }
+}
+
+void XCBEventFilter::dropDirty(WId win)
+{
+    dirtyProps.remove(win);
+    dirtyConfigure.removeAll(win);
+    dirtyDamage.remove(win);
+}
+
+void XCBEventFilter::flushEvents()
+{
+    if (stopping) { return; }
+    // Root window changes first (the window list might change)
+    if (dirtyRootSize) { dirtyRootSize = false; session->RootSizeChange(); }
+    if (dirtyClientList) { dirtyClientList = false; session->ClientListEvent(); }
+    if (dirtyWorkspace) {
+        dirtyWorkspace = false;
+        session->emit WorkspaceChanged();
+        session->WorkspaceEvent(); // some windows are now hidden
+    }
+    if (dirtyActive) { dirtyActive = false; session->ActiveWindowEvent(); }
+    // Now the single windows
+    QHash<WId, QList<xcb_atom_t> > props = dirtyProps;
+    dirtyProps.clear();
+    QHash<WId, QList<xcb_atom_t> >::const_iterator it = props.constBegin();
+    for (; it != props.constEnd(); ++it) {
+        for (int i=0; i<it.value().length(); i++) {
+            session->WindowPropertyEvent(it.key(), it.value()[i]);
+        }
+    }
+    QList<WId> wins = dirtyConfigure;
+    dirtyConfigure.clear();
+    for (int i=0; i<wins.length(); i++) { session->WindowConfigureEvent(wins[i]); }
+    QHash<WId, QRect> damage = dirtyDamage;
+    dirtyDamage.clear();
+    QHash<WId, QRect>::const_iterator dit = damage.constBegin();
+    for (; dit != damage.constEnd(); ++dit) { session->WindowDamageEvent(dit.key(), dit.value()); }
 }
 
 // This function format taken directly from the Qt5.3 documentation
@@ -38,32 +105,42 @@ bool XCBEventFilter::nativeEventFilter(const QByteArray &eventType, void *messag
 	  //qDebug() << " - XCB event";
 	  //Convert to known event type (for X11 systems)
 	   xcb_generic_event_t *ev = static_cast<xcb_generic_event_t *>(message);
-	  //Now parse the event and emit signals as necessary
+	  //Now parse the event and mark things as dirty (or handle them right away if the order matters)
 	  switch( ev->response_type & ~0x80){
 //==============================
 	    case XCB_PROPERTY_NOTIFY:
 		//qDebug() << "Property Notify Event:";
 	        //qDebug() << " - Root Window:" << QX11Info::appRootWindow();
 		//qDebug() << " - Given Window:" << ((xcb_property_notify_event_t*)ev)->window;
+		//Drop the cached value right away (before anything reads it again)
+		session->XCB->PropertyChanged( ((xcb_property_notify_event_t*)ev)->window, ((xcb_property_notify_event_t*)ev)->atom );
 		//System-specific property change
 		if( ((xcb_property_notify_event_t*)ev)->window == QX11Info::appRootWindow() \
 			&& ( ( ((xcb_property_notify_event_t*)ev)->atom == session->XCB->EWMH._NET_DESKTOP_GEOMETRY) \
 			  ||  (((xcb_property_notify_event_t*)ev)->atom == session->XCB->EWMH._NET_WORKAREA) )){
-		  session->RootSizeChange();
+		  dirtyRootSize = true;
+		  scheduleFlush();
 		}else if( ((xcb_property_notify_event_t*)ev)->window == QX11Info::appRootWindow() \
 			&& ( ( ((xcb_property_notify_event_t*)ev)->atom == session->XCB->EWMH._NET_CURRENT_DESKTOP) )){
  		  //qDebug() << "Got Workspace Change";
-		  session->emit WorkspaceChanged();
-		  session->WindowPropertyEvent(); //make sure we update the lists again - some windows are now hidden
-		}else if( SysNotifyAtoms.contains( ((xcb_property_notify_event_t*)ev)->atom ) ){
-		  //Update the status/list of all running windows
-		  session->WindowPropertyEvent();
+		  dirtyWorkspace = true;
+		  scheduleFlush();
+		}else if( ((xcb_property_notify_event_t*)ev)->window == QX11Info::appRootWindow() \
+			&& ( ( ((xcb_property_notify_event_t*)ev)->atom == session->XCB->EWMH._NET_ACTIVE_WINDOW) )){
+		  dirtyActive = true;
+		  scheduleFlush();
+		}else if( ((xcb_property_notify_event_t*)ev)->window == QX11Info::appRootWindow() \
+			&& SysNotifyAtoms.contains( ((xcb_property_notify_event_t*)ev)->atom ) ){
+		  //Windows opened/closed - the list gets diffed
+		  dirtyClientList = true;
+		  scheduleFlush();
 
 		//window-specific property change
 		}else if( WinNotifyAtoms.contains( ((xcb_property_notify_event_t*)ev)->atom ) ){
-		  //Ping only that window
-		  //session->WindowPropertyEvent( ((xcb_property_notify_event_t*)ev)->window );
-		  session->WindowPropertyEvent();
+		  //Ping only that window (and only for that property)
+		  QList<xcb_atom_t> &atoms = dirtyProps[ ((xcb_property_notify_event_t*)ev)->window ];
+		  if( !atoms.contains( ((xcb_property_notify_event_t*)ev)->atom ) ){ atoms << ((xcb_property_notify_event_t*)ev)->atom; }
+		  scheduleFlush();
 	        }
 		break;
 //==============================
@@ -85,21 +162,31 @@ bool XCBEventFilter::nativeEventFilter(const QByteArray &eventType, void *messag
 		    session->adjustWindowGeom( ((xcb_client_message_event_t*)ev)->window );
 		  }
 		  session->WindowPropertyEvent( ((xcb_client_message_event_t*)ev)->window );*/
-		}else if( WinNotifyAtoms.contains( ((xcb_client_message_event_t*)ev)->type ) ){
-		  //Ping only that window
-		  //session->WindowPropertyEvent( ((xcb_client_message_event_t*)ev)->window );
-		  session->WindowPropertyEvent();
-	        }
+		}
+		//NOTE: Other client messages are requests to the WM, the PropertyNotify for the
+		//  resulting change is what updates the window
 	        break;
 //==============================
 	    case XCB_DESTROY_NOTIFY:
 		//qDebug() << "Window Closed Event";
+		dropDirty( ( (xcb_destroy_notify_event_t*)ev )->window ); //nothing left to update
+		session->XCB->ForgetWindow( ( (xcb_destroy_notify_event_t*)ev )->window ); //cached properties/icon
 		session->WindowClosedEvent( ( (xcb_destroy_notify_event_t*)ev )->window );
 	        break;
+//==============================
+	    case 0: //error
+		if( ((xcb_generic_error_t*)ev)->error_code == XCB_WINDOW ){
+		  //Request on a window which is already gone (tray apps which died before being watched)
+		  session->WindowInvalidEvent( ((xcb_generic_error_t*)ev)->resource_id );
+		}
+	        break;
 //==============================
 	    case XCB_CONFIGURE_NOTIFY:
 		//qDebug() << "Configure Notify Event";
-		session->WindowConfigureEvent( ((xcb_configure_notify_event_t*)ev)->window );
+		if( !dirtyConfigure.contains( ((xcb_configure_notify_event_t*)ev)->window ) ){
+		  dirtyConfigure << ((xcb_configure_notify_event_t*)ev)->window;
+		}
+		scheduleFlush();
 	        break;
 //==============================
 	    case XCB_SELECTION_CLEAR:
@@ -108,10 +195,11 @@ bool XCBEventFilter::nativeEventFilter(const QByteArray &eventType, void *messag
 	        break;
 //==============================
 	    default:
-		if(TrayDmgFlag!=0){
-		  //if( (ev->response_type & ~0x80)==TrayDmgFlag){
-		    session->WindowDamageEvent( ((xcb_damage_notify_event_t*)ev)->drawable );
-		  //}
+		if(TrayDmgFlag!=0 && (ev->response_type & ~0x80)==TrayDmgFlag){
+		  xcb_damage_notify_event_t *dev = (xcb_damage_notify_event_t*)ev;
+		  QRect area(dev->area.x, dev->area.y, dev->area.width, dev->area.height);
+		  dirtyDamage.insert(dev->drawable, dirtyDamage.value(dev->drawable).united(area) ); //only re-read the damaged area
+		  scheduleFlush();
 		}/*else{
 	          qDebug() << "Default Event:" << (ev->response_type & ~0x80);
 	        }*/
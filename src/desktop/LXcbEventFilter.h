@@ -11,6 +11,9 @@
 #define DESKTOP_XCB_FILTER_H
 
 #include <QAbstractNativeEventFilter>
+#include <QObject>
+#include <QTimer>
+#include <QHash>
 #include <QList>
 #include <QStringList>
 #include <QX11Info>
@@ -55,8 +58,10 @@ XCB_CLIENT_MESSAGE
 #define SYSTEM_TRAY_BEGIN_MESSAGE 1
 #define SYSTEM_TRAY_CANCEL_MESSAGE 2
 
-class XCBEventFilter : public QAbstractNativeEventFilter
+class XCBEventFilter : public QObject, public QAbstractNativeEventFilter
 {
+    Q_OBJECT
+
 private:
     LSession *session;
     xcb_atom_t _NET_SYSTEM_TRAY_OPCODE;
@@ -64,26 +69,40 @@ private:
     int TrayDmgFlag; // internal damage event offset value for the system tray
     bool stopping;
 
+    // Event coalescing
+    // Bursts of events only mark things as dirty, the session gets
+    // the updates at most once per display frame (or the set interval)
+    QTimer *flushTimer;
+    QHash<WId, QList<xcb_atom_t> > dirtyProps; // window -> changed properties
+    QList<WId> dirtyConfigure;
+    QHash<WId, QRect> dirtyDamage; // window -> damaged area (united)
+    bool dirtyRootSize, dirtyClientList, dirtyWorkspace, dirtyActive;
+
+    void scheduleFlush();
+    void dropDirty(WId win); // window is gone
+
     void InitAtoms()
     {
         // Initialize any special atoms that we need to save/use regularly
         // NOTE: All the EWMH atoms are already saved in session->XCB->EWMH
+        // Per-window properties (routed to that window only)
         WinNotifyAtoms.clear();
         WinNotifyAtoms << session->XCB->EWMH._NET_WM_NAME \
         << session->XCB->EWMH._NET_WM_VISIBLE_NAME \
         << session->XCB->EWMH._NET_WM_ICON_NAME \
         << session->XCB->EWMH._NET_WM_VISIBLE_ICON_NAME \
         << session->XCB->EWMH._NET_WM_ICON \
-        << session->XCB->EWMH._NET_WM_ICON_GEOMETRY;
+        << session->XCB->EWMH._NET_WM_STATE \
+        << session->XCB->EWMH._NET_WM_DESKTOP \
+        << session->XCB->EWMH._NET_WM_WINDOW_TYPE \
+        << XCB_ATOM_WM_NAME \
+        << XCB_ATOM_WM_ICON_NAME \
+        << XCB_ATOM_WM_CLASS;
 
+        // Root window properties for the list of windows
+        // (_NET_CLIENT_LIST_STACKING is skipped, raising a window does not change the list)
         SysNotifyAtoms.clear();
-        SysNotifyAtoms << session->XCB->EWMH._NET_CLIENT_LIST \
-        << session->XCB->EWMH._NET_CLIENT_LIST_STACKING \
-        << session->XCB->EWMH._NET_CURRENT_DESKTOP \
-        << session->XCB->EWMH._NET_WM_STATE \
-        << session->XCB->EWMH._NET_ACTIVE_WINDOW \
-        << session->XCB->EWMH._NET_WM_ICON \
-        << session->XCB->EWMH._NET_WM_ICON_GEOMETRY;
+        SysNotifyAtoms << session->XCB->EWMH._NET_CLIENT_LIST;
         //_NET_SYSTEM_TRAY_OPCODE
         xcb_intern_atom_cookie_t cookie = xcb_intern_atom(QX11Info::connection(), 0, 23,"_NET_SYSTEM_TRAY_OPCODE");
         xcb_intern_atom_reply_t *r = xcb_intern_atom_reply(QX11Info::connection(), cookie, Q_NULLPTR);
@@ -96,10 +115,14 @@ private:
 public:
     XCBEventFilter(LSession *sessionhandle);
     void setTrayDamageFlag(int flag);
-    void StopEventHandling(){ stopping = true; }
+    void StopEventHandling(){ stopping = true; flushTimer->stop(); }
+    void setCoalesceInterval(int ms); // 0 -> one display frame
 
     // This function format taken directly from the Qt5.3 documentation
     virtual bool nativeEventFilter(const QByteArray &eventType, void *message, long *) Q_DECL_OVERRIDE;
+
+private slots:
+    void flushEvents();
 };
 
 #endif
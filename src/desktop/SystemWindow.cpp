@@ -52,6 +52,7 @@
 #include "ui_SystemWindow.h"
 
 #include "LSession.h"
+#include <LIconCache.h>
 #include <QPoint>
 #include <QCursor>
 #include <QDebug>
@@ -59,20 +60,22 @@
 #include <QDesktopWidget>
 #include <QMessageBox>
 
+extern LIconCache *ICONS;
+
 SystemWindow::SystemWindow() : QDialog(), ui(new Ui::SystemWindow)
 {
     ui->setupUi(this); // load the designer file
     this->setObjectName("LeaveDialog");
     // Setup the window flags
     this->setWindowFlags( Qt::Tool | Qt::FramelessWindowHint | Qt::WindowStaysOnTopHint);
-    // Setup the icons based on the current theme
-    ui->tool_logout->setIcon( LXDG::findIcon("system-log-out","") );
-    ui->tool_restart->setIcon( LXDG::findIcon("system-reboot","") );
-    ui->tool_shutdown->setIcon( LXDG::findIcon("system-shutdown","") );
-    ui->tool_suspend->setIcon( LXDG::findIcon("system-suspend","") );
-    ui->push_cancel->setIcon( LXDG::findIcon("system-cancel","dialog-cancel") );
-    ui->push_lock->setIcon( LXDG::findIcon("system-lock-screen","") );
-    ui->tool_hibernate->setIcon(LXDG::findIcon("system-hibernate"));
+    // Setup the icons based on the current theme (the icon cache updates them on theme switches)
+    ICONS->applyIcon(ui->tool_logout, "system-log-out");
+    ICONS->applyIcon(ui->tool_restart, "system-reboot");
+    ICONS->applyIcon(ui->tool_shutdown, "system-shutdown");
+    ICONS->applyIcon(ui->tool_suspend, "system-suspend");
+    ICONS->applyIcon(ui->push_cancel, "system-cancel", "dialog-cancel");
+    ICONS->applyIcon(ui->push_lock, "system-lock-screen");
+    ICONS->applyIcon(ui->tool_hibernate, "system-hibernate");
     // Connect the signals/slots
     connect(ui->tool_logout, SIGNAL(clicked()), this, SLOT(sysLogout()) );
     connect(ui->tool_restart, SIGNAL(clicked()), this, SLOT(sysRestart()) );
@@ -85,7 +88,7 @@ SystemWindow::SystemWindow() : QDialog(), ui(new Ui::SystemWindow)
     updateWindow();
     //ui->tool_suspend->setVisible(LSession::handle()->canSuspend());
     connect(QApplication::instance(), SIGNAL(LocaleChanged()), this, SLOT(updateWindow()) );
-    connect(QApplication::instance(), SIGNAL(IconThemeChanged()), this, SLOT(updateWindow()) );
+    connect(QApplication::instance(), SIGNAL(PowerStateChanged()), this, SLOT(updatePowerActions()) );
 }
 
 SystemWindow::~SystemWindow()
@@ -96,16 +99,21 @@ void SystemWindow::updateWindow()
 {
     //ui->retranslateUi(this);
 
-    ui->tool_suspend->setEnabled(LSession::handle()->canSuspend());
-    ui->tool_hibernate->setEnabled(LSession::handle()->canHibernate());
-    ui->tool_restart->setEnabled(LSession::handle()->canReboot());
-    ui->tool_shutdown->setEnabled(LSession::handle()->canShutdown());
+    updatePowerActions();
 
     // Center this window on the current screen
     QPoint center = QApplication::desktop()->screenGeometry(QCursor::pos()).center(); // get the center of the current screen
     this->move(center.x() - this->width()/2, center.y() - this->height()/2);
 }
 
+void SystemWindow::updatePowerActions()
+{
+    ui->tool_suspend->setEnabled(LSession::handle()->canSuspend());
+    ui->tool_hibernate->setEnabled(LSession::handle()->canHibernate());
+    ui->tool_restart->setEnabled(LSession::handle()->canReboot());
+    ui->tool_shutdown->setEnabled(LSession::handle()->canShutdown());
+}
+
 void SystemWindow::sysLogout()
 {
     if (!msgDialog(tr("Logout?"),
@@ -69,6 +69,7 @@ class SystemWindow : public QDialog
 
     public slots:
     void updateWindow();
+    void updatePowerActions();
 
     private:
     Ui::SystemWindow *ui;
@@ -57,6 +57,9 @@
 
 #include "LSession.h"
 #include <LuminaXDG.h>
+#include <LIconCache.h>
+
+extern LIconCache *ICONS;
 
 LDPlugin::LDPlugin(QWidget *parent, QString id) : QFrame(parent){
   PLUGID=id;
@@ -84,18 +87,18 @@ LDPlugin::LDPlugin(QWidget *parent, QString id) : QFrame(parent){
 void LDPlugin::setupMenu(){
   menu->clear();
   menu->setTitle(tr("Modify Item"));
-  menu->setIcon(LXDG::findIcon("preferences-desktop-icons","") );
+  ICONS->applyIcon(menu, "preferences-desktop-icons"); //kept up to date on icon theme switches
   //SPECIAL CONTEXT MENU OPTIONS FOR PARTICULAR PLUGIN TYPES
   /*if(PLUGID.startsWith("applauncher::")){
     menu->addAction( LXDG::findIcon("quickopen",""), tr("Launch Item"), this, SIGNAL(PluginActivated()) );
     menu->addSeparator();
   }*/
   //General Options
-  menu->addAction( LXDG::findIcon("transform-move",""), tr("Start Moving Item"), this, SLOT(slotStartMove()) );
-  menu->addAction( LXDG::findIcon("transform-scale",""), tr("Start Resizing Item"), this, SLOT(slotStartResize()) );
+  ICONS->applyIcon( menu->addAction(tr("Start Moving Item"), this, SLOT(slotStartMove())), "transform-move");
+  ICONS->applyIcon( menu->addAction(tr("Start Resizing Item"), this, SLOT(slotStartResize())), "transform-scale");
   menu->addSeparator();
-  menu->addAction( LXDG::findIcon("zoom-in",""), tr("Increase Item Sizes"), this, SIGNAL(IncreaseIconSize()) );
-  menu->addAction( LXDG::findIcon("zoom-out",""), tr("Decrease Item Sizes"), this, SIGNAL(DecreaseIconSize()) );
+  ICONS->applyIcon( menu->addAction(tr("Increase Item Sizes"), this, SIGNAL(IncreaseIconSize())), "zoom-in");
+  ICONS->applyIcon( menu->addAction(tr("Decrease Item Sizes"), this, SIGNAL(DecreaseIconSize())), "zoom-out");
   //menu->addSeparator();
   //menu->addAction( LXDG::findIcon("edit-delete",""), tr("Remove Item"), this, SLOT(slotRemovePlugin()) );
 }
@@ -152,7 +152,7 @@ public slots:
 	virtual void ThemeChange(){
 	  //This needs to be re-implemented in the subclassed plugin
 	    //This is where all the visuals are set if using Theme-dependant icons.
-	  setupMenu();
+	    //NOTE: icons set through LIconCache::applyIcon() (like the plugin menu) are updated by the cache
 	}
 	void showPluginMenu();
 
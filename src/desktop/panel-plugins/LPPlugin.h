@@ -65,6 +65,8 @@ public slots:
 	virtual void ThemeChange(){
 	  //This needs to be re-implemented in the subclasses plugin
 	    //This is where all the visuals are set if using Theme-dependant icons.
+	    //NOTE: Only called if the icon theme switch changed icons in use, icons set through
+	    //  LIconCache::applyIcon() are updated by the cache and don't need to be set again here
 	}
     virtual void settingsChange(QSettings *settings, const QString &prefix) {
         Q_UNUSED(settings)
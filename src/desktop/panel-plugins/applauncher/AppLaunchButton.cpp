@@ -60,9 +60,12 @@
 #include <LUtils.h>
 #include <QInputDialog>
 #include <LFileInfo.h>
+#include <LIconCache.h>
 
 #include "draco.h"
 
+extern LIconCache *ICONS;
+
 AppLaunchButtonPlugin::AppLaunchButtonPlugin(QWidget *parent, QString id, bool horizontal) : LPPlugin(parent, id, horizontal){
   button = new QToolButton(this);
     button->setAutoRaise(true);
@@ -86,25 +89,19 @@ AppLaunchButtonPlugin::~AppLaunchButtonPlugin(){
 
 void AppLaunchButtonPlugin::updateButtonVisuals()
 {
-    QIcon icon;
     QString tooltip = tr("Click to assign an application");
     LFileInfo info(appfile);
     //qDebug() << "UPDATE BUTTON VISUALS" << appfile << info.iconfile() << info.isDesktopFile();
-    if (info.iconfile().isEmpty()) {
-        if (!info.XDG()->icon.isEmpty()) { icon = LXDG::findIcon(info.XDG()->icon, "application-x-executable"); }
-    } else {
-        icon = LXDG::findIcon(info.iconfile(), "application-x-executable");
-    }
+    QString icon = info.iconfile().isEmpty()?info.XDG()->icon:info.iconfile();
     if (info.isDesktopFile()) {
-        if (icon.isNull()) { icon = LXDG::findIcon("application-x-executable"); }
         tooltip = QString(tr("Launch %1")).arg(info.XDG()->name);
     } else if (info.exists()) {
-        if (icon.isNull()) { icon = LXDG::findIcon("application-x-executable"); }
         tooltip = QString(tr("Open %1")).arg(appfile.section("/",-1));
     } else {
-        icon =  LXDG::findIcon("task-attention", "application-x-executable");
+        icon = "task-attention";
     }
-    button->setIcon( icon );
+    if (icon.isEmpty()) { icon = "application-x-executable"; }
+    ICONS->applyIcon(button, icon, "application-x-executable"); // updated by the icon cache on theme switches
     button->setToolTip(tooltip);
 }
 
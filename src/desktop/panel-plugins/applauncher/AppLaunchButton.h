@@ -102,9 +102,7 @@ public slots:
 	void LocaleChange(){
 	  updateButtonVisuals();
 	}
-	void ThemeChange(){
-	  updateButtonVisuals();
-	}
+	//NOTE: no ThemeChange(), the icon cache updates the button icon
 protected:
 	void changeEvent(QEvent *ev){
 	  LPPlugin::changeEvent(ev);
@@ -57,8 +57,11 @@
 #include "LSession.h"
 
 #include <LuminaXDG.h>
+#include <LIconCache.h>
 #include "draco.h"
 
+extern LIconCache *ICONS;
+
 LAppMenuPlugin::LAppMenuPlugin(QWidget *parent, QString id, bool horizontal) : LPPlugin(parent, id, horizontal){
   button = new QToolButton(this);
     button->setAutoRaise(true);
@@ -87,7 +90,7 @@ LAppMenuPlugin::~LAppMenuPlugin(){
 
 void LAppMenuPlugin::updateButtonVisuals(){
     button->setToolTip( tr("Quickly launch applications or open files"));
-    button->setIcon(LXDG::findIcon("system-run"));
+    ICONS->applyIcon(button, "system-run");
     button->setText(showMenuText?tr("Applications"):"");
     button->setToolButtonStyle(showMenuText?Qt::ToolButtonTextBesideIcon:Qt::ToolButtonIconOnly);
 }
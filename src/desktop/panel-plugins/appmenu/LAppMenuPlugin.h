@@ -107,9 +107,7 @@ public slots:
 	}
 	
     void settingsChange(QSettings *settings, const QString &prefix);
-	void ThemeChange(){
-	  updateButtonVisuals();
-	}
+	//NOTE: no ThemeChange(), the icon cache updates the button icon
 };
 
 #endif
@@ -55,9 +55,12 @@
 //===========================================
 #include "LHomeButton.h"
 #include "LSession.h"
+#include <LIconCache.h>
 
 #include <LuminaX11.h>
 
+extern LIconCache *ICONS;
+
 LHomeButtonPlugin::LHomeButtonPlugin(QWidget *parent, QString id, bool horizontal) : LPPlugin(parent, id, horizontal){
   button = new QToolButton(this);
     button->setAutoRaise(true);
@@ -75,7 +78,7 @@ LHomeButtonPlugin::~LHomeButtonPlugin(){
 }
 
 void LHomeButtonPlugin::updateButtonVisuals(){
-  button->setIcon( LXDG::findIcon("user-desktop", "") );
+  ICONS->applyIcon(button, "user-desktop");
 }
 
 // ========================
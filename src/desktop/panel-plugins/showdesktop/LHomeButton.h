@@ -102,10 +102,7 @@ public slots:
 	void LocaleChange(){ 
 	  updateButtonVisuals();
 	}
-	
-	void ThemeChange(){
-	  updateButtonVisuals();
-	}
+	//NOTE: no ThemeChange(), the icon cache updates the button icon
 };
 
 #endif
@@ -28,6 +28,7 @@ LSysTray::LSysTray(QWidget *parent, QString id, bool horizontal) : LPPlugin(pare
   QTimer::singleShot(90000,this, SLOT(checkAll()) );
   connect(LSession::handle(), SIGNAL(TrayListChanged()), this, SLOT(checkAll()) );
   connect(LSession::handle(), SIGNAL(TrayIconChanged(WId)), this, SLOT(UpdateTrayWindow(WId)) );
+  connect(LSession::handle(), SIGNAL(TrayIconDamaged(WId, QRect)), this, SLOT(DamageTrayWindow(WId, QRect)) );
   connect(LSession::handle(), SIGNAL(VisualTrayAvailable()), this, SLOT(start()) );
 }
 
@@ -159,7 +160,7 @@ void LSysTray::UpdateTrayWindow(WId win){
   for(int i=0; i<trayIcons.length(); i++){
     if(trayIcons[i]->appID()==win){
       //qDebug() << "System Tray: Update Window " << win;
-      trayIcons[i]->repaint(); //don't use update() because we need an instant repaint (not a cached version)
+      trayIcons[i]->invalidate(); //drop the cached image - re-read the whole window
       return; //finished now
     }
   }
@@ -167,3 +168,14 @@ void LSysTray::UpdateTrayWindow(WId win){
   //qDebug() << "System Tray: Missing Window - check all";
   QTimer::singleShot(0,this, SLOT(checkAll()) );
 }
+
+void LSysTray::DamageTrayWindow(WId win, QRect area){
+  if(!isRunning || stopping || checking){ return; }
+  for(int i=0; i<trayIcons.length(); i++){
+    if(trayIcons[i]->appID()==win){
+      trayIcons[i]->damage(area); //only re-read the damaged part on the next paint
+      return;
+    }
+  }
+  QTimer::singleShot(0,this, SLOT(checkAll()) );
+}
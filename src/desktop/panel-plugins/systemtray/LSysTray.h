@@ -43,6 +43,7 @@ private:
 private slots:
 	void checkAll();
 	void UpdateTrayWindow(WId win);
+	void DamageTrayWindow(WId win, QRect area);
 
 	//void removeTrayIcon(WId win);
 
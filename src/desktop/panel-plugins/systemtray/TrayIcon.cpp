@@ -15,6 +15,7 @@ TrayIcon::TrayIcon(QWidget *parent) : QWidget(parent){
   IID = 0;
   dmgID = 0;
   badpaints = 0;
+  fullUpdate = true;
   if("1" == QString(getenv("QT_AUTO_SCREEN_SCALE_FACTOR")) ){
   scalefactor = 2; //Auto-adjust this later to the physicalDotsPerInch of the current screen
   }else{ scalefactor = 1; }
@@ -27,6 +28,8 @@ TrayIcon::~TrayIcon(){
 
 void TrayIcon::cleanup(){
   AID = IID = 0;
+  frame = QImage();
+  scaled = QPixmap();
 }
 
 WId TrayIcon::appID(){
@@ -73,6 +76,21 @@ void TrayIcon::detachApp(){
   LSession::handle()->XCB->UnembedWindow(tmp);
   //qDebug() << " - finished app:" << tmp;
   IID = 0;
+  frame = QImage();
+  scaled = QPixmap();
+}
+
+void TrayIcon::invalidate(){
+  if(AID==0){ return; }
+  LSession::handle()->XCB->ReleaseTrayImage(AID); //the window pixmap needs to be named again
+  fullUpdate = true;
+  this->update();
+}
+
+void TrayIcon::damage(QRect area){
+  if(AID==0){ return; }
+  dirty += area;
+  this->update();
 }
 
 // ==============
@@ -83,7 +101,35 @@ void TrayIcon::updateIcon(){
   //Make sure the icon is square
   QSize icosize = this->size();
   LSession::handle()->XCB->ResizeWindow(AID,  icosize.width()*scalefactor, icosize.height()*scalefactor);
-  QTimer::singleShot(500, this, SLOT(repaint()) ); //make sure to re-draw the window in a moment
+  QTimer::singleShot(500, this, SLOT(invalidate()) ); //make sure to re-draw the window in a moment
+}
+
+// =============
+//     PRIVATE
+// =============
+bool TrayIcon::updateFrame(){
+  if(!fullUpdate && dirty.isEmpty() && !frame.isNull()){ return true; } //nothing changed - use the cached image
+  LXCB *XCB = LSession::handle()->XCB;
+  if(fullUpdate || frame.isNull()){
+    frame = XCB->TrayImage(AID, QRect());
+    if(frame.isNull()){ frame = XCB->TrayImage(AID).toImage(); } //not redirected - screen grab
+  }else{
+    //Only read the damaged parts of the window
+    QPainter P(&frame);
+    P.setCompositionMode(QPainter::CompositionMode_Source);
+    QVector<QRect> rects = dirty.rects();
+    for(int i=0; i<rects.length(); i++){
+      QImage part = XCB->TrayImage(AID, rects[i]);
+      if(part.isNull()){ P.end(); fullUpdate = true; return updateFrame(); } //window changed - start over
+      P.drawImage(rects[i].topLeft(), part);
+    }
+  }
+  fullUpdate = false;
+  dirty = QRegion();
+  if(frame.isNull()){ scaled = QPixmap(); return false; }
+  //Scale once per change instead of on every paint
+  scaled = QPixmap::fromImage(frame.scaled(this->size().width()-4, this->size().height()-4, Qt::KeepAspectRatio, Qt::SmoothTransformation));
+  return true;
 }
 
 // =============
@@ -101,13 +147,10 @@ void TrayIcon::paintEvent(QPaintEvent *event){
 	//qDebug() << " - Draw tray:" << AID << IID << this->winId();
 	//qDebug() << " - - " << event->rect().x() << event->rect().y() << event->rect().width() << event->rect().height();
 	//qDebug() << " - Get image:" << AID;
-	QPixmap pix = LSession::handle()->XCB->TrayImage(AID); //= WIN->icon().pixmap(this->size());
-
-	//qDebug() << " - Pix size:" << pix.size().width() << pix.size().height();
 	//qDebug() << " - Geom:" << this->geometry().x() << this->geometry().y() << this->geometry().width() << this->geometry().height();
-	if(!pix.isNull()){
-	  if((this->size()*scalefactor) != pix.size()){ QTimer::singleShot(10, this, SLOT(updateIcon())); return; }
-      painter.drawPixmap(2,2,this->width()-4, this->height()-4, pix.scaled(this->size().width()-4, this->size().height()-4, Qt::KeepAspectRatio, Qt::SmoothTransformation) );
+	if(updateFrame()){
+	  if((this->size()*scalefactor) != frame.size()){ QTimer::singleShot(10, this, SLOT(updateIcon())); return; }
+      painter.drawPixmap(2,2,this->width()-4, this->height()-4, scaled);
 	  badpaints = 0; //good paint
 	}else{
 	  badpaints++;
@@ -126,6 +169,6 @@ void TrayIcon::resizeEvent(QResizeEvent *event){
   //qDebug() << "Resize Event:" << event->size().width() << event->size().height();
   if(AID!=0){
     LSession::handle()->XCB->ResizeWindow(AID,  event->size());
-    QTimer::singleShot(500, this, SLOT(update()) ); //make sure to re-draw the window in a moment
+    QTimer::singleShot(500, this, SLOT(invalidate()) ); //make sure to re-draw the window in a moment
   }
 }
@@ -20,6 +20,7 @@
 #include <QPainter>
 #include <QPixmap>
 #include <QImage>
+#include <QRegion>
 //#include <QWindow>
 // libLumina includes
 //#include <LuminaX11.h>
@@ -39,12 +40,20 @@ public:
 public slots:
 	void detachApp();
 	void updateIcon();
+	void invalidate(); //window changed (resized/remapped) - re-read everything on the next paint
+	void damage(QRect area); //only this area of the window changed
 
 private:
 	WId IID, AID; //icon ID and app ID
 	int badpaints;
 	uint dmgID;
 	int scalefactor;
+	QImage frame; //last known contents of the app window
+	QPixmap scaled; //frame scaled to the icon size (painted until the next damage)
+	QRegion dirty; //parts of the frame which need to be re-read
+	bool fullUpdate;
+
+	bool updateFrame(); //pull the dirty areas from the window (returns false on failure)
 
 protected:
 	void paintEvent(QPaintEvent *event);
@@ -71,6 +71,7 @@ LTaskButton::LTaskButton(QWidget *parent, bool smallDisplay) : LTBWidget(parent)
   this->setSizePolicy(QSizePolicy::Maximum, QSizePolicy::Maximum);
   winMenu->setContextMenuPolicy(Qt::CustomContextMenu);
   showText = true;
+  fullUpdate = false;
   connect(this, SIGNAL(customContextMenuRequested(const QPoint&)), this, SLOT(openActionMenu()) );
   connect(this, SIGNAL(clicked()), this, SLOT(buttonClicked()) );
   connect(winMenu, SIGNAL(customContextMenuRequested(const QPoint&)), this, SLOT(openActionMenu()) );
@@ -117,6 +118,13 @@ void LTaskButton::rmWindow(WId win){
   UpdateButton();
 }
 
+void LTaskButton::windowChanged(WId win, int props){
+  if(props & (LWindowModel::ICON | LWindowModel::CLASS)){
+    if(WINLIST.isEmpty() || WINLIST[0].windowID()==win){ fullUpdate = true; } //button visuals come from the first window
+  }
+  UpdateButton();
+}
+
 //==========
 //    PRIVATE
 //==========
@@ -134,8 +142,9 @@ LWinInfo LTaskButton::currentWindow(){
 
 void LTaskButton::UpdateButton(){
   if(winMenu->isVisible()){ return; } //skip this if the window menu is currently visible for now
-  bool statusOnly = (WINLIST.length() == LWINLIST.length());
+  bool statusOnly = (WINLIST.length() == LWINLIST.length()) && !fullUpdate;
   LWINLIST = WINLIST;
+  fullUpdate = false;
 
   winMenu->clear();
   LXCB::WINDOWVISIBILITY showstate = LXCB::IGNORE;
@@ -147,7 +156,7 @@ void LTaskButton::UpdateButton(){
     }
     if(i==0 && !statusOnly){
       //Update the button visuals from the first window
-      this->setIcon(WINLIST[i].icon(noicon));
+      this->setIcon(WINLIST[i].icon(noicon, this->iconSize().height()));
       cname = WINLIST[i].Class();
       if(cname.isEmpty()){
 	//Special case (chrome/chromium does not register *any* information with X except window title)
@@ -157,7 +166,7 @@ void LTaskButton::UpdateButton(){
       this->setToolTip(cname);
     }
     bool junk;
-    QAction *tmp = winMenu->addAction( WINLIST[i].icon(junk), WINLIST[i].text() );
+    QAction *tmp = winMenu->addAction( WINLIST[i].icon(junk, this->iconSize().height()), WINLIST[i].text() );
       tmp->setData(i); //save which number in the WINLIST this entry is for
     LXCB::WINDOWVISIBILITY stat = WINLIST[i].status(true); //update the saved state for the window
     if(stat<LXCB::ACTIVE && WINLIST[i].windowID() == LSession::handle()->activeWindow()){ stat = LXCB::ACTIVE; }
@@ -88,6 +88,7 @@ public:
 	//Window Management
 	void addWindow(WId win); //Add a window to this button
 	void rmWindow(WId win); //Remove a window from this button
+	void windowChanged(WId win, int props); //LWindowModel::Property flags for one of the windows
 
 private:
 	QList<LWinInfo> WINLIST;
@@ -97,6 +98,7 @@ private:
 	LWinInfo cWin;
 	QString cname; //class name for the entire button
 	bool noicon, showText;
+	bool fullUpdate; //icon/class changed - re-read them on the next update
 
 	LWinInfo currentWindow(); //For getting the currently-active window
 	LXCB::WINDOWVISIBILITY cstate; //current state of the button
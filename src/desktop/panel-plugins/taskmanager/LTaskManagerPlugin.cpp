@@ -66,7 +66,7 @@ LTaskManagerPlugin::LTaskManagerPlugin(QWidget *parent, QString id, bool horizon
   showText = true;
   if(id.contains("-nogroups")){ usegroups = false; }
   connect(LSession::handle(), SIGNAL(WindowListEvent()), this, SLOT(checkWindows()) );
-  connect(LSession::handle(), SIGNAL(WindowListEvent(WId)), this, SLOT(UpdateButton(WId)) );
+  connect(LSession::handle()->windowModel(), SIGNAL(WindowChanged(WId,int)), this, SLOT(UpdateButton(WId,int)) );
   this->layout()->setContentsMargins(0,0,0,0);
   QTimer::singleShot(0,this, SLOT(UpdateButtons()) ); //perform an initial sync
   //QTimer::singleShot(100,this, SLOT(OrientationChange()) ); //perform an initial sync
@@ -80,117 +80,80 @@ LTaskManagerPlugin::~LTaskManagerPlugin(){
 //    PRIVATE SLOTS
 //==============
 void LTaskManagerPlugin::UpdateButtons(){
-    qDebug() << "update task buttons";
-  updating = QDateTime::currentDateTime(); //global time stamp
-  QDateTime ctime = updating; //current thread time stamp
-
-  //Get the current window list
-  QList<WId> winlist = LSession::handle()->XCB->WindowList();
-  // Ignore the windows which don't want to be listed
-  for (int i = 0; i < winlist.length(); i++) {
-    QList<LXCB::WINDOWSTATE> states = LSession::handle()->XCB->WM_Get_Window_States(winlist[i]);
-    for (int j = 0; j < states.length(); j++) {
-      if (states[j] == LXCB::S_SKIP_TASKBAR) {
-        // Skip taskbar window
-        winlist.removeAt(i);
-        i--;
-        break;
-      }
-    }
+  //Diff the window model against the buttons: only the changed buttons get touched
+  LWindowModel *model = LSession::handle()->windowModel();
+  QList<WId> winlist = model->windows();
+  QHash<WId, QString> current; //window -> class for the windows which want to be listed
+  for(int i=0; i<winlist.length(); i++){
+    window_data data = model->info(winlist[i]);
+    if(data.rec.states.contains(LXCB::S_SKIP_TASKBAR)){ winlist.removeAt(i); i--; continue; }
+    current.insert(winlist[i], data.rec.wclass);
   }
-  //Do not change the status of the previously active window if it just changed to a non-visible window
-  //WId activeWin = LSession::handle()->XCB->ActiveWindow();
-  //bool skipActive = !winlist.contains(activeWin);
-  //qDebug() << "Update Buttons:" << winlist;
-  if(updating > ctime){ return; } //another thread kicked off already - stop this one
-  //Now go through all the current buttons first
-  for(int i=0; i<BUTTONS.length(); i++){
-
-      // show/hide text
-      BUTTONS[i]->setShowText(showText);
-    //Get the windows managed in this button
-    QList<WId> WI = BUTTONS[i]->windows();
-    bool updated=false;
-    if(updating > ctime){ return; } //another thread kicked off already - stop this one
-    //Loop over all the windows for this button
-    for(int w=0; w<WI.length(); w++){
-      if(updating > ctime){ return; } //another thread kicked off already - stop this one
-      if( winlist.contains( WI[w] ) ){
-        //Still current window - update it later
-	winlist.removeAll(WI[w] ); //remove this window from the list since it is done
-      }else{
-	//Window was closed - remove it
-	if(WI.length()==1){
-	  //Remove the entire button
-	  //qDebug() << "Window Closed: Remove Button" ;
-	  this->layout()->takeAt(i); //remove from the layout
-	  BUTTONS.takeAt(i)->deleteLater();
-	  i--;
-	  updated = true; //prevent updating a removed button
-	  break; //break out of the button->window loop
-	}else{
-      //qDebug() << "Window Closed: Remove from button:" << WI[w].windowID() << "Button:" << w;
-	  BUTTONS[i]->rmWindow(WI[w]); // one of the multiple windows for the button
-	  WI.removeAt(w); //remove this window from the list
-	  w--;
-	}
-	updated=true; //button already changed
-      }
-      if(updating > ctime){ return; } //another thread kicked off already - stop this one
-    }
-    if(!updated){
-      //qDebug() << "Update Button:" << i;
-      if(updating > ctime){ return; } //another thread kicked off already - stop this one
-      //if(!skipActive || !BUTTONS[i]->isActive()){
-        QTimer::singleShot(1,BUTTONS[i], SLOT(UpdateButton()) ); //keep moving on
-      //}
-    }
+  //Remove the windows which are gone (or moved to a different group)
+  QList<WId> known = CLASSES.keys();
+  for(int i=0; i<known.length(); i++){
+    if(current.contains(known[i]) && (!usegroups || current.value(known[i])==CLASSES.value(known[i])) ){ continue; }
+    removeWindow(known[i]);
   }
-  //Now go through the remaining windows
+  //Now add the new windows (in window list order)
   for(int i=0; i<winlist.length(); i++){
-    //New windows, create buttons for each (add grouping later)
-    if(updating > ctime){ return; } //another thread kicked off already - stop this one
-    //Check for a button that this can just be added to
-    QString ctxt = LSession::handle()->XCB->WindowClass(winlist[i]);
-    bool found = false;
+    if(CLASSES.contains(winlist[i])){ continue; }
+    addWindow(winlist[i], current.value(winlist[i]));
+  }
+}
+
+void LTaskManagerPlugin::addWindow(WId win, QString wclass){
+  CLASSES.insert(win, wclass);
+  //Check for a button that this can just be added to
+  if(usegroups){
     for(int b=0; b<BUTTONS.length(); b++){
-      if(updating > ctime){ return; } //another thread kicked off already - stop this one
-      if(BUTTONS[b]->classname()== ctxt && usegroups){
-	//This adds a window to an existing group
-        found = true;
-    //qDebug() << "Add Window to Button:" << b;
-	BUTTONS[b]->addWindow(winlist[i]);
-	break;
+      if(BUTTONS[b]->classname()== wclass){
+        BUTTONS[b]->addWindow(win);
+        return;
       }
     }
-    if(!found){
-      if(updating > ctime){ return; } //another thread kicked off already - stop this one
-      //No group, create a new button
-      //qDebug() << "New Button";
-      LTaskButton *but = new LTaskButton(this, usegroups);
-        but->addWindow( winlist[i] );
-	if(this->layout()->direction()==QBoxLayout::LeftToRight){
-	    but->setIconSize(QSize(this->height(), this->height()));
-        but->setToolButtonStyle(showText?Qt::ToolButtonTextBesideIcon:Qt::ToolButtonIconOnly);
-	}else{
-	    but->setIconSize(QSize(this->width(), this->width()));
-	    but->setToolButtonStyle(Qt::ToolButtonIconOnly);
-	}
-      this->layout()->addWidget(but);
-      connect(but, SIGNAL(MenuClosed()), this, SIGNAL(MenuClosed()));
-      BUTTONS << but;
-    }
   }
+  //No group, create a new button
+  LTaskButton *but = new LTaskButton(this, usegroups);
+  if(this->layout()->direction()==QBoxLayout::LeftToRight){
+    but->setIconSize(QSize(this->height(), this->height()));
+    but->setShowText(showText);
+  }else{
+    but->setIconSize(QSize(this->width(), this->width()));
+    but->setToolButtonStyle(Qt::ToolButtonIconOnly);
+  }
+  but->addWindow(win);
+  this->layout()->addWidget(but);
+  connect(but, SIGNAL(MenuClosed()), this, SIGNAL(MenuClosed()));
+  BUTTONS << but;
+}
+
+void LTaskManagerPlugin::removeWindow(WId win){
+  CLASSES.remove(win);
+  LTaskButton *but = buttonFor(win);
+  if(but==0){ return; }
+  if(but->windows().length()>1){ but->rmWindow(win); return; } //one of the multiple windows for the button
+  //Remove the entire button
+  this->layout()->removeWidget(but);
+  BUTTONS.removeAll(but);
+  but->deleteLater();
 }
 
-void LTaskManagerPlugin::UpdateButton(WId win){
+LTaskButton* LTaskManagerPlugin::buttonFor(WId win){
   for(int i=0; i<BUTTONS.length(); i++){
-    if(BUTTONS[i]->windows().contains(win)){
-      qDebug() << "Update Task Manager Button (single window ping)";
-      QTimer::singleShot(0,BUTTONS[i], SLOT(UpdateButton()) );
-      break;
-    }
+    if(BUTTONS[i]->windows().contains(win)){ return BUTTONS[i]; }
   }
+  return 0;
+}
+
+void LTaskManagerPlugin::UpdateButton(WId win, int props){
+  if(props & LWindowModel::LISTING){ checkWindows(); return; } //window might need to show up/disappear
+  LTaskButton *but = buttonFor(win);
+  if(but!=0){ but->windowChanged(win, props); }
+}
+
+void LTaskManagerPlugin::refreshButtons(){
+  for(int i=0; i<BUTTONS.length(); i++){ BUTTONS[i]->UpdateButton(); }
 }
 
 void LTaskManagerPlugin::checkWindows(){
@@ -201,6 +164,9 @@ void LTaskManagerPlugin::settingsChange(QSettings *settings, const QString &pref
 {
     if (!settings) { return; }
     qWarning() << "TASK! settings changed" << prefix;
-    showText = settings->value(QString("%1taskmanagerText").arg(prefix), true).toBool();
-    UpdateButtons();
+    bool show = settings->value(QString("%1taskmanagerText").arg(prefix), true).toBool();
+    if (show == showText) { return; }
+    showText = show;
+    if (this->layout()->direction() != QBoxLayout::LeftToRight) { return; } // vertical panels are icon-only
+    for (int i=0; i<BUTTONS.length(); i++) { BUTTONS[i]->setShowText(showText); }
 }
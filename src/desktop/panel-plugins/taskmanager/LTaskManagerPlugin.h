@@ -63,7 +63,7 @@
 #include <QDebug>
 #include <QTimer>
 #include <QEvent>
-#include <QDateTime>
+#include <QHash>
 
 // libLumina includes
 #include <LuminaX11.h>
@@ -71,6 +71,7 @@
 // Local includes
 #include "LTaskButton.h"
 #include "LWinInfo.h"
+#include "LWindowModel.h"
 #include "../LPPlugin.h"
 
 class LTaskManagerPlugin : public LPPlugin{
@@ -83,23 +84,28 @@ public:
 
 private:
 	QList<LTaskButton*> BUTTONS; //to keep track of the current buttons
+	QHash<WId, QString> CLASSES; //listed windows -> class they were grouped with
 	QTimer *timer;
-	QDateTime updating; //quick flag for if it is currently working
 	bool usegroups;
     bool showText;
 
+	void addWindow(WId win, QString wclass);
+	void removeWindow(WId win);
+	LTaskButton* buttonFor(WId win);
+
 private slots:
-	void UpdateButtons();
-	void UpdateButton(WId win);
+	void UpdateButtons(); //sync the buttons with the window list (only changes are applied)
+	void UpdateButton(WId win, int props); //LWindowModel::Property flags
+	void refreshButtons(); //re-read all the buttons (theme/locale)
 	void checkWindows();
 
 public slots:
 	void LocaleChange(){
-	  UpdateButtons();
+	  refreshButtons();
 	}
     void settingsChange(QSettings *settings, const QString &prefix);
 	void ThemeChange(){
-	  UpdateButtons();
+	  refreshButtons();
 	}
 	void OrientationChange(){
 	  if(this->layout()->direction()==QBoxLayout::LeftToRight){ //horizontal
@@ -124,6 +124,16 @@ const QString Draco::configDir()
     return path;
 }
 
+const QString Draco::cacheDir()
+{
+    QString base = QString(getenv("XDG_CACHE_HOME"));
+    if (base.isEmpty()) { base = QString("%1/.cache").arg(QDir::homePath()); }
+    QString path = QString("%1/%2").arg(base).arg(DESKTOP_APP);
+    QDir dir(path);
+    if (!dir.exists(path)) { dir.mkpath(path); }
+    return path;
+}
+
 const QString Draco::sessionSettingsFile()
 {
     QString file = QString("%1/%2.conf")
@@ -60,6 +60,7 @@ public:
     static const QString launcherApp();
     static const QString terminalApp();
     static const QString configDir();
+    static const QString cacheDir();
     static const QString sessionSettingsFile();
     static const QString desktopSettingsFile();
     static const QString envSettingsFile();
@@ -58,12 +58,19 @@
 //#include <LuminaOS.h>
 #include <LUtils.h>
 #include <LuminaXDG.h>
+#include "draco.h"
 
 #include <QDir>
+#include <QApplication>
+#include <QMenu>
+#include <QMutexLocker>
 #include <QtConcurrent>
 
 LIconCache::LIconCache(QObject *parent) : QObject(parent){
+  qRegisterMetaType<icon_theme_switch*>("icon_theme_switch*");
   connect(this, SIGNAL(InternalIconLoaded(QString, QDateTime, QByteArray*)), this, SLOT(IconLoaded(QString, QDateTime, QByteArray*)) );
+  connect(this, SIGNAL(InternalThemePrepared(icon_theme_switch*)), this, SLOT(ThemePrepared(icon_theme_switch*)) );
+  searchPaths = QIcon::themeSearchPaths();
 }
 
 LIconCache::~LIconCache(){
@@ -102,80 +109,40 @@ bool LIconCache::isLoaded(QString icon){
 
 QString LIconCache::findFile(QString icon){
   if(icon.isEmpty()){ return ""; }
-  
-  //Get the currently-set theme
-  QString cTheme = QIcon::themeName();
-  if(cTheme.isEmpty()){
-    QIcon::setThemeName("Adwaita");
-    cTheme = "Adwaita";
-  }
-  //Make sure the current search paths correspond to this theme
-  if( QDir::searchPaths("icontheme").filter("/"+cTheme+"/").isEmpty() ){
-    //Need to reset search paths: setup the "icontheme" "material-design-light" and "fallback" sets
-    // - Get all the base icon directories
-    QStringList paths;
-      paths << QDir::homePath()+"/.icons/"; //ordered by priority - local user dirs first
-      QStringList xdd = QString(getenv("XDG_DATA_HOME")).split(":");
-        xdd << QString(getenv("XDG_DATA_DIRS")).split(":");
-        for(int i=0; i<xdd.length(); i++){
-          if(QFile::exists(xdd[i]+"/icons")){ paths << xdd[i]+"/icons/"; }
-        }
-    //Now load all the dirs into the search paths
-    QStringList theme, oxy, fall;
-    QStringList themedeps = LXDG::getIconThemeDepChain(cTheme, paths);
-    for(int i=0; i<paths.length(); i++){
-      theme << getChildIconDirs( paths[i]+cTheme);
-      for(int j=0; j<themedeps.length(); j++){ theme << getChildIconDirs(paths[i]+themedeps[j]); }
-      oxy << getChildIconDirs(paths[i]+"material-design-light"); //Lumina base icon set
-      fall << getChildIconDirs(paths[i]+"hicolor"); //XDG fallback (apps add to this)
-    }
-    //Now load all the icon theme dependencies in order (Theme1 -> Theme2 -> Theme3 -> Fallback)
+  QString path = indexLookup(currentTheme(), icon);
+  if(path.isEmpty()){ path = findPixmap(icon); }
+  return path;
+}
 
-    //fall << LOS::AppPrefix()+"share/pixmaps"; //always use this as well as a final fallback
-    QDir::setSearchPaths("icontheme", theme);
-    QDir::setSearchPaths("default", oxy);
-    QDir::setSearchPaths("fallback", fall);
-    //qDebug() << "Setting Icon Search Paths:" << "\nicontheme:" << theme << "\nmaterial-design-light:" << oxy << "\nfallback:" << fall;
-  }
-  //Find the icon in the search paths
+QIcon LIconCache::findIcon(QString icon, QString fallback){
   QIcon ico;
-  QStringList srch; srch << "icontheme" << "default" << "fallback";
-  for(int i=0; i<srch.length() && ico.isNull(); i++){
-    /*if(QFile::exists(srch[i]+":"+icon+".svg") && !icon.contains("libreoffice") ){
-      return QFileInfo(srch[i]+":"+icon+".svg").absoluteFilePath();
-    }else*/ if(QFile::exists(srch[i]+":"+icon+".png")){
-      return QFileInfo(srch[i]+":"+icon+".png").absoluteFilePath();
-    }
-  }
-  //If still no icon found, look for any image format in the "pixmaps" directory
-  /*if(QFile::exists(LOS::AppPrefix()+"share/pixmaps/"+icon)){
-    if(QFileInfo(LOS::AppPrefix()+"share/pixmaps/"+icon).isDir()){ return ""; }
-    return (LOS::AppPrefix()+"share/pixmaps/"+icon);
-  }else{*/
-    //Need to scan for any close match in the directory
-    QDir pix;//(LOS::AppPrefix()+"share/pixmaps");
-    QStringList formats = LUtils::imageExtensions();
-    QStringList found = pix.entryList(QStringList() << icon, QDir::Files, QDir::Unsorted);
-    if(found.isEmpty()){ found = pix.entryList(QStringList() << icon+"*", QDir::Files, QDir::Unsorted); }
-    //qDebug() << "Found pixmaps:" << found << formats;
-    //Use the first one found that is a valid format
-    for(int i=0; i<found.length(); i++){
-      if( formats.contains(found[i].section(".",-1).toLower()) ){
-        return pix.absoluteFilePath(found[i]);
-      }
-    }
-  //}
-  return ""; //no file found
+  if(cachedIcon(icon, fallback, &ico)){ return ico; }
+  bool found = false;
+  ico = resolveIcon(icon, fallback, &found);
+  //Only keep real hits - a fallback is looked up again next time (the icon might get installed later)
+  if(found && resolvedTheme == currentTheme()){ RESOLVED.insert(icon+"::::"+fallback, ico); }
+  return ico;
 }
 
+bool LIconCache::cachedIcon(QString icon, QString fallback, QIcon *out){
+  QString theme = currentTheme();
+  if(resolvedTheme.isEmpty()){ resolvedTheme = theme; } //first lookup
+  //Theme changed behind our back (not through switchIconTheme()) - only a switch may update the cache
+  if(resolvedTheme != theme){ return false; }
+  QString key = icon+"::::"+fallback;
+  if(!RESOLVED.contains(key)){ return false; }
+  if(out!=0){ *out = RESOLVED.value(key); }
+  return true;
+}
 
 void LIconCache::loadIcon(QAbstractButton *button, QString icon, bool noThumb){
-    qDebug() << "CACHE LOAD ICON" << icon;
   if(icon.isEmpty()){ return; }
-  if(isThemeIcon(icon)){
-      qDebug() << "IS THEME ICON" << icon;
-    button->setIcon( iconFromTheme(icon));
-    return ;
+  bool theme = isThemeIcon(icon);
+  if(theme){ addUser(icon+"::::", button); } //keep it updated on theme switches
+  else{ dropUser(button); }
+  if(theme){
+    QIcon ico;
+    if(quickThemeIcon(icon, &ico)){ button->setIcon(ico); return; }
   }
   //See if the icon has already been loaded into the HASH
   bool needload = !HASH.contains(icon);
@@ -183,21 +150,24 @@ void LIconCache::loadIcon(QAbstractButton *button, QString icon, bool noThumb){
     if(!noThumb && !HASH[icon].thumbnail.isNull()){ button->setIcon( HASH[icon].thumbnail ); return; }
     else if(!HASH[icon].icon.isNull()){ button->setIcon( HASH[icon].icon ); return; }
   }
-  //Need to load the icon
-  qDebug() << "CACHE NEEDS TO LOAD ICON" << icon;
+  //Need to load the icon (any other request for it will just be added to the pending list)
   icon_data idata;
   if(HASH.contains(icon)){ idata = HASH.value(icon); }
-  else { idata = createData(icon); }
+  else if(!theme){ idata = createData(icon); }
     idata.pendingButtons << QPointer<QAbstractButton>(button); //save this button for later
   HASH.insert(icon, idata);
-  if(needload){ startReadFile(icon, idata.fullpath); }
+  if(needload && theme){ startResolveFile(icon); }
+  else if(needload){ startReadFile(icon, idata.fullpath); }
 }
 
 void LIconCache::loadIcon(QAction *action, QString icon, bool noThumb){
   if(icon.isEmpty()){ return; }
-  if(isThemeIcon(icon)){
-    action->setIcon( iconFromTheme(icon));
-    return ;
+  bool theme = isThemeIcon(icon);
+  if(theme){ addUser(icon+"::::", action); } //keep it updated on theme switches
+  else{ dropUser(action); }
+  if(theme){
+    QIcon ico;
+    if(quickThemeIcon(icon, &ico)){ action->setIcon(ico); return; }
   }
   //See if the icon has already been loaded into the HASH
   bool needload = !HASH.contains(icon);
@@ -208,17 +178,21 @@ void LIconCache::loadIcon(QAction *action, QString icon, bool noThumb){
   //Need to load the icon
   icon_data idata;
   if(HASH.contains(icon)){ idata = HASH.value(icon); }
-  else { idata = createData(icon); }
+  else if(!theme){ idata = createData(icon); }
     idata.pendingActions << QPointer<QAction>(action); //save this button for later
   HASH.insert(icon, idata);
-  if(needload){ startReadFile(icon, idata.fullpath); }
+  if(needload && theme){ startResolveFile(icon); }
+  else if(needload){ startReadFile(icon, idata.fullpath); }
 }
 
 void LIconCache::loadIcon(QLabel *label, QString icon, bool noThumb){
   if(icon.isEmpty()){ return; }
-  if(isThemeIcon(icon)){
-    label->setPixmap( iconFromTheme(icon).pixmap(label->sizeHint()) );
-    return ;
+  bool theme = isThemeIcon(icon);
+  if(theme){ addUser(icon+"::::", label); } //keep it updated on theme switches
+  else{ dropUser(label); }
+  if(theme){
+    QIcon ico;
+    if(quickThemeIcon(icon, &ico)){ label->setPixmap( ico.pixmap(label->sizeHint()) ); return; }
   }
   //See if the icon has already been loaded into the HASH
   bool needload = !HASH.contains(icon);
@@ -229,19 +203,23 @@ void LIconCache::loadIcon(QLabel *label, QString icon, bool noThumb){
   //Need to load the icon
   icon_data idata;
   if(HASH.contains(icon)){ idata = HASH.value(icon); }
-  else { idata = createData(icon);
+  else if(!theme){ idata = createData(icon);
     if(idata.fullpath.isEmpty()){ return; } //nothing to do
   }
   idata.pendingLabels << QPointer<QLabel>(label); //save this QLabel for later
   HASH.insert(icon, idata);
-  if(needload){ startReadFile(icon, idata.fullpath); }
+  if(needload && theme){ startResolveFile(icon); }
+  else if(needload){ startReadFile(icon, idata.fullpath); }
 }
 
 void LIconCache::loadIcon(QMenu *action, QString icon, bool noThumb){
   if(icon.isEmpty()){ return; }
-  if(isThemeIcon(icon)){
-    action->setIcon( iconFromTheme(icon));
-    return ;
+  bool theme = isThemeIcon(icon);
+  if(theme){ addUser(icon+"::::", action); } //keep it updated on theme switches
+  else{ dropUser(action); }
+  if(theme){
+    QIcon ico;
+    if(quickThemeIcon(icon, &ico)){ action->setIcon(ico); return; }
   }
   //See if the icon has already been loaded into the HASH
   bool needload = !HASH.contains(icon);
@@ -252,10 +230,54 @@ void LIconCache::loadIcon(QMenu *action, QString icon, bool noThumb){
   //Need to load the icon
   icon_data idata;
   if(HASH.contains(icon)){ idata = HASH.value(icon); }
-  else { idata = createData(icon); }
+  else if(!theme){ idata = createData(icon); }
     idata.pendingMenus << QPointer<QMenu>(action); //save this button for later
   HASH.insert(icon, idata);
-  if(needload){ startReadFile(icon, idata.fullpath); }
+  if(needload && theme){ startResolveFile(icon); }
+  else if(needload){ startReadFile(icon, idata.fullpath); }
+}
+
+void LIconCache::applyIcon(QObject *obj, QString icon, QString fallback){
+  if(obj==0){ return; }
+  setObjectIcon(obj, findIcon(icon, fallback));
+  if(icon.startsWith("/") && QFile::exists(icon)){ dropUser(obj); } //absolute file - same in every theme
+  else{ addUser(icon+"::::"+fallback, obj); }
+}
+
+bool LIconCache::switchIconTheme(QString theme){
+  if(theme.isEmpty() || theme == "hicolor"){ theme = "Adwaita"; }
+  if(resolvedTheme.isEmpty()){ resolvedTheme = currentTheme(); }
+  if(theme == pendingTheme){ return true; } //already being prepared
+  if(pendingTheme.isEmpty() && theme == resolvedTheme){ return false; } //nothing to do
+  if(RESOLVED.isEmpty() && USERS.isEmpty()){
+    //Nothing in use yet - just switch right away
+    QIcon::setThemeName(theme);
+    resolvedTheme = theme;
+    emit IconThemeSwitched(theme, QStringList());
+    return true;
+  }
+  //The icons currently in use: everything resolved so far and everything still shown somewhere
+  QStringList keys = RESOLVED.keys();
+  QStringList ukeys = USERS.keys();
+  for(int i=0; i<ukeys.length(); i++){
+    if(!RESOLVED.contains(ukeys[i])){ keys << ukeys[i]; }
+  }
+  QHash<QString, QString> oldindex; //scanned in the background if not built yet (icons found by the Qt theme engine)
+  indexMutex.lock();
+  searchPaths = QIcon::themeSearchPaths();
+  if(indexTheme == resolvedTheme){ oldindex = INDEX; } //implicitly shared - cheap copy
+  indexMutex.unlock();
+  pendingTheme = theme; //lookups keep using the old theme until the switch is swapped in
+  icon_theme_switch *sw = new icon_theme_switch();
+  sw->theme = theme;
+  sw->previous = resolvedTheme;
+  sw->paths = searchPaths;
+  QtConcurrent::run(this, &LIconCache::PrepareTheme, this, sw, oldindex, keys);
+  return true;
+}
+
+QString LIconCache::iconTheme(){
+  return currentTheme();
 }
 
 void LIconCache::clearIconTheme(){
@@ -263,8 +285,14 @@ void LIconCache::clearIconTheme(){
   QStringList keys = HASH.keys();
   for(int i=0; i<keys.length(); i++){
     //remove all relative icons (
-    if(!keys.startsWith("/")){ HASH.remove(keys[i]); }
+    if(keys[i].startsWith("/")){ continue; }
+    if(isThemeIcon(keys[i])){ requeuePending(keys[i]); }
+    if(HASH.contains(keys[i]) && !HASH[keys[i]].stale){ HASH.remove(keys[i]); }
   }
+  RESOLVED.clear();
+  QMutexLocker lock(&indexMutex);
+  INDEX.clear();
+  indexTheme.clear();
 }
 
 QIcon LIconCache::loadIcon(QString icon, bool noThumb){
@@ -289,81 +317,141 @@ QIcon LIconCache::loadIcon(QString icon, bool noThumb){
 
 void LIconCache::clearAll(){
   HASH.clear();
+  RESOLVED.clear();
 }
 
 // === PRIVATE ===
-icon_data LIconCache::createData(QString icon){
-  icon_data idat;
-  //Find the real path of the icon
-  if(icon.startsWith("/")){ idat.fullpath = icon; } //already full path
-  else{  idat.fullpath = findFile(icon); }
-  return idat;
+QString LIconCache::currentTheme(){
+  //Keep serving the old theme until a pending switch has been swapped in
+  if(!pendingTheme.isEmpty() && !resolvedTheme.isEmpty()){ return resolvedTheme; }
+  //Get the currently-set theme
+  QString cTheme = QIcon::themeName();
+  if(cTheme.isEmpty() || cTheme == "hicolor"){
+    QIcon::setThemeName("Adwaita");
+    cTheme = "Adwaita";
+  }
+  return cTheme;
 }
 
-QStringList LIconCache::getChildIconDirs(QString path){
-//This is a recursive function that returns the absolute path(s) of directories with *.png files
-  QDir D(path);
-  QStringList out;
-  QStringList dirs = D.entryList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name);
-  if(!dirs.isEmpty() && (dirs.contains("32x32") || dirs.contains("scalable")) ){
-    //Need to sort these directories by image size
-    //qDebug() << " - Parent:" << parent << "Dirs:" << dirs;
-    for(int i=0; i<dirs.length(); i++){
-      if(dirs[i].contains("x")){ dirs[i].prepend( QString::number(10-dirs[i].section("x",0,0).length())+QString::number(10-dirs[i].at(0).digitValue())+"::::"); }
-      else if(dirs[i].at(0).isNumber()){dirs[i].prepend( QString::number(10-dirs[i].length())+QString::number(10-dirs[i].at(0).digitValue())+"::::"); }
-      else{ dirs[i].prepend( "0::::"); }
+void LIconCache::buildIndex(QString theme){
+  INDEX.clear();
+  indexTheme = theme;
+  scanTheme(theme, searchPaths, &INDEX);
+}
+
+void LIconCache::scanTheme(QString theme, QStringList searchpaths, QHash<QString, QString> *index){
+  //Scan the theme chain once: (Theme1 -> Theme2 -> Theme3 -> Fallback)
+  // NOTE: This replaces the old QDir::setSearchPaths("icontheme", ...) setup
+  // - Get all the base icon directories
+  QStringList paths;
+    paths << QDir::homePath()+"/.icons/"; //ordered by priority - local user dirs first
+    QStringList xdd = QString(getenv("XDG_DATA_HOME")).split(":");
+      xdd << QString(getenv("XDG_DATA_DIRS")).split(":");
+      for(int i=0; i<xdd.length(); i++){
+        if(QFile::exists(xdd[i]+"/icons")){ paths << xdd[i]+"/icons/"; }
+      }
+    //Also everything the Qt theme engine looks through (QIcon::fromTheme() hits come from there)
+    for(int i=0; i<searchpaths.length(); i++){
+      QString path = searchpaths[i].endsWith("/") ? searchpaths[i] : searchpaths[i]+"/";
+      if(!paths.contains(path) && QFile::exists(path)){ paths << path; }
     }
-    dirs.sort();
-    for(int i=0; i<dirs.length(); i++){ dirs[i] = dirs[i].section("::::",1,50); } //chop the sorter off the front again
-    //qDebug() << "Sorted:" << dirs;
+  QStringList dirs, fall;
+  QStringList themedeps = LXDG::getIconThemeDepChain(theme, paths);
+  for(int i=0; i<paths.length(); i++){
+    dirs << LXDG::getChildIconDirs(paths[i]+theme);
+    for(int j=0; j<themedeps.length(); j++){ dirs << LXDG::getChildIconDirs(paths[i]+themedeps[j]); }
+    fall << LXDG::getChildIconDirs(paths[i]+"hicolor"); //XDG fallback (apps add to this)
   }
-  QStringList img = D.entryList(QStringList() << "*.png", QDir::Files | QDir::NoDotAndDotDot, QDir::NoSort);
-  if(img.length() > 0){ out << D.absolutePath(); }
+  dirs << fall;
+  //Now list every image once - first match wins (PNG preferred within each directory, then SVG)
+  QStringList filters; filters << "*.png" << "*.svg" << "*.jpg" << "*.xpm";
   for(int i=0; i<dirs.length(); i++){
-    img.clear();
-    img = getChildIconDirs(D.absoluteFilePath(dirs[i])); //re-use the old list variable
-    if(img.length() > 0){ out << img; }
+    QDir D(dirs[i]);
+    for(int f=0; f<filters.length(); f++){
+      QStringList files = D.entryList(QStringList() << filters[f], QDir::Files, QDir::NoSort);
+      for(int j=0; j<files.length(); j++){
+        QString name = files[j].section(".",0,-2);
+        if(!index->contains(name)){ index->insert(name, D.absoluteFilePath(files[j])); }
+      }
+    }
   }
-  return out;
 }
 
-QStringList LIconCache::getIconThemeDepChain(QString theme, QStringList paths){
-  QStringList results;
-  for(int i=0; i<paths.length(); i++){
-    if( QFile::exists(paths[i]+theme+"/index.theme") ){
-      QStringList deps = LUtils::readFile(paths[i]+theme+"/index.theme").filter("Inherits=");
-      if(!deps.isEmpty()){
-        deps = deps.first().section("=",1,-1).split(";",QString::SkipEmptyParts);
-        for(int j=0; j<deps.length(); j++){
-          results << deps[j] << getIconThemeDepChain(deps[j],paths);
-        }
+QString LIconCache::indexLookup(QString theme, QString icon){
+  QMutexLocker lock(&indexMutex);
+  if(indexTheme != theme){ buildIndex(theme); }
+  return INDEX.value(icon);
+}
+
+QString LIconCache::findPixmap(QString icon){
+  //Need to scan for any close match in the directory
+  QStringList formats = LUtils::imageExtensions();
+  QStringList pixmaps = Draco::pixmapLocations(qApp->applicationFilePath());
+  for(int x=0; x<pixmaps.size(); x++){
+    QDir pix(pixmaps.at(x));
+    QStringList found = pix.entryList(QStringList() << icon, QDir::Files, QDir::Unsorted);
+    if(found.isEmpty()){ found = pix.entryList(QStringList() << icon+"*", QDir::Files, QDir::Unsorted); }
+    //Use the first one found that is a valid format
+    for(int i=0; i<found.length(); i++){
+      if( formats.contains(found[i].section(".",-1).toLower()) ){
+        return pix.absoluteFilePath(found[i]);
       }
-      break; //found primary theme index file - stop here
     }
   }
-  return results;
+  return ""; //no file found
+}
+
+QIcon LIconCache::resolveIcon(QString iconName, QString fallback, bool *found){
+  *found = false;
+  QString cTheme = currentTheme();
+  // filter "bad" icons
+  iconName = Draco::filterIconName(iconName);
+
+  if(iconName.isEmpty()){
+    QIcon fallbackIcon = QIcon::fromTheme(fallback);
+    if(!fallbackIcon.isNull()){ return fallbackIcon; }
+    return QIcon::fromTheme("application-x-executable");
+  }
+  if(iconName.startsWith("/") && QFile::exists(iconName)){ *found = true; return QIcon(iconName); }
+  else if(iconName.startsWith("/")){ iconName = iconName.section("/",-1); }
+
+  QIcon ico = QIcon::fromTheme(iconName);
+  if(!ico.isNull() && ico.name()==iconName){ *found = true; return ico; }
+  ico = QIcon();
+
+  //Now try to find the icon from the theme index
+  QString path = indexLookup(cTheme, iconName);
+  //If still no icon found, look for any image format in the "pixmaps" directory
+  if(path.isEmpty()){ path = findPixmap(iconName); }
+  if(!path.isEmpty()){ ico.addFile(path); *found = true; }
+
+  //Use the fallback icon if necessary
+  if(ico.isNull()){
+    if(!fallback.isEmpty()){ ico = findIcon(fallback,""); }
+    else if(iconName.contains("-x-") && !iconName.endsWith("-x-generic")){
+      //mimetype - try to use the generic type icon
+      ico = findIcon(iconName.section("-x-",0,0)+"-x-generic", "");
+    }else if(iconName.contains("-")){
+      ico = findIcon(iconName.section("-",0,-2), ""); //chop the last modifier off the end and try again
+    }
+  }
+  if(ico.isNull()){
+    if(!fallback.isEmpty() && QIcon::hasThemeIcon(fallback)){ return QIcon::fromTheme(fallback); }
+    ico = QIcon::fromTheme("application-x-executable");
+  }
+  return ico;
+}
+
+icon_data LIconCache::createData(QString icon){
+  icon_data idat;
+  //Find the real path of the icon
+  if(icon.startsWith("/")){ idat.fullpath = icon; } //already full path
+  else{  idat.fullpath = findFile(icon); }
+  return idat;
 }
 
 void LIconCache::startReadFile(QString id, QString path){
-  /*if(path.endsWith(".svg")){
-    //Special handling - need to read QIcon directly to have the SVG icon scale up appropriately
-    icon_data idat = HASH[id];
-    idat.lastread = QDateTime::currentDateTime();
-    idat.icon = QIcon(path);
-    for(int i=0; i<idat.pendingButtons.length(); i++){ if(!idat.pendingButtons[i].isNull()){ idat.pendingButtons[i]->setIcon(idat.icon); } }
-    idat.pendingButtons.clear();
-    for(int i=0; i<idat.pendingLabels.length(); i++){ if(!idat.pendingLabels[i].isNull()){ idat.pendingLabels[i]->setPixmap(idat.icon.pixmap(idat.pendingLabels[i]->sizeHint())); } }
-    idat.pendingLabels.clear();
-    for(int i=0; i<idat.pendingActions.length(); i++){ if(!idat.pendingActions[i].isNull()){ idat.pendingActions[i]->setIcon(idat.icon); } }
-    idat.pendingActions.clear();
-    for(int i=0; i<idat.pendingMenus.length(); i++){ if(!idat.pendingMenus[i].isNull()){ idat.pendingMenus[i]->setIcon(idat.icon); } }
-    idat.pendingMenus.clear();
-    //Now update the hash and let the world know it is available now
-    HASH.insert(id, idat);
-    this->emit IconAvailable(id);
-  }else{*/
-    QtConcurrent::run(this, &LIconCache::ReadFile, this, id, path);
-  //}
+  QtConcurrent::run(this, &LIconCache::ReadFile, this, id, path);
 }
 
 void LIconCache::ReadFile(LIconCache *obj, QString id, QString path){
@@ -380,6 +468,27 @@ void LIconCache::ReadFile(LIconCache *obj, QString id, QString path){
   obj->emit InternalIconLoaded(id, cdt, BA);
 }
 
+void LIconCache::startResolveFile(QString id){
+  //Theme lookups run in the background as well (the index might need to be built first)
+  QtConcurrent::run(this, &LIconCache::ResolveFile, this, id, currentTheme());
+}
+
+void LIconCache::ResolveFile(LIconCache *obj, QString id, QString theme){
+  QString path = obj->indexLookup(theme, Draco::filterIconName(id));
+  if(path.endsWith(".svg")){ path.clear(); } //scalable - the fallback routine adds the file to the icon instead of a fixed-size pixmap
+  ReadFile(obj, id, path); //an empty path is handled by the synchronous fallback routines
+}
+
+void LIconCache::requeuePending(QString id){
+  if(!HASH.contains(id)){ return; }
+  icon_data idat = HASH.value(id);
+  bool pending = !idat.pendingButtons.isEmpty() || !idat.pendingLabels.isEmpty() || !idat.pendingActions.isEmpty() || !idat.pendingMenus.isEmpty();
+  if(!pending){ return; }
+  //The running lookup still answers (for the old theme), IconLoaded() starts a new one then
+  idat.stale = true;
+  HASH.insert(id, idat);
+}
+
 bool LIconCache::isThemeIcon(QString id){
   return (!id.contains("/") && !id.contains(".") ); //&& !id.contains("libreoffice") );
 }
@@ -388,13 +497,85 @@ QIcon LIconCache::iconFromTheme(QString id){
   QIcon ico = QIcon::fromTheme(id);
   if(ico.isNull()){
     //icon missing in theme? run the old icon-finder system
-    //ico = QIcon(findFile(id));
-      qDebug() << "CACHE FIND ICON" << id;
-    ico = LXDG::findIcon(id);
+    ico = findIcon(id);
   }
   return ico;
 }
 
+bool LIconCache::quickThemeIcon(QString id, QIcon *out){
+  if(cachedIcon(id, "", out)){ return true; }
+  QIcon ico = QIcon::fromTheme(id);
+  if(ico.isNull()){ return false; } //needs a full lookup
+  if(resolvedTheme == currentTheme()){ RESOLVED.insert(id+"::::", ico); }
+  *out = ico;
+  return true;
+}
+
+void LIconCache::addUser(QString key, QObject *obj){
+  if(USERKEYS.contains(obj)){
+    if(USERKEYS.value(obj) == key){ return; } //already listed
+    dropUser(obj); //showing a different icon now
+  }
+  USERKEYS.insert(obj, key);
+  USERS[key] << QPointer<QObject>(obj);
+  connect(obj, SIGNAL(destroyed(QObject*)), this, SLOT(UserDestroyed(QObject*)), Qt::UniqueConnection);
+}
+
+void LIconCache::dropUser(QObject *obj){
+  if(!USERKEYS.contains(obj)){ return; }
+  QString key = USERKEYS.take(obj);
+  QList<QPointer<QObject> > list = USERS.value(key);
+  for(int i=list.length()-1; i>=0; i--){
+    if(list[i].isNull() || list[i].data() == obj){ list.removeAt(i); }
+  }
+  if(list.isEmpty()){ USERS.remove(key); }
+  else{ USERS.insert(key, list); }
+}
+
+void LIconCache::setObjectIcon(QObject *obj, QIcon ico){
+  QAction *act = qobject_cast<QAction*>(obj);
+  if(act!=0){ act->setIcon(ico); return; }
+  QMenu *menu = qobject_cast<QMenu*>(obj);
+  if(menu!=0){ menu->setIcon(ico); return; }
+  QAbstractButton *button = qobject_cast<QAbstractButton*>(obj);
+  if(button!=0){ button->setIcon(ico); return; }
+  QLabel *label = qobject_cast<QLabel*>(obj);
+  if(label!=0){ label->setPixmap( ico.pixmap(label->sizeHint()) ); return; }
+}
+
+bool LIconCache::iconDiffers(QString icon, const QHash<QString, QString> &oldindex, const QHash<QString, QString> &newindex){
+  if(icon.isEmpty()){ return true; }
+  QString before = oldindex.value(icon);
+  QString after = newindex.value(icon);
+  if(!before.isEmpty() || !after.isEmpty()){ return (before != after); }
+  //Not in either theme: a generic pixmap stays the same, anything else is up to the Qt theme engine
+  return findPixmap(icon).isEmpty();
+}
+
+void LIconCache::PrepareTheme(LIconCache *obj, icon_theme_switch *sw, QHash<QString, QString> oldindex, QStringList keys){
+  //NOTE: This runs in a background thread - only the index/file routines may be used here
+  if(oldindex.isEmpty()){ scanTheme(sw->previous, sw->paths, &oldindex); } //so far only served by the Qt theme engine
+  scanTheme(sw->theme, sw->paths, &sw->index);
+  for(int i=0; i<keys.length(); i++){
+    QString icon = Draco::filterIconName(keys[i].section("::::",0,0));
+    QString fallback = keys[i].section("::::",1,-1);
+    if(icon.startsWith("/") && QFile::exists(icon)){ continue; } //absolute file - same in every theme
+    if(icon.startsWith("/")){ icon = icon.section("/",-1); }
+    bool changed = obj->iconDiffers(icon, oldindex, sw->index);
+    if(!changed && !fallback.isEmpty() && oldindex.value(icon).isEmpty()){
+      changed = obj->iconDiffers(fallback, oldindex, sw->index); //the fallback might be in use
+    }
+    if(!changed){ continue; }
+    sw->changed << keys[i];
+    //Pre-read the new file so the swap does not need to touch the disk
+    QString path = sw->index.value(icon);
+    if(path.isEmpty() || path.endsWith(".svg")){ continue; } //SVG stays scalable - added to the icon at the swap
+    QImage img;
+    if(img.load(path)){ sw->images.insert(keys[i], img); }
+  }
+  obj->emit InternalThemePrepared(sw);
+}
+
 // === PRIVATE SLOTS ===
 void LIconCache::IconLoaded(QString id, QDateTime sync, QByteArray *data){
   //qDebug() << "Icon Loaded:" << id << HASH.contains(id);
@@ -402,12 +583,28 @@ void LIconCache::IconLoaded(QString id, QDateTime sync, QByteArray *data){
   bool ok = pix.loadFromData(*data);
    delete data; //no longer used - free this up
   if(!HASH.contains(id)){ return; } //icon loading cancelled - just stop here
+  icon_data idat = HASH[id];
+  if(idat.stale){
+    //Resolved against the previous theme - ask again for the current one (the objects stay pending)
+    idat.stale = false;
+    HASH.insert(id, idat);
+    startResolveFile(id);
+    return;
+  }
+  bool keep = true;
+  if(!ok && isThemeIcon(id)){
+    //Not in the theme index - run through the fallback routines instead
+    idat.icon = findIcon(id);
+    if(!idat.icon.isNull()){ pix = idat.icon.pixmap(64,64); ok = true; }
+    keep = cachedIcon(id, "", 0); //a generic fallback is not kept (the icon might get installed later)
+  }else if(ok){
+    idat.icon.addPixmap(pix);
+    if(pix.width() < 64){ idat.icon.addPixmap( pix.scaled( QSize(64,64), Qt::KeepAspectRatio, Qt::SmoothTransformation) ); } //also add a version which has been scaled up a bit
+    if(isThemeIcon(id) && resolvedTheme == currentTheme()){ RESOLVED.insert(id+"::::", idat.icon); }
+  }
   if(!ok){ HASH.remove(id); } //icon data corrupted or unreadable
   else{
-    icon_data idat = HASH[id];
     idat.lastread = sync;
-    idat.icon.addPixmap(pix);
-    if(pix.width() < 64){ idat.icon.addPixmap( pix.scaled( QSize(64,64), Qt::KeepAspectRatio, Qt::SmoothTransformation) ); } //also add a version which has been scaled up a bit
     //Now throw this icon into any pending objects
     for(int i=0; i<idat.pendingButtons.length(); i++){ if(!idat.pendingButtons[i].isNull()){ idat.pendingButtons[i]->setIcon(idat.icon); } }
     idat.pendingButtons.clear();
@@ -415,8 +612,54 @@ void LIconCache::IconLoaded(QString id, QDateTime sync, QByteArray *data){
     idat.pendingLabels.clear();
     for(int i=0; i<idat.pendingActions.length(); i++){ if(!idat.pendingActions[i].isNull()){ idat.pendingActions[i]->setIcon(idat.icon); } }
     idat.pendingActions.clear();
+    for(int i=0; i<idat.pendingMenus.length(); i++){ if(!idat.pendingMenus[i].isNull()){ idat.pendingMenus[i]->setIcon(idat.icon); } }
+    idat.pendingMenus.clear();
     //Now update the hash and let the world know it is available now
-    HASH.insert(id, idat);
+    if(keep){ HASH.insert(id, idat); }
+    else{ HASH.remove(id); }
     this->emit IconAvailable(id);
   }
 }
+
+void LIconCache::ThemePrepared(icon_theme_switch *sw){
+  if(sw->theme != pendingTheme){ delete sw; return; } //superseded by another switch
+  //Swap the new theme in all at once
+  QIcon::setThemeName(sw->theme);
+  indexMutex.lock();
+  INDEX = sw->index;
+  indexTheme = sw->theme;
+  indexMutex.unlock();
+  resolvedTheme = sw->theme;
+  pendingTheme.clear();
+  //Now update only the icons which changed
+  for(int i=0; i<sw->changed.length(); i++){
+    QString key = sw->changed[i];
+    QString icon = key.section("::::",0,0);
+    QString fallback = key.section("::::",1,-1);
+    RESOLVED.remove(key);
+    if(HASH.contains(icon) && isThemeIcon(icon)){
+      if(!HASH[icon].icon.isNull()){ HASH.remove(icon); } //stale theme data
+      else{ requeuePending(icon); } //lookup still running against the old theme
+    }
+    QIcon ico;
+    if(sw->images.contains(key)){
+      QPixmap pix = QPixmap::fromImage(sw->images.value(key));
+      ico.addPixmap(pix);
+      if(pix.width() < 64){ ico.addPixmap( pix.scaled( QSize(64,64), Qt::KeepAspectRatio, Qt::SmoothTransformation) ); }
+      RESOLVED.insert(key, ico);
+    }
+    QList<QPointer<QObject> > users = USERS.value(key);
+    if(users.isEmpty()){ continue; } //resolved again on the next request
+    if(ico.isNull()){ ico = findIcon(icon, fallback); }
+    for(int j=0; j<users.length(); j++){
+      if(!users[j].isNull()){ setObjectIcon(users[j], ico); }
+    }
+    if(fallback.isEmpty()){ emit IconAvailable(icon); }
+  }
+  emit IconThemeSwitched(sw->theme, sw->changed);
+  delete sw;
+}
+
+void LIconCache::UserDestroyed(QObject *obj){
+  dropUser(obj);
+}
@@ -55,6 +55,8 @@
 //===========================================
 // This is a simple class for loading/serving icon files
 // from the icon theme or local filesystem
+// It is also the backend for LXDG::findIcon(), so there is only
+// a single icon index and cache per process
 //===========================================
 #ifndef LUMINA_LIBRARY_ICON_CACHE_H
 #define LUMINA_LIBRARY_ICON_CACHE_H
@@ -70,6 +72,9 @@
 #include <QLabel>
 #include <QAction>
 #include <QPointer>
+#include <QMutex>
+#include <QImage>
+#include <QStringList>
 
 //Data structure for saving the icon/information internally
 struct icon_data{
@@ -81,8 +86,20 @@ struct icon_data{
   QList<QPointer<QMenu> > pendingMenus;
   QIcon icon;
   QIcon thumbnail;
+  bool stale = false; //theme changed while the lookup was running - resolve it again
 };
 
+//Data structure for an icon theme switch which is prepared in the background
+struct icon_theme_switch{
+  QString theme;
+  QString previous; //theme served until the swap
+  QStringList paths; //extra search paths (QIcon::themeSearchPaths())
+  QHash<QString, QString> index; //icon index of the new theme
+  QStringList changed; //"<icon>::::<fallback>" keys which look different in the new theme
+  QHash<QString, QImage> images; //new icon files (pre-read for the changed keys)
+};
+Q_DECLARE_METATYPE(icon_theme_switch*)
+
 class LIconCache : public QObject{
 	Q_OBJECT
 public:
@@ -92,6 +109,7 @@ public:
 	//Static method for using this class (DO NOT MIX WITH GLOBAL OBJECT METHOD)
 	// Either use this the entire time, or use a saved/global object - pick one and stick with it
 	//  otherwise you may end up with multiple icon cache's running for your application
+	// NOTE: LXDG::findIcon() always uses this instance
 	static LIconCache* instance();
 
 	//Icon Checks
@@ -99,7 +117,13 @@ public:
 	bool isLoaded(QString icon);
 	QString findFile(QString icon); //find the full path of a given file/name (searching the current Icon theme)
 
+	//Synchronous theme lookup (the LXDG::findIcon() routine)
+	// - returns right away if the icon was already resolved
+	QIcon findIcon(QString icon, QString fallback = "");
+	bool cachedIcon(QString icon, QString fallback, QIcon *out); //fast path only - never touches the disk
+
 	//Special loading routines for QLabel and QAbstractButton (pushbutton, toolbutton, etc)
+	// - requests for the same icon are coalesced into a single background lookup
 	void loadIcon(QAbstractButton *button, QString icon, bool noThumb = false);
 	void loadIcon(QLabel *label, QString icon, bool noThumb = false);
 	void loadIcon(QAction *action, QString icon, bool noThumb = false);
@@ -107,29 +131,70 @@ public:
 
 	QIcon loadIcon(QString icon, bool noThumb = false); //generic loading routine - does not background the loading of icons when not in the cache
 
+	//Same as findIcon(), but the object also gets updated on icon theme switches
+	// (QAction, QMenu, QAbstractButton or QLabel)
+	void applyIcon(QObject *obj, QString icon, QString fallback = "");
+
+	//Incremental icon theme switch
+	// - the icons currently in use are resolved for the new theme in the background, then
+	//   everything is swapped in at once and only the objects whose icon changed get updated
+	// - IconThemeSwitched() is emitted when done, returns false (and emits nothing) if the theme is already in use
+	bool switchIconTheme(QString theme);
+	QString iconTheme(); //theme currently served by the cache
+
 	void clearIconTheme(); //use when the icon theme changes to refresh all requested icons
 	void clearAll(); //Clear all cached icons
 
 private:
 	QHash<QString, icon_data> HASH;
+	QHash<QString, QIcon> RESOLVED; //"<icon>::::<fallback>" -> icon found in the theme (never a fallback)
+	QString resolvedTheme; //theme the RESOLVED icons belong to
+	QString pendingTheme; //theme being prepared in the background
+	QHash<QString, QList<QPointer<QObject> > > USERS; //"<icon>::::<fallback>" -> objects showing that icon
+	QHash<QObject*, QString> USERKEYS; //object -> USERS key (only used as a lookup key, never dereferenced)
 	QFileSystemWatcher *WATCHER;
 
+	//Icon theme index (shared between the GUI thread and the background loaders)
+	QHash<QString, QString> INDEX; //icon name -> full path of the best match
+	QString indexTheme; //theme the index was built for
+	QStringList searchPaths; //QIcon::themeSearchPaths() (read on the GUI thread)
+	QMutex indexMutex;
+
+	QString currentTheme();
+	void buildIndex(QString theme); //NOTE: indexMutex must be locked
+	static void scanTheme(QString theme, QStringList searchpaths, QHash<QString, QString> *index);
+	QString indexLookup(QString theme, QString icon);
+	QString findPixmap(QString icon); //look through the generic "pixmaps" directories
+	QIcon resolveIcon(QString icon, QString fallback, bool *found); //found: false if only a fallback icon was returned
+
 	icon_data createData(QString icon);
-	QStringList getChildIconDirs(QString path); //recursive function to find directories with icons in them
-	QStringList getIconThemeDepChain(QString theme, QStringList paths);
 
 	void startReadFile(QString id, QString path);
 	void ReadFile(LIconCache *obj, QString id, QString path);
+	void startResolveFile(QString id);
+	void requeuePending(QString id); //pending lookup of a theme icon belongs to the previous theme
+	void ResolveFile(LIconCache *obj, QString id, QString theme);
 
 	bool isThemeIcon(QString id);
 	QIcon iconFromTheme(QString id);
+	bool quickThemeIcon(QString id, QIcon *out); //cached or Qt theme engine hit (no directory scan)
+
+	void addUser(QString key, QObject *obj);
+	void dropUser(QObject *obj);
+	void setObjectIcon(QObject *obj, QIcon ico);
+	bool iconDiffers(QString icon, const QHash<QString, QString> &oldindex, const QHash<QString, QString> &newindex);
+	void PrepareTheme(LIconCache *obj, icon_theme_switch *sw, QHash<QString, QString> oldindex, QStringList keys);
 
 private slots:
 	void IconLoaded(QString id, QDateTime sync, QByteArray *data);
+	void ThemePrepared(icon_theme_switch *sw);
+	void UserDestroyed(QObject *obj);
 
 signals:
 	void InternalIconLoaded(QString, QDateTime, QByteArray*); //INTERNAL SIGNAL - DO NOT USE in other classes/objects
+	void InternalThemePrepared(icon_theme_switch*); //INTERNAL SIGNAL - DO NOT USE in other classes/objects
 	void IconAvailable(QString); //way for classes to listen/reload icons as they change
+	void IconThemeSwitched(QString theme, QStringList changed); //changed: "<icon>::::<fallback>" keys that were updated
 };
 
 #endif
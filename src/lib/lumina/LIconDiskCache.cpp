@@ -0,0 +1,202 @@
+/*
+#
+# Draco Desktop Environment <https://dracolinux.org>
+# Copyright (c) 2019, Ole-André Rodlie <ole.andre.rodlie@gmail.com>
+# All rights reserved.
+#
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser Public License as published by
+* the Free Software Foundation; either version 2.1 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>
+#
+*/
+
+#include "LIconDiskCache.h"
+#include "LIconCache.h"
+#include "LuminaXDG.h"
+#include "LUtils.h"
+#include "draco.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QHash>
+#include <QDateTime>
+#include <QImage>
+#include <QGuiApplication>
+
+#include <string.h> //memcpy
+
+QPixmap LIconDiskCache::pixmap(QString icon, int size, qreal scale, QString theme, bool *cached){
+  if(cached!=0){ *cached = false; }
+  if(icon.isEmpty() || size<1){ return QPixmap(); }
+  if(scale<=0){ scale = 1.0; }
+  theme = cacheTheme(theme);
+  QPixmap pix;
+  if(icon.contains("/")){
+    //Absolute paths are not theme icons - just render them
+    pix = LXDG::findIcon(icon, "").pixmap(QSize(size,size)*scale);
+    pix.setDevicePixelRatio(scale);
+    return pix;
+  }
+  qint64 stamp = themeStamp(theme);
+  QString path = cachePath(icon, size, scale, theme);
+  if(read(path, stamp, &pix)){
+    if(cached!=0){ *cached = true; }
+    pix.setDevicePixelRatio(scale);
+    return pix;
+  }
+  //Cache miss (or stale entry) - render it once and share it with everyone else
+  LIconCache *cache = LIconCache::instance();
+  pix = cache->findIcon(icon, "").pixmap(QSize(size,size)*scale);
+  if(pix.isNull()){ return pix; }
+  //Only real theme hits are stored - a generic fallback must not be served under this name
+  if(cache->cachedIcon(icon, "", 0)){
+    write(path, stamp, pix.toImage());
+    if(cached!=0){ *cached = true; }
+  }
+  pix.setDevicePixelRatio(scale);
+  return pix;
+}
+
+QIcon LIconDiskCache::icon(QString icon, QList<int> sizes){
+  //Assembled icons, valid as long as the theme stamp does not change
+  static QHash<QString, QIcon> icons;
+  static QHash<QString, qint64> iconStamps;
+  qreal scale = qApp ? qApp->devicePixelRatio() : 1.0;
+  QString theme = cacheTheme("");
+  qint64 stamp = themeStamp(theme);
+  QString key = QString("%1/%2@%3").arg(theme).arg(icon).arg(QString::number(scale));
+  for(int i=0; i<sizes.length(); i++){ key.append(QString(":%1").arg(sizes[i])); }
+  if(icons.contains(key) && iconStamps.value(key)==stamp){ return icons.value(key); }
+
+  QIcon ico;
+  bool found = true;
+  for(int i=0; i<sizes.length(); i++){
+    bool cached = false;
+    QPixmap pix = pixmap(icon, sizes[i], scale, theme, &cached);
+    if(!pix.isNull()){ ico.addPixmap(pix); }
+    if(!cached){ found = false; }
+  }
+  if(!ico.isNull() && found){ //a fallback is looked up again next time
+    icons.insert(key, ico);
+    iconStamps.insert(key, stamp);
+  }
+  return ico;
+}
+
+QString LIconDiskCache::cacheTheme(QString theme){
+  if(theme.isEmpty()){ theme = QIcon::themeName(); }
+  if(theme.isEmpty() || theme=="hicolor"){ theme = "Adwaita"; }
+  return theme;
+}
+
+QString LIconDiskCache::cachePath(QString icon, int size, qreal scale, QString theme){
+  return QString("%1/icons/%2/%3@%4/%5.icon")
+          .arg(Draco::cacheDir())
+          .arg(theme)
+          .arg(size)
+          .arg(QString::number(scale))
+          .arg(icon);
+}
+
+bool LIconDiskCache::read(QString path, qint64 stamp, QPixmap *pix){
+  QFile file(path);
+  if(!file.open(QIODevice::ReadOnly)){ return false; }
+  qint64 fsize = file.size();
+  if(fsize < (qint64) sizeof(icon_disk_header)){ return false; }
+  uchar *mem = file.map(0, fsize);
+  if(mem==0){ return false; }
+  icon_disk_header head;
+  memcpy(&head, mem, sizeof(icon_disk_header));
+  bool ok = (head.magic==ICON_DISK_CACHE_MAGIC && head.version==ICON_DISK_CACHE_VERSION && head.stamp==stamp \
+	&& head.width>0 && head.height>0 && head.bytesPerLine >= head.width*4 \
+	&& fsize >= (qint64) sizeof(icon_disk_header) + ((qint64) head.bytesPerLine*head.height) );
+  if(ok){
+    //Wrap the mapped pixels directly (QPixmap::fromImage() makes its own copy)
+    QImage img(mem+sizeof(icon_disk_header), head.width, head.height, head.bytesPerLine, QImage::Format_ARGB32_Premultiplied);
+    *pix = QPixmap::fromImage(img);
+    ok = !pix->isNull();
+  }
+  file.unmap(mem);
+  file.close();
+  return ok;
+}
+
+bool LIconDiskCache::write(QString path, qint64 stamp, QImage img){
+  if(img.isNull()){ return false; }
+  img = img.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+  QDir dir;
+  if(!dir.mkpath(QFileInfo(path).absolutePath())){ return false; }
+  icon_disk_header head;
+  head.magic = ICON_DISK_CACHE_MAGIC;
+  head.version = ICON_DISK_CACHE_VERSION;
+  head.stamp = stamp;
+  head.width = img.width();
+  head.height = img.height();
+  head.bytesPerLine = img.bytesPerLine();
+  head.reserved = 0;
+  //Write to a temporary file and rename, so other processes never see a partial entry
+  QSaveFile file(path);
+  if(!file.open(QIODevice::WriteOnly)){ return false; }
+  file.write((const char*) &head, sizeof(icon_disk_header));
+  file.write((const char*) img.constBits(), (qint64) img.bytesPerLine()*img.height());
+  return file.commit();
+}
+
+qint64 LIconDiskCache::themeStamp(QString theme){
+  //Only stat the theme directories every so often (this is called for every cached pixmap)
+  static QHash<QString, qint64> stamps;
+  static QHash<QString, QDateTime> checked;
+  QDateTime now = QDateTime::currentDateTime();
+  if(stamps.contains(theme) && checked.value(theme).secsTo(now) < 30){ return stamps.value(theme); }
+
+  QStringList paths;
+    paths << QDir::homePath()+"/.icons/";
+    QStringList xdd = QString(getenv("XDG_DATA_HOME")).split(":");
+      xdd << QString(getenv("XDG_DATA_DIRS")).split(":");
+      for(int i=0; i<xdd.length(); i++){
+        if(QFile::exists(xdd[i]+"/icons")){ paths << xdd[i]+"/icons/"; }
+      }
+  QStringList themes;
+    themes << theme << LXDG::getIconThemeDepChain(theme, paths) << "hicolor";
+  qint64 stamp = 0;
+  for(int i=0; i<paths.length(); i++){
+    for(int j=0; j<themes.length(); j++){
+      //The theme directory changes whenever the icon-theme.cache/index.theme is regenerated
+      QString base = paths[i]+themes[j];
+      QFileInfo dir(base);
+      if(!dir.exists()){ continue; }
+      stamp = qMax(stamp, dir.lastModified().toMSecsSinceEpoch()/1000);
+      QFileInfo index(base+"/index.theme");
+      if(!index.exists()){ continue; }
+      stamp = qMax(stamp, index.lastModified().toMSecsSinceEpoch()/1000);
+      //The size directories change when icons are added, removed or replaced in them
+      QStringList lines = LUtils::readFile(index.absoluteFilePath()).filter("Directories="); //also ScaledDirectories=
+      for(int l=0; l<lines.length(); l++){
+        QStringList subdirs = lines[l].section("=",1,-1).split(",",QString::SkipEmptyParts);
+        for(int s=0; s<subdirs.length(); s++){
+          QFileInfo sub(base+"/"+subdirs[s].trimmed());
+          if(sub.exists()){ stamp = qMax(stamp, sub.lastModified().toMSecsSinceEpoch()/1000); }
+        }
+      }
+    }
+  }
+  stamps.insert(theme, stamp);
+  checked.insert(theme, now);
+  return stamp;
+}
+
+void LIconDiskCache::clear(QString theme){
+  QDir dir(QString("%1/icons/%2").arg(Draco::cacheDir()).arg(theme));
+  if(dir.exists()){ dir.removeRecursively(); }
+}
@@ -0,0 +1,80 @@
+/*
+#
+# Draco Desktop Environment <https://dracolinux.org>
+# Copyright (c) 2019, Ole-André Rodlie <ole.andre.rodlie@gmail.com>
+# All rights reserved.
+#
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser Public License as published by
+* the Free Software Foundation; either version 2.1 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>
+#
+*/
+
+//===========================================
+// Shared (cross-process) cache of pre-rendered theme icons
+//
+// Every Draco process (desktop, power, storage, settings, xdg)
+// can get a ready pixmap for (name, size, scale, theme) without
+// scanning the icon theme directories.
+//
+// Layout: <cache>/icons/<theme>/<size>@<scale>/<name>.icon
+// Each file is a fixed 32 byte header followed by raw
+// ARGB32 (premultiplied) pixel rows, so it can be mmap'ed and
+// wrapped by a QImage without any decoding.
+// Entries are invalidated when the theme mtime changes.
+//===========================================
+#ifndef LUMINA_LIBRARY_ICON_DISK_CACHE_H
+#define LUMINA_LIBRARY_ICON_DISK_CACHE_H
+
+#include <QString>
+#include <QStringList>
+#include <QPixmap>
+#include <QIcon>
+#include <QList>
+
+#define ICON_DISK_CACHE_MAGIC 0x4449434f // "DICO"
+#define ICON_DISK_CACHE_VERSION 1
+
+struct icon_disk_header{
+  quint32 magic;
+  quint32 version;
+  qint64 stamp; //theme mtime (seconds since epoch) the pixels were rendered for
+  qint32 width;
+  qint32 height;
+  qint32 bytesPerLine;
+  qint32 reserved;
+};
+
+class LIconDiskCache{
+public:
+	//Cached pixmap for the icon (rendered through LIconCache on a miss, fallback icons are never stored)
+	// - cached: set to false if the pixmap is only a fallback and was not stored
+	static QPixmap pixmap(QString icon, int size, qreal scale = 1.0, QString theme = "", bool *cached = 0);
+	//Convenience: an icon assembled from the cached pixmaps
+	// - kept in memory per process until the theme changes, so repeated calls (tray updates) don't touch the disk
+	static QIcon icon(QString icon, QList<int> sizes = QList<int>() << 16 << 22 << 24 << 32 << 48);
+
+	//Raw access (mostly for the routines above)
+	static QString cachePath(QString icon, int size, qreal scale, QString theme);
+	static bool read(QString path, qint64 stamp, QPixmap *pix);
+	static bool write(QString path, qint64 stamp, QImage img);
+
+	//Newest modification time of the theme (and the themes it inherits)
+	// - index.theme and every directory it lists, so added/removed icons are noticed as well
+	static qint64 themeStamp(QString theme);
+	static void clear(QString theme = ""); //remove cached files (all themes if empty)
+
+private:
+	static QString cacheTheme(QString theme); //theme actually used for the lookups
+};
+
+#endif
@@ -6,10 +6,84 @@
 //===========================================
 #include "LuminaRandR.h"
 
+#include <QVector>
+
 //#include "X11/extensions/Xrandr.h"
 
+//The command-line modes of the screen settings run without a QApplication,
+//  so open a connection directly if Qt is not using X11
+static xcb_connection_t *RR_CONN = 0;
+static xcb_window_t RR_ROOT = 0;
+
+inline xcb_connection_t* rrConnection(){
+  if(RR_CONN!=0){ return RR_CONN; }
+  if(QX11Info::isPlatformX11()){
+    RR_CONN = QX11Info::connection();
+    RR_ROOT = QX11Info::appRootWindow();
+  }else{
+    int num = 0;
+    RR_CONN = xcb_connect(NULL, &num); //never NULL - requests on a failed connection just return no replies
+    xcb_screen_iterator_t it = xcb_setup_roots_iterator(xcb_get_setup(RR_CONN));
+    for(int i=0; i<num && it.rem>0; i++){ xcb_screen_next(&it); }
+    if(it.rem>0){ RR_ROOT = it.data->root; }
+  }
+  return RR_CONN;
+}
+
+inline xcb_window_t rrRoot(){
+  rrConnection();
+  return RR_ROOT;
+}
+
+inline int rotationToDegrees(uint16_t rot){
+  if(rot & XCB_RANDR_ROTATION_ROTATE_90){ return -90; } //"left"
+  else if(rot & XCB_RANDR_ROTATION_ROTATE_180){ return 180; } //"inverted"
+  else if(rot & XCB_RANDR_ROTATION_ROTATE_270){ return 90; } //"right"
+  return 0;
+}
+
+inline uint16_t degreesToRotation(int deg){
+  if(deg==-90){ return XCB_RANDR_ROTATION_ROTATE_90; }
+  else if(deg==180){ return XCB_RANDR_ROTATION_ROTATE_180; }
+  else if(deg==90){ return XCB_RANDR_ROTATION_ROTATE_270; }
+  return XCB_RANDR_ROTATION_ROTATE_0;
+}
+
+inline double modeRefresh(const xcb_randr_mode_info_t &minfo){
+  if(minfo.htotal==0 || minfo.vtotal==0){ return 0; }
+  return ( (double) minfo.dot_clock) / ( (double) minfo.htotal * minfo.vtotal);
+}
+
+//Pick the mode with the highest refresh rate for a resolution (empty resolution: preferred or largest mode)
+inline xcb_randr_mode_t pickMode(const p_objects &obj, QSize res, const QHash<xcb_randr_mode_t, xcb_randr_mode_info_t> &modes){
+  if(res.isEmpty() && !obj.preferred.isEmpty()){ return obj.preferred.first(); }
+  xcb_randr_mode_t det_mode = XCB_NONE;
+  double refreshrate = -1;
+  QSize big(0,0);
+  for(int i=0; i<obj.modes.length(); i++){
+    if(!modes.contains(obj.modes[i])){ continue; }
+    xcb_randr_mode_info_t minfo = modes.value(obj.modes[i]);
+    QSize sz(minfo.width, minfo.height);
+    if(res.isEmpty()){
+      if(sz.width()*sz.height() > big.width()*big.height()){ big = sz; det_mode = minfo.id; }
+    }else if(sz == res && modeRefresh(minfo) > refreshrate){
+      det_mode = minfo.id;
+      refreshrate = modeRefresh(minfo);
+    }
+  }
+  return det_mode;
+}
+
+inline bool sameOutputs(const QList<xcb_randr_output_t> &A, const QList<xcb_randr_output_t> &B){
+  if(A.length()!=B.length()){ return false; }
+  for(int i=0; i<A.length(); i++){
+    if(!B.contains(A[i])){ return false; }
+  }
+  return true;
+}
+
 inline QString atomToName(xcb_atom_t atom){
-  xcb_get_atom_name_reply_t *nreply = xcb_get_atom_name_reply(QX11Info::connection(), xcb_get_atom_name_unchecked(QX11Info::connection(), atom), NULL);
+  xcb_get_atom_name_reply_t *nreply = xcb_get_atom_name_reply(rrConnection(), xcb_get_atom_name_unchecked(rrConnection(), atom), NULL);
     QString name = QString::fromLocal8Bit(xcb_get_atom_name_name(nreply), xcb_get_atom_name_name_length(nreply));
     free(nreply);
   return name;
@@ -20,11 +94,11 @@ inline QStringList atomsToNames(xcb_atom_t *atoms, unsigned int num){
   //qDebug() << "atomsToNames:" << num;
   QList< xcb_get_atom_name_cookie_t > cookies;
   //qDebug() << " - Get cookies";
-  for(unsigned int i=0; i<num; i++){ cookies << xcb_get_atom_name_unchecked(QX11Info::connection(), atoms[i]);  }
+  for(unsigned int i=0; i<num; i++){ cookies << xcb_get_atom_name_unchecked(rrConnection(), atoms[i]);  }
   QStringList names;
   //qDebug() << " - Get names";
   for(int i=0; i<cookies.length(); i++){
-    xcb_get_atom_name_reply_t *nreply = xcb_get_atom_name_reply(QX11Info::connection(), cookies[i], NULL);
+    xcb_get_atom_name_reply_t *nreply = xcb_get_atom_name_reply(rrConnection(), cookies[i], NULL);
     if(nreply==0){ continue; }
       names << QString::fromLocal8Bit(xcb_get_atom_name_name(nreply), xcb_get_atom_name_name_length(nreply));
     free(nreply);
@@ -32,80 +106,10 @@ inline QStringList atomsToNames(xcb_atom_t *atoms, unsigned int num){
   return names;
 };
 
-inline bool loadScreenInfo(p_objects *p_obj){
-  //Reset the primary cached values (just in case things error out below and it can't finish)
-  p_obj->current_mode = 0;
-  p_obj->geometry = QRect();
-  p_obj->physicalSizeMM = QSize();
-  p_obj->primary = false;
-  p_obj->modes.clear();
-  p_obj->resolutions.clear();
-  p_obj->crtc = 0;
-
-  //Get the information associated with the output and save it in the p_objects cache
-  xcb_randr_get_output_info_reply_t *info = xcb_randr_get_output_info_reply(QX11Info::connection(),
-		xcb_randr_get_output_info_unchecked(QX11Info::connection(), p_obj->output, QX11Info::appTime()),
-		NULL);
-  if(info==0){ return false; } //bad output value
-  //First read off the information associated with the output itself
-  if(p_obj->name.isEmpty()){ p_obj->name = QString::fromLocal8Bit( (char*) xcb_randr_get_output_info_name(info), xcb_randr_get_output_info_name_length(info)); }
-  p_obj->physicalSizeMM = QSize(info->mm_width, info->mm_height);
-
-    //Modes
-    int mode_len = xcb_randr_get_output_info_modes_length(info);
-    for(int j=0; j<mode_len; j++){
-      p_obj->modes.append( xcb_randr_get_output_info_modes(info)[j] );
-    }
-    //int pref_len = info->num_preferred;
-    //qDebug() << "Modes:" << p_obj->modes << "Num Preferred:" << pref_len;
-    /*for(int j=0; j<pref_len; j++){
-      p_obj->preferred.append( xcb_randr_get_output_info_preferred(info)[j] );
-    }*/
-  p_obj->crtc = info->crtc;
-  free(info); //done with output_info
-
-  //Now load the current status of the output (crtc information)
-  xcb_randr_get_crtc_info_reply_t *cinfo = xcb_randr_get_crtc_info_reply(QX11Info::connection(),
-		xcb_randr_get_crtc_info_unchecked(QX11Info::connection(), p_obj->crtc, QX11Info::appTime()),
-		NULL);
-  if(cinfo!=0){
-    p_obj->geometry = QRect(cinfo->x, cinfo->y, cinfo->width, cinfo->height);
-    p_obj->current_mode = cinfo->mode;
-    free(cinfo); //done with crtc_info
-  }
-
-  if(!p_obj->modes.isEmpty()){
-    //And see if this output is currently the primary output
-    xcb_randr_get_output_primary_reply_t *preply = xcb_randr_get_output_primary_reply(QX11Info::connection(),
-		xcb_randr_get_output_primary_unchecked(QX11Info::connection(), QX11Info::appRootWindow()), NULL);
-
-    if(preply !=0){
-      p_obj->primary = (preply->output == p_obj->output);
-      free(preply);
-    }
-
-    //Now load all the screen resources information, and find matches for the current modes
-    xcb_randr_get_screen_resources_reply_t *srreply = xcb_randr_get_screen_resources_reply(QX11Info::connection(),
-		xcb_randr_get_screen_resources_unchecked(QX11Info::connection(), QX11Info::appRootWindow()), NULL);
-    if(srreply!=0){
-      for(int i=0; i<xcb_randr_get_screen_resources_modes_length(srreply); i++){
-        xcb_randr_mode_info_t minfo = xcb_randr_get_screen_resources_modes(srreply)[i];
-        if(p_obj->modes.contains(minfo.id)){
-          QSize sz(minfo.width, minfo.height);
-          if(!p_obj->resolutions.contains(sz)){ p_obj->resolutions.append( sz); }
-        }
-      }
-      free(srreply);
-    }
-  }
-  return true;
-}
-
-
 inline xcb_randr_mode_t modeForResolution(QSize res, QList<xcb_randr_mode_t> modes){
   xcb_randr_mode_t det_mode = XCB_NONE;
-  xcb_randr_get_screen_resources_reply_t *srreply = xcb_randr_get_screen_resources_reply(QX11Info::connection(),
-		xcb_randr_get_screen_resources_unchecked(QX11Info::connection(), QX11Info::appRootWindow()), NULL);
+  xcb_randr_get_screen_resources_reply_t *srreply = xcb_randr_get_screen_resources_reply(rrConnection(),
+		xcb_randr_get_screen_resources_unchecked(rrConnection(), rrRoot()), NULL);
   if(srreply!=0){
     unsigned int refreshrate = 0;
     QSize sz;
@@ -132,8 +136,8 @@ inline xcb_randr_mode_t modeForResolution(QSize res, QList<xcb_randr_mode_t> mod
 
 inline void adjustScreenTotal(xcb_randr_crtc_t output, QRect geom, bool addingoutput){
   QRect total, mmTotal;
-  xcb_randr_get_screen_resources_reply_t *srreply = xcb_randr_get_screen_resources_reply(QX11Info::connection(),
-		xcb_randr_get_screen_resources_unchecked(QX11Info::connection(), QX11Info::appRootWindow()), NULL);
+  xcb_randr_get_screen_resources_reply_t *srreply = xcb_randr_get_screen_resources_reply(rrConnection(),
+		xcb_randr_get_screen_resources_unchecked(rrConnection(), rrRoot()), NULL);
   if(srreply!=0){
     for(int i=0; i<xcb_randr_get_screen_resources_crtcs_length(srreply); i++){
       xcb_randr_crtc_t crtc = xcb_randr_get_screen_resources_crtcs(srreply)[i];
@@ -145,8 +149,8 @@ inline void adjustScreenTotal(xcb_randr_crtc_t output, QRect geom, bool addingou
         //ignore the output if we just removed it
       }else{
         //Get the current geometry of this crtc (if available) and add it to the total
-        xcb_randr_get_crtc_info_reply_t *cinfo = xcb_randr_get_crtc_info_reply(QX11Info::connection(),
-		xcb_randr_get_crtc_info_unchecked(QX11Info::connection(), crtc, QX11Info::appTime()),
+        xcb_randr_get_crtc_info_reply_t *cinfo = xcb_randr_get_crtc_info_reply(rrConnection(),
+		xcb_randr_get_crtc_info_unchecked(rrConnection(), crtc, XCB_CURRENT_TIME),
 		NULL);
         if(cinfo!=0){
           total = total.united( QRect(cinfo->x, cinfo->y, cinfo->width, cinfo->height) );
@@ -159,7 +163,7 @@ inline void adjustScreenTotal(xcb_randr_crtc_t output, QRect geom, bool addingou
   }
   QSize newRes = total.size();
   QSize newMM = mmTotal.size();
-  xcb_randr_set_screen_size(QX11Info::connection(), QX11Info::appRootWindow(), newRes.width(), newRes.height(), newMM.width(), newMM.height());
+  xcb_randr_set_screen_size(rrConnection(), rrRoot(), newRes.width(), newRes.height(), newMM.width(), newMM.height());
 }
 
 inline bool showOutput(QRect geom, p_objects *p_obj){
@@ -170,14 +174,14 @@ inline bool showOutput(QRect geom, p_objects *p_obj){
   //qDebug() << " - Found Mode:" << mode;
   if(p_obj->crtc == 0){
     //Need to scan for an available crtc to use (turning on a monitor for the first time)
-    xcb_randr_get_screen_resources_reply_t *reply = xcb_randr_get_screen_resources_reply(QX11Info::connection(),
-		xcb_randr_get_screen_resources_unchecked(QX11Info::connection(), QX11Info::appRootWindow()),
+    xcb_randr_get_screen_resources_reply_t *reply = xcb_randr_get_screen_resources_reply(rrConnection(),
+		xcb_randr_get_screen_resources_unchecked(rrConnection(), rrRoot()),
 		NULL);
     int num = xcb_randr_get_screen_resources_crtcs_length(reply);
     for(int i=0; i<num && p_obj->crtc==0; i++){
       xcb_randr_crtc_t crt = xcb_randr_get_screen_resources_crtcs(reply)[i];
-      xcb_randr_get_crtc_info_reply_t *info = xcb_randr_get_crtc_info_reply(QX11Info::connection(),
-		xcb_randr_get_crtc_info_unchecked(QX11Info::connection(), crt, QX11Info::appTime()),
+      xcb_randr_get_crtc_info_reply_t *info = xcb_randr_get_crtc_info_reply(rrConnection(),
+		xcb_randr_get_crtc_info_unchecked(rrConnection(), crt, XCB_CURRENT_TIME),
 		NULL);
       //Verify that the output is supported by this crtc
       QList<xcb_randr_output_t> possible;
@@ -198,10 +202,10 @@ if(p_obj->crtc == 0){ qDebug() << "[ERROR] No Available CRTC devices for display
   //qDebug() << " - Using mode:" << mode;
   xcb_randr_output_t outList[1]{ p_obj->output };
 
-  xcb_randr_set_crtc_config_cookie_t cookie = xcb_randr_set_crtc_config_unchecked(QX11Info::connection(), p_obj->crtc,
+  xcb_randr_set_crtc_config_cookie_t cookie = xcb_randr_set_crtc_config_unchecked(rrConnection(), p_obj->crtc,
 		XCB_CURRENT_TIME, XCB_CURRENT_TIME, geom.x(), geom.y(), mode, XCB_RANDR_ROTATION_ROTATE_0, 1, outList);
     //Now check the result of the configuration
-    xcb_randr_set_crtc_config_reply_t *reply = xcb_randr_set_crtc_config_reply(QX11Info::connection(), cookie, NULL);
+    xcb_randr_set_crtc_config_reply_t *reply = xcb_randr_set_crtc_config_reply(rrConnection(), cookie, NULL);
     bool ok = false;
     if(reply!=0){ ok = (reply->status == XCB_RANDR_SET_CONFIG_SUCCESS); }
     free(reply);
@@ -211,8 +215,8 @@ if(p_obj->crtc == 0){ qDebug() << "[ERROR] No Available CRTC devices for display
     //Clones
     qDebug() << "Number of Clones:" << xcb_randr_get_output_info_clones_length(info);
     //Properties
-    xcb_randr_list_output_properties_reply_t *pinfo = xcb_randr_list_output_properties_reply(QX11Info::connection(),
-		xcb_randr_list_output_properties_unchecked(QX11Info::connection(), output),
+    xcb_randr_list_output_properties_reply_t *pinfo = xcb_randr_list_output_properties_reply(rrConnection(),
+		xcb_randr_list_output_properties_unchecked(rrConnection(), output),
 		NULL);
     int pinfo_len = xcb_randr_list_output_properties_atoms_length(pinfo);
     qDebug() << "Properties:" << pinfo_len;
@@ -221,8 +225,8 @@ if(p_obj->crtc == 0){ qDebug() << "[ERROR] No Available CRTC devices for display
       //Property Name
       QString name = atomToName(atom);
       //Property Value
-      xcb_randr_query_output_property_reply_t *pvalue = xcb_randr_query_output_property_reply(QX11Info::connection(),
-		xcb_randr_query_output_property_unchecked(QX11Info::connection(), output, atom),
+      xcb_randr_query_output_property_reply_t *pvalue = xcb_randr_query_output_property_reply(rrConnection(),
+		xcb_randr_query_output_property_unchecked(rrConnection(), output, atom),
 		NULL);
       QStringList values = atomsToNames ( (xcb_atom_t*) xcb_randr_query_output_property_valid_values(pvalue), xcb_randr_query_output_property_valid_values_length(pvalue) ); //need to read values
       free(pvalue);
@@ -236,6 +240,10 @@ OutputDevice::OutputDevice(QString id){
   //p_obj = new p_objects();
   p_obj.name = id;
   p_obj.primary = false;
+  p_obj.connected = false;
+  p_obj.rotation = 0;
+  p_obj.crtc = 0;
+  p_obj.current_mode = 0;
   p_obj.output = 0;
   bool ok = false;
   p_obj.output = id.toInt(&ok);
@@ -246,6 +254,10 @@ OutputDevice::OutputDevice(QString id){
   updateInfoCache();
 }
 
+OutputDevice::OutputDevice(const p_objects &obj){
+  p_obj = obj;
+}
+
 OutputDevice::~OutputDevice(){
   //delete p_obj;
 }
@@ -254,11 +266,17 @@ OutputDevice::~OutputDevice(){
 QString OutputDevice::ID(){ return p_obj.name; }
 bool OutputDevice::isEnabled(){ return !p_obj.geometry.isNull(); }
 bool OutputDevice::isPrimary(){ return p_obj.primary; }
-bool OutputDevice::isConnected(){ return !p_obj.modes.isEmpty(); }
+bool OutputDevice::isConnected(){ return p_obj.connected; }
 
 QList<QSize> OutputDevice::availableResolutions(){ return p_obj.resolutions; }
 QSize OutputDevice::currentResolution(){ return p_obj.geometry.size(); } //no concept of panning/scaling yet
+QSize OutputDevice::preferredResolution(){
+  //The resolutions are listed in the same order as the modes (preferred modes first)
+  if(p_obj.preferred.isEmpty() || p_obj.resolutions.isEmpty()){ return QSize(); }
+  return p_obj.resolutions.first();
+}
 QRect OutputDevice::currentGeometry(){ return p_obj.geometry; }
+int OutputDevice::currentRotation(){ return p_obj.rotation; }
 QSize OutputDevice::physicalSizeMM(){ return p_obj.physicalSizeMM; }
 QSize OutputDevice::physicalDPI(){
   QSize dpi( qRound((p_obj.geometry.width() * 25.4)/p_obj.physicalSizeMM.width()), qRound((p_obj.geometry.height() * 25.4)/p_obj.physicalSizeMM.height() ) );
@@ -268,7 +286,7 @@ QSize OutputDevice::physicalDPI(){
 //Modification
 bool OutputDevice::setAsPrimary(bool set){
   if(p_obj.primary == set){ return true; } //no change needed
-    if(set){ xcb_randr_set_output_primary (QX11Info::connection(), QX11Info::appRootWindow(), p_obj.output); }
+    if(set){ xcb_randr_set_output_primary (rrConnection(), rrRoot(), p_obj.output); }
     p_obj.primary = set; //Only need to push a "set" primary up through XCB - will automatically deactivate the other monitors
   return true;
 }
@@ -276,10 +294,10 @@ bool OutputDevice::setAsPrimary(bool set){
 bool OutputDevice::disable(){
   if(p_obj.output!=0 && p_obj.current_mode!=0 && p_obj.crtc!=0){
     //qDebug() << " - Go ahead";
-    xcb_randr_set_crtc_config_cookie_t cookie = xcb_randr_set_crtc_config_unchecked(QX11Info::connection(), p_obj.crtc,
+    xcb_randr_set_crtc_config_cookie_t cookie = xcb_randr_set_crtc_config_unchecked(rrConnection(), p_obj.crtc,
 		XCB_CURRENT_TIME, XCB_CURRENT_TIME, 0, 0, XCB_NONE, XCB_RANDR_ROTATION_ROTATE_0, 0, NULL);
     //Now check the result of the configuration
-    xcb_randr_set_crtc_config_reply_t *reply = xcb_randr_set_crtc_config_reply(QX11Info::connection(), cookie, NULL);
+    xcb_randr_set_crtc_config_reply_t *reply = xcb_randr_set_crtc_config_reply(rrConnection(), cookie, NULL);
     if(reply==0){ return false; }
     bool ok = (reply->status == XCB_RANDR_SET_CONFIG_SUCCESS);
     free(reply);
@@ -312,44 +330,131 @@ bool OutputDevice::setGeometry(QRect geom){
 }
 
 void OutputDevice::updateInfoCache(){
-  if(p_obj.output==0){
-      //Only have a name (first run) - need to find the corresponding output for this ID
-      xcb_randr_get_screen_resources_reply_t *reply = xcb_randr_get_screen_resources_reply(QX11Info::connection(),
-		xcb_randr_get_screen_resources_unchecked(QX11Info::connection(), QX11Info::appRootWindow()),
-		NULL);
-    int outputnum = xcb_randr_get_screen_resources_outputs_length(reply);
-    for(int i=0; i<outputnum; i++){
-      xcb_randr_output_t output = xcb_randr_get_screen_resources_outputs(reply)[i];
-      xcb_randr_get_output_info_reply_t *info = xcb_randr_get_output_info_reply(QX11Info::connection(),
-		xcb_randr_get_output_info_unchecked(QX11Info::connection(), output, QX11Info::appTime()),
-		NULL);
-      //Compare names
-      QString name = QString::fromLocal8Bit( (char*) xcb_randr_get_output_info_name(info), xcb_randr_get_output_info_name_length(info));
-      free(info);
-      if(name == p_obj.name){ p_obj.output = output; break; }
+  //Load the state of all the outputs in one batch (no probe) and pick out this one
+  OutputDeviceList list(false);
+  for(int i=0; i<list.length(); i++){
+    OutputDevice *dev = list.at(i);
+    if( (p_obj.output!=0 && dev->p_obj.output == p_obj.output) || (p_obj.output==0 && dev->ID() == p_obj.name) ){
+      p_obj = dev->p_obj;
+      return;
     }
-    free(reply);
   }
-  if(p_obj.output == 0){ return; } //bad ID/output?
-  loadScreenInfo(&p_obj);
 }
 
 // ============================
 //             OutputDeviceList
 // ============================
 
-OutputDeviceList::OutputDeviceList(){
-  xcb_randr_get_screen_resources_reply_t *reply = xcb_randr_get_screen_resources_reply(QX11Info::connection(),
-		xcb_randr_get_screen_resources_unchecked(QX11Info::connection(), QX11Info::appRootWindow()),
-		NULL);
-  if(reply==0){ return; } //could not get screen information
-  int outputnum = xcb_randr_get_screen_resources_outputs_length(reply);
-  for(int i=0; i<outputnum; i++){
-    xcb_randr_output_t output = xcb_randr_get_screen_resources_outputs(reply)[i];
-    OutputDevice dev(QString::number(output)); //use the raw output integer
-    out_devs.append(dev); //add to the internal list
+OutputDeviceList::OutputDeviceList(bool probe){
+  loadDevices(probe);
+}
+
+//Read the full output/crtc/mode state from the server.
+//Everything after the screen resources is sent as a single batch of requests before any reply is read
+void OutputDeviceList::loadDevices(bool probe){
+  xcb_connection_t *conn = rrConnection();
+  out_devs.clear();
+  crtcs.clear();
+  modes.clear();
+  config_time = XCB_CURRENT_TIME;
+  QList<xcb_randr_output_t> outputs;
+  QList<xcb_randr_crtc_t> crtclist;
+  if(probe){
+    //Full query - has the server re-scan the hardware for monitor changes
+    xcb_randr_get_screen_resources_reply_t *reply = xcb_randr_get_screen_resources_reply(conn,
+		xcb_randr_get_screen_resources_unchecked(conn, rrRoot()), NULL);
+    if(reply==0){ return; } //could not get screen information
+    config_time = reply->config_timestamp;
+    for(int i=0; i<xcb_randr_get_screen_resources_outputs_length(reply); i++){ outputs << xcb_randr_get_screen_resources_outputs(reply)[i]; }
+    for(int i=0; i<xcb_randr_get_screen_resources_crtcs_length(reply); i++){ crtclist << xcb_randr_get_screen_resources_crtcs(reply)[i]; }
+    for(int i=0; i<xcb_randr_get_screen_resources_modes_length(reply); i++){
+      xcb_randr_mode_info_t minfo = xcb_randr_get_screen_resources_modes(reply)[i];
+      modes.insert(minfo.id, minfo);
+    }
+    free(reply);
+  }else{
+    //Current configuration only (cheap)
+    xcb_randr_get_screen_resources_current_reply_t *reply = xcb_randr_get_screen_resources_current_reply(conn,
+		xcb_randr_get_screen_resources_current_unchecked(conn, rrRoot()), NULL);
+    if(reply==0){ return; } //could not get screen information
+    config_time = reply->config_timestamp;
+    for(int i=0; i<xcb_randr_get_screen_resources_current_outputs_length(reply); i++){ outputs << xcb_randr_get_screen_resources_current_outputs(reply)[i]; }
+    for(int i=0; i<xcb_randr_get_screen_resources_current_crtcs_length(reply); i++){ crtclist << xcb_randr_get_screen_resources_current_crtcs(reply)[i]; }
+    for(int i=0; i<xcb_randr_get_screen_resources_current_modes_length(reply); i++){
+      xcb_randr_mode_info_t minfo = xcb_randr_get_screen_resources_current_modes(reply)[i];
+      modes.insert(minfo.id, minfo);
+    }
+    free(reply);
+  }
+  //Send all the requests
+  QList<xcb_randr_get_crtc_info_cookie_t> ccookies;
+  for(int i=0; i<crtclist.length(); i++){ ccookies << xcb_randr_get_crtc_info_unchecked(conn, crtclist[i], config_time); }
+  QList<xcb_randr_get_output_info_cookie_t> ocookies;
+  for(int i=0; i<outputs.length(); i++){ ocookies << xcb_randr_get_output_info_unchecked(conn, outputs[i], config_time); }
+  xcb_randr_get_output_primary_cookie_t pcookie = xcb_randr_get_output_primary_unchecked(conn, rrRoot());
+  xcb_randr_get_screen_size_range_cookie_t rcookie = xcb_randr_get_screen_size_range_unchecked(conn, rrRoot());
+  xcb_get_geometry_cookie_t gcookie = xcb_get_geometry_unchecked(conn, rrRoot());
+
+  //Now read the replies
+  for(int i=0; i<ccookies.length(); i++){
+    xcb_randr_get_crtc_info_reply_t *cinfo = xcb_randr_get_crtc_info_reply(conn, ccookies[i], NULL);
+    if(cinfo==0){ continue; }
+    p_crtc crt;
+    crt.mode = cinfo->mode;
+    if(crt.mode!=XCB_NONE){ crt.geometry = QRect(cinfo->x, cinfo->y, cinfo->width, cinfo->height); }
+    crt.rotation = cinfo->rotation;
+    crt.rotations = cinfo->rotations;
+    for(int j=0; j<xcb_randr_get_crtc_info_outputs_length(cinfo); j++){ crt.outputs << xcb_randr_get_crtc_info_outputs(cinfo)[j]; }
+    crtcs.insert(crtclist[i], crt);
+    free(cinfo);
+  }
+  xcb_randr_output_t primary = XCB_NONE;
+  xcb_randr_get_output_primary_reply_t *preply = xcb_randr_get_output_primary_reply(conn, pcookie, NULL);
+  if(preply!=0){ primary = preply->output; free(preply); }
+  xcb_randr_get_screen_size_range_reply_t *rreply = xcb_randr_get_screen_size_range_reply(conn, rcookie, NULL);
+  if(rreply!=0){
+    minSize = QSize(rreply->min_width, rreply->min_height);
+    maxSize = QSize(rreply->max_width, rreply->max_height);
+    free(rreply);
+  }
+  xcb_get_geometry_reply_t *greply = xcb_get_geometry_reply(conn, gcookie, NULL);
+  if(greply!=0){ screenSize = QSize(greply->width, greply->height); free(greply); }
+
+  for(int i=0; i<ocookies.length(); i++){
+    xcb_randr_get_output_info_reply_t *info = xcb_randr_get_output_info_reply(conn, ocookies[i], NULL);
+    if(info==0){ continue; } //bad output value
+    p_objects obj;
+    obj.output = outputs[i];
+    obj.name = QString::fromLocal8Bit( (char*) xcb_randr_get_output_info_name(info), xcb_randr_get_output_info_name_length(info));
+    obj.physicalSizeMM = QSize(info->mm_width, info->mm_height);
+    obj.connected = (info->connection == XCB_RANDR_CONNECTION_CONNECTED);
+    obj.primary = (obj.output == primary);
+    int mode_len = xcb_randr_get_output_info_modes_length(info);
+    for(int j=0; j<mode_len; j++){
+      obj.modes << xcb_randr_get_output_info_modes(info)[j];
+      if(j < info->num_preferred){ obj.preferred << obj.modes.last(); }
+    }
+    for(int j=0; j<xcb_randr_get_output_info_crtcs_length(info); j++){ obj.crtcs << xcb_randr_get_output_info_crtcs(info)[j]; }
+    obj.crtc = info->crtc;
+    free(info); //done with output_info
+    //Current status of the output (crtc information)
+    obj.current_mode = 0;
+    obj.rotation = 0;
+    if(crtcs.contains(obj.crtc)){
+      p_crtc crt = crtcs.value(obj.crtc);
+      obj.geometry = crt.geometry;
+      obj.current_mode = crt.mode;
+      obj.rotation = rotationToDegrees(crt.rotation);
+    }
+    //Unique resolutions (same order as the modes)
+    for(int j=0; j<obj.modes.length(); j++){
+      if(!modes.contains(obj.modes[j])){ continue; }
+      xcb_randr_mode_info_t minfo = modes.value(obj.modes[j]);
+      QSize sz(minfo.width, minfo.height);
+      if(!obj.resolutions.contains(sz)){ obj.resolutions << sz; }
+    }
+    out_devs << OutputDevice(obj);
   }
-  free(reply);
 }
 
 OutputDeviceList::~OutputDeviceList(){
@@ -393,3 +498,119 @@ bool OutputDeviceList::enableMonitor(QString id, QRect geom){
   }
   return ok;
 }
+
+bool OutputDeviceList::applyLayout(QList<output_config> layout){
+  xcb_connection_t *conn = rrConnection();
+  QHash<xcb_randr_crtc_t, p_crtc> target = crtcs;
+  //Find the devices and detach all of them from their current crtcs first
+  QList<p_objects*> objs;
+  for(int i=0; i<layout.length(); i++){
+    p_objects *obj = 0;
+    for(int j=0; j<out_devs.length() && obj==0; j++){
+      if(out_devs[j].ID() == layout[i].id){ obj = &out_devs[j].p_obj; }
+    }
+    if(obj==0){ qDebug() << "[ERROR] Unknown monitor:" << layout[i].id; return false; }
+    objs << obj;
+    if(obj->crtc!=0 && target.contains(obj->crtc)){
+      p_crtc &crt = target[obj->crtc];
+      crt.outputs.removeAll(obj->output);
+      if(crt.outputs.isEmpty()){ crt.mode = XCB_NONE; crt.geometry = QRect(); }
+    }
+  }
+  //Now assign modes/crtcs for the enabled outputs
+  xcb_randr_output_t primary = XCB_NONE;
+  for(int i=0; i<layout.length(); i++){
+    if(!layout[i].enabled){ continue; }
+    p_objects *obj = objs[i];
+    //Rotated monitors might be given with either the mode size or the rotated size
+    QSize res = layout[i].geometry.size();
+    bool sideways = (layout[i].rotation==90 || layout[i].rotation==-90);
+    xcb_randr_mode_t mode = XCB_NONE;
+    if(obj->current_mode!=XCB_NONE && obj->rotation==layout[i].rotation && obj->geometry.size()==res){ mode = obj->current_mode; } //keep the current mode (and refresh rate)
+    else if(sideways && !res.isEmpty()){ mode = pickMode(*obj, res.transposed(), modes); }
+    if(mode==XCB_NONE){ mode = pickMode(*obj, res, modes); }
+    if(mode==XCB_NONE){ qDebug() << "[ERROR] Invalid resolution for monitor:" << layout[i].id << res; return false; }
+    uint16_t rot = degreesToRotation(layout[i].rotation);
+    //Keep the current crtc if possible, otherwise find a free one
+    QList<xcb_randr_crtc_t> options = obj->crtcs;
+    if(obj->crtc!=0){ options.prepend(obj->crtc); }
+    xcb_randr_crtc_t crtc = XCB_NONE;
+    for(int j=0; j<options.length() && crtc==XCB_NONE; j++){
+      if(!target.contains(options[j])){ continue; }
+      if(target[options[j]].mode!=XCB_NONE || !target[options[j]].outputs.isEmpty()){ continue; } //in use
+      if( (target[options[j]].rotations & rot) == 0 ){ continue; } //rotation not supported
+      crtc = options[j];
+    }
+    if(crtc==XCB_NONE){ qDebug() << "[ERROR] No Available CRTC devices for display:" << layout[i].id; return false; }
+    xcb_randr_mode_info_t minfo = modes.value(mode);
+    QSize sz(minfo.width, minfo.height);
+    if(sideways){ sz.transpose(); }
+    p_crtc &crt = target[crtc];
+    crt.mode = mode;
+    crt.rotation = rot;
+    crt.geometry = QRect(layout[i].geometry.topLeft(), sz);
+    crt.outputs << obj->output;
+    if(layout[i].primary){ primary = obj->output; }
+  }
+
+  //Figure out which crtcs change and the new size of the screen
+  QList<xcb_randr_crtc_t> changed;
+  QRect total;
+  QList<xcb_randr_crtc_t> ids = target.keys();
+  for(int i=0; i<ids.length(); i++){
+    p_crtc now = crtcs.value(ids[i]);
+    p_crtc next = target.value(ids[i]);
+    if(next.mode!=XCB_NONE){ total = total.united(next.geometry); }
+    if(now.mode!=next.mode || now.geometry!=next.geometry || now.rotation!=next.rotation || !sameOutputs(now.outputs, next.outputs)){ changed << ids[i]; }
+  }
+  if(total.isEmpty()){ qDebug() << "[ERROR] Layout would disable all monitors"; return false; } //never disable all screens
+  QSize size = QSize(total.right()+1, total.bottom()+1).expandedTo(minSize);
+  if(maxSize.isValid() && (size.width() > maxSize.width() || size.height() > maxSize.height()) ){
+    qDebug() << "[ERROR] Layout is larger than the maximum screen size:" << size << maxSize;
+    return false;
+  }
+  xcb_randr_output_t oldprimary = XCB_NONE;
+  for(int i=0; i<out_devs.length(); i++){
+    if(out_devs[i].isPrimary()){ oldprimary = out_devs[i].p_obj.output; }
+  }
+  if(primary == oldprimary){ primary = XCB_NONE; }
+  if(changed.isEmpty() && size==screenSize && primary==XCB_NONE){ return true; } //nothing to do
+
+  //Push the whole change while the server is grabbed so clients never see the intermediate states
+  QRect screen(QPoint(0,0), size);
+  QList<xcb_randr_set_crtc_config_cookie_t> cookies;
+  xcb_grab_server(conn);
+  //Turn off the crtcs which are going away, or which would not fit within the new screen size
+  for(int i=0; i<changed.length(); i++){
+    p_crtc now = crtcs.value(changed[i]);
+    if(now.mode==XCB_NONE){ continue; } //already off
+    if(target[changed[i]].mode!=XCB_NONE && screen.contains(now.geometry)){ continue; } //can be changed in place
+    cookies << xcb_randr_set_crtc_config_unchecked(conn, changed[i], XCB_CURRENT_TIME, config_time,
+		0, 0, XCB_NONE, XCB_RANDR_ROTATION_ROTATE_0, 0, NULL);
+  }
+  if(size!=screenSize){
+    //Use the same 96 DPI that the X server defaults to for the physical size
+    xcb_randr_set_screen_size(conn, rrRoot(), size.width(), size.height(), qRound(size.width()*25.4/96), qRound(size.height()*25.4/96));
+  }
+  for(int i=0; i<changed.length(); i++){
+    p_crtc next = target.value(changed[i]);
+    if(next.mode==XCB_NONE){ continue; }
+    QVector<xcb_randr_output_t> outList = next.outputs.toVector();
+    cookies << xcb_randr_set_crtc_config_unchecked(conn, changed[i], XCB_CURRENT_TIME, config_time,
+		next.geometry.x(), next.geometry.y(), next.mode, next.rotation, outList.length(), outList.data());
+  }
+  if(primary!=XCB_NONE){ xcb_randr_set_output_primary(conn, rrRoot(), primary); }
+  xcb_ungrab_server(conn);
+  xcb_flush(conn);
+
+  //Now check the results of the configuration
+  bool ok = true;
+  for(int i=0; i<cookies.length(); i++){
+    xcb_randr_set_crtc_config_reply_t *reply = xcb_randr_set_crtc_config_reply(conn, cookies[i], NULL);
+    if(reply==0 || reply->status != XCB_RANDR_SET_CONFIG_SUCCESS){ ok = false; }
+    free(reply);
+  }
+  if(!ok){ qDebug() << "[ERROR] Could not apply the monitor layout"; }
+  loadDevices(false); //refresh the cached information
+  return ok;
+}
@@ -16,6 +16,7 @@
 #include <QPoint>
 #include <QRect>
 #include <QList>
+#include <QHash>
 #include <QObject>
 #include <QDebug>
 #include <QX11Info>
@@ -37,8 +38,32 @@ struct p_objects{
 
 	xcb_randr_mode_t current_mode;
 	QList<xcb_randr_mode_t> modes; //each mode is a combination of resolution + refresh rate
+	QList<xcb_randr_mode_t> preferred; //subset of modes which the monitor reports as preferred
 	QList<QSize> resolutions; //smaller subset of modes - just unique resolutions
+	QList<xcb_randr_crtc_t> crtcs; //crtcs which are able to drive this output
 
+	bool connected;
+	int rotation; //[-90: left, 0: normal, 90: right, 180: inverted]
+};
+
+//Current state of a single crtc (used when applying a full layout at once)
+struct p_crtc{
+	QRect geometry;
+	xcb_randr_mode_t mode;
+	uint16_t rotation; //XCB_RANDR_ROTATION_* value
+	uint16_t rotations; //mask of the supported rotations
+	QList<xcb_randr_output_t> outputs;
+};
+
+//Requested configuration for a single output (see OutputDeviceList::applyLayout)
+struct output_config{
+	QString id;
+	bool enabled;
+	bool primary;
+	QRect geometry; //an empty size will use the preferred mode of the output
+	int rotation; //[-90: left, 0: normal, 90: right, 180: inverted]
+
+	output_config(){ enabled = true; primary = false; rotation = 0; }
 };
 
 class OutputDevice{
@@ -57,6 +82,7 @@ public:
 
 	//FUNCTIONS (do not use directly - use the static list function instead)
 	OutputDevice(QString id);
+	OutputDevice(const p_objects &obj); //use information which was already loaded (OutputDeviceList)
 	~OutputDevice();
 
 	//Information
@@ -67,7 +93,9 @@ public:
 	bool isConnected();
 	QList<QSize> availableResolutions();
 	QSize currentResolution(); //could be different from geometry.size() if things like panning/rotation are enabled
+	QSize preferredResolution();
 	QRect currentGeometry();
+	int currentRotation();
 	QSize physicalSizeMM();
 	QSize physicalDPI();
 
@@ -91,8 +119,16 @@ class OutputDeviceList{
 private:
 	QList<OutputDevice> out_devs;
 
+	//Cached server state from the last query (used by applyLayout)
+	xcb_timestamp_t config_time;
+	QHash<xcb_randr_crtc_t, p_crtc> crtcs;
+	QHash<xcb_randr_mode_t, xcb_randr_mode_info_t> modes;
+	QSize screenSize, minSize, maxSize;
+
+	void loadDevices(bool probe);
+
 public:
-	OutputDeviceList();
+	OutputDeviceList(bool probe = true); //probe: have the server re-scan for new/removed monitors
 	~OutputDeviceList();
 
 	int length(){ return out_devs.length(); }
@@ -109,5 +145,9 @@ public:
 	bool disableMonitor(QString id);
 	bool enableMonitor(QString id, QRect geom);
 
+	//Apply the configuration of several outputs as a single change on the server
+	//Outputs which are not listed are left as-is
+	bool applyLayout(QList<output_config> layout);
+
 };
 #endif
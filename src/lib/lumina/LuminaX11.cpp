@@ -14,6 +14,11 @@
 #include <QApplication>
 #include <QDesktopWidget>
 #include <QScreen>
+#include <QVector>
+
+#include <string.h> //for memcpy()
+#include <sys/ipc.h>
+#include <sys/shm.h>
 
 
 
@@ -27,6 +32,7 @@
 #include <xcb/xcb_aux.h>
 #include <xcb/composite.h>
 #include <xcb/damage.h>
+#include <xcb/shm.h>
 
 //XLib includes
 #include <X11/extensions/Xdamage.h>
@@ -45,11 +51,139 @@ LXCB::LXCB(){
    }else{
      qDebug() << "Number of XCB screens:" << EWMH.nb_screens;
    }
+   rootPixmap = 0;
+   initShm();
 }
 LXCB::~LXCB(){
+  releaseShm();
   xcb_ewmh_connection_wipe(&EWMH);
 }
 
+// private function
+void LXCB::initShm(){
+  shmAvailable = false;
+  shmSeg = 0;
+  shmId = -1;
+  shmData = 0;
+  shmSize = 0;
+  const xcb_query_extension_reply_t *ext = xcb_get_extension_data(QX11Info::connection(), &xcb_shm_id);
+  if(ext==0 || !ext->present){ return; }
+  xcb_shm_query_version_reply_t *reply = xcb_shm_query_version_reply(QX11Info::connection(), \
+			xcb_shm_query_version(QX11Info::connection()), NULL);
+  if(reply==0){ return; }
+  free(reply);
+  //Make sure the server can actually see our memory (not a remote display)
+  shmAvailable = reserveShm(4096);
+}
+
+// private function
+bool LXCB::reserveShm(size_t bytes){
+  if(shmData!=0 && bytes<=shmSize){ return true; }
+  releaseShm();
+  int id = shmget(IPC_PRIVATE, bytes, IPC_CREAT | 0600);
+  if(id<0){ return false; }
+  void *data = shmat(id, 0, 0);
+  if(data == (void*) -1){ shmctl(id, IPC_RMID, 0); return false; }
+  xcb_shm_seg_t seg = xcb_generate_id(QX11Info::connection());
+  xcb_generic_error_t *err = xcb_request_check(QX11Info::connection(), \
+			xcb_shm_attach_checked(QX11Info::connection(), seg, id, 0));
+  shmctl(id, IPC_RMID, 0); //gone as soon as both sides detach
+  if(err!=0){ free(err); shmdt(data); return false; }
+  shmSeg = seg;
+  shmId = id;
+  shmData = (uint8_t*) data;
+  shmSize = bytes;
+  return true;
+}
+
+// private function
+void LXCB::releaseShm(){
+  if(shmData==0){ return; }
+  xcb_shm_detach(QX11Info::connection(), shmSeg);
+  shmdt(shmData);
+  shmSeg = 0;
+  shmId = -1;
+  shmData = 0;
+  shmSize = 0;
+}
+
+// private function
+bool LXCB::imageFormatOK(uint8_t depth){
+  if(depth!=24 && depth!=32){ return false; }
+  const xcb_setup_t *setup = xcb_get_setup(QX11Info::connection());
+  bool local = (QSysInfo::ByteOrder == QSysInfo::LittleEndian) == (setup->image_byte_order == XCB_IMAGE_ORDER_LSB_FIRST);
+  if(!local){ return false; }
+  xcb_format_iterator_t it = xcb_setup_pixmap_formats_iterator(setup);
+  for(; it.rem; xcb_format_next(&it)){
+    if(it.data->depth == depth){ return (it.data->bits_per_pixel == 32); }
+  }
+  return false;
+}
+
+// private function
+QByteArray LXCB::windowProperty(WId win, xcb_atom_t atom, xcb_atom_t type, uint8_t format){
+  //Only windows which report their property changes can be cached
+  bool cache = WATCHED.contains(win);
+  if(cache){
+    QHash<WId, QHash<xcb_atom_t, QByteArray> >::const_iterator it = PROPCACHE.constFind(win);
+    if(it!=PROPCACHE.constEnd() && it.value().contains(atom)){ return it.value().value(atom); }
+  }
+  QByteArray data;
+  uint32_t offset = 0, length = 1024; //in 32-bit units, most values fit into the first request
+  while(true){
+    xcb_get_property_cookie_t cookie = xcb_get_property_unchecked(QX11Info::connection(), 0, win, atom, type, offset, length);
+    xcb_get_property_reply_t *reply = xcb_get_property_reply(QX11Info::connection(), cookie, NULL);
+    if(reply==0){ return QByteArray(); } //window is gone - nothing to remember
+    //Same checks as the typed ewmh/icccm getters: a value of another type counts as not set
+    bool ok = (type==XCB_GET_PROPERTY_TYPE_ANY || reply->type==type) && (format==0 || reply->format==format);
+    if(ok){ data.append( (const char*) xcb_get_property_value(reply), xcb_get_property_value_length(reply) ); }
+    else{ data.clear(); }
+    uint32_t after = reply->bytes_after;
+    free(reply);
+    if(!ok || after==0){ break; }
+    //Fetch the rest of a long value in one more request
+    offset = data.size()/4;
+    length = (after+3)/4;
+  }
+  if(cache){ PROPCACHE[win].insert(atom, data); }
+  return data;
+}
+
+// private function
+uint32_t LXCB::windowCardinal(WId win, xcb_atom_t atom, xcb_atom_t type, uint32_t fallback){
+  QByteArray data = windowProperty(win, atom, type, 32);
+  if(data.size() < 4){ return fallback; }
+  uint32_t val;
+  memcpy(&val, data.constData(), 4);
+  return val;
+}
+
+// private function
+QList<xcb_atom_t> LXCB::windowAtoms(WId win, xcb_atom_t atom){
+  QByteArray data = windowProperty(win, atom, XCB_ATOM_ATOM, 32);
+  QList<xcb_atom_t> out;
+  for(int i=0; i+4<=data.size(); i+=4){
+    xcb_atom_t val;
+    memcpy(&val, data.constData()+i, 4);
+    out << val;
+  }
+  return out;
+}
+
+// === PropertyChanged() ===
+void LXCB::PropertyChanged(WId win, xcb_atom_t atom){
+  if(atom == EWMH._NET_WM_ICON){ InvalidateWindowIcon(win); }
+  QHash<WId, QHash<xcb_atom_t, QByteArray> >::iterator it = PROPCACHE.find(win);
+  if(it!=PROPCACHE.end()){ it.value().remove(atom); }
+}
+
+// === ForgetWindow() ===
+void LXCB::ForgetWindow(WId win){
+  InvalidateWindowIcon(win);
+  PROPCACHE.remove(win);
+  WATCHED.remove(win);
+}
+
 // private function
 void LXCB::createWMAtoms(){
   ATOMS.clear();
@@ -77,26 +211,135 @@ void LXCB::createWMAtoms(){
   }
 }
 
+// private function
+QList<LXCB::WINDOWSTATE> LXCB::statesFromAtoms(xcb_ewmh_get_atoms_reply_t *reply){
+  QList<LXCB::WINDOWSTATE> out;
+  for(unsigned int i=0; i<reply->atoms_len; i++){
+    if(reply->atoms[i]==EWMH._NET_WM_STATE_MODAL){ out << LXCB::S_MODAL; }
+    else if(reply->atoms[i]==EWMH._NET_WM_STATE_STICKY){ out << LXCB::S_STICKY; }
+    else if(reply->atoms[i]==EWMH._NET_WM_STATE_MAXIMIZED_VERT){ out << LXCB::S_MAX_VERT; }
+    else if(reply->atoms[i]==EWMH._NET_WM_STATE_MAXIMIZED_HORZ){ out << LXCB::S_MAX_HORZ; }
+    else if(reply->atoms[i]==EWMH._NET_WM_STATE_SHADED){ out << LXCB::S_SHADED; }
+    else if(reply->atoms[i]==EWMH._NET_WM_STATE_SKIP_TASKBAR){ out << LXCB::S_SKIP_TASKBAR; }
+    else if(reply->atoms[i]==EWMH._NET_WM_STATE_SKIP_PAGER){ out << LXCB::S_SKIP_PAGER; }
+    else if(reply->atoms[i]==EWMH._NET_WM_STATE_HIDDEN){ out << LXCB::S_HIDDEN; }
+    else if(reply->atoms[i]==EWMH._NET_WM_STATE_FULLSCREEN){ out << LXCB::S_FULLSCREEN; }
+    else if(reply->atoms[i]==EWMH._NET_WM_STATE_ABOVE){ out << LXCB::S_ABOVE; }
+    else if(reply->atoms[i]==EWMH._NET_WM_STATE_BELOW){ out << LXCB::S_BELOW; }
+    else if(reply->atoms[i]==EWMH._NET_WM_STATE_DEMANDS_ATTENTION){ out << LXCB::S_ATTENTION; }
+    //else if(reply->atoms[i]==EWMH._NET_WM_STATE_FOCUSED){ out << LXCB::FOCUSED; }
+  }
+  return out;
+}
+
+// private function
+QList<LXCB::WINDOWTYPE> LXCB::typesFromAtoms(xcb_ewmh_get_atoms_reply_t *reply){
+  QList<LXCB::WINDOWTYPE> out;
+  for(unsigned int i=0; i<reply->atoms_len; i++){
+    if(reply->atoms[i]==EWMH._NET_WM_WINDOW_TYPE_DESKTOP){ out << LXCB::T_DESKTOP; }
+    else if(reply->atoms[i]==EWMH._NET_WM_WINDOW_TYPE_DOCK){ out << LXCB::T_DOCK; }
+    else if(reply->atoms[i]==EWMH._NET_WM_WINDOW_TYPE_TOOLBAR){ out << LXCB::T_TOOLBAR; }
+    else if(reply->atoms[i]==EWMH._NET_WM_WINDOW_TYPE_MENU){ out << LXCB::T_MENU; }
+    else if(reply->atoms[i]==EWMH._NET_WM_WINDOW_TYPE_UTILITY){ out << LXCB::T_UTILITY; }
+    else if(reply->atoms[i]==EWMH._NET_WM_WINDOW_TYPE_SPLASH){ out << LXCB::T_SPLASH; }
+    else if(reply->atoms[i]==EWMH._NET_WM_WINDOW_TYPE_DIALOG){ out << LXCB::T_DIALOG; }
+    else if(reply->atoms[i]==EWMH._NET_WM_WINDOW_TYPE_DROPDOWN_MENU){ out << LXCB::T_DROPDOWN_MENU; }
+    else if(reply->atoms[i]==EWMH._NET_WM_WINDOW_TYPE_POPUP_MENU){ out << LXCB::T_POPUP_MENU; }
+    else if(reply->atoms[i]==EWMH._NET_WM_WINDOW_TYPE_TOOLTIP){ out << LXCB::T_TOOLTIP; }
+    else if(reply->atoms[i]==EWMH._NET_WM_WINDOW_TYPE_NOTIFICATION){ out << LXCB::T_NOTIFICATION; }
+    else if(reply->atoms[i]==EWMH._NET_WM_WINDOW_TYPE_COMBO){ out << LXCB::T_COMBO; }
+    else if(reply->atoms[i]==EWMH._NET_WM_WINDOW_TYPE_DND){ out << LXCB::T_DND; }
+    else if(reply->atoms[i]==EWMH._NET_WM_WINDOW_TYPE_NORMAL){ out << LXCB::T_NORMAL; }
+  }
+  return out;
+}
+
 // === WindowList() ===
 QList<WId> LXCB::WindowList(bool rawlist){
   qDebug() << "XCB: WindowList()" << rawlist;
   QList<WId> output;
-  //qDebug() << "Get Client list cookie";
+  QList<LXCB::window_record> recs = WindowListRecords(rawlist);
+  for(int i=0; i<recs.length(); i++){ output << recs[i].id; }
+  return output;
+}
+
+// === ClientList() ===
+QList<WId> LXCB::ClientList(){
+  if(DEBUG){ qDebug() << "XCB: ClientList()"; }
+  QList<WId> output;
   xcb_get_property_cookie_t cookie = xcb_ewmh_get_client_list_unchecked( &EWMH, 0);
   xcb_ewmh_get_windows_reply_t winlist;
-  //qDebug() << "Get client list";
   if( 1 == xcb_ewmh_get_client_list_reply( &EWMH, cookie, &winlist, NULL) ){
-    //qDebug() << " - Loop over items";
-    unsigned int wkspace = CurrentWorkspace();
-    for(unsigned int i=0; i<winlist.windows_len; i++){
-      //Filter out the Desktop windows
-      if(WindowClass(winlist.windows[i]) == QString("%1 Desktop Environment").arg(DESKTOP_APP_NAME)){ continue; }
-      //Also filter out windows not on the active workspace
-      else if( (WindowWorkspace(winlist.windows[i])!=wkspace) && !rawlist ){ continue; }
-      else{
-        output << winlist.windows[i];
-      }
+    for(unsigned int i=0; i<winlist.windows_len; i++){ output << winlist.windows[i]; }
+    xcb_ewmh_get_windows_reply_wipe(&winlist);
+  }
+  return output;
+}
+
+// === WindowListRecords() ===
+QList<LXCB::window_record> LXCB::WindowListRecords(bool rawlist){
+  if(DEBUG){ qDebug() << "XCB: WindowListRecords()" << rawlist; }
+  QList<LXCB::window_record> output;
+  unsigned int wkspace = 0;
+  QList<LXCB::window_record> recs = WindowRecords(ClientList(), &wkspace);
+  QString deClass = QString("%1 Desktop Environment").arg(DESKTOP_APP_NAME);
+  for(int i=0; i<recs.length(); i++){
+    //Filter out the Desktop windows
+    if(recs[i].wclass == deClass){ continue; }
+    //Also filter out windows not on the active workspace
+    else if( (recs[i].desktop!=wkspace) && !rawlist ){ continue; }
+    output << recs[i];
+  }
+  return output;
+}
+
+// === WindowRecords() ===
+QList<LXCB::window_record> LXCB::WindowRecords(QList<WId> wins, unsigned int *current){
+  //Send every request up front and only then start reading the replies
+  // (one round trip for the whole list instead of several per window)
+  if(DEBUG){ qDebug() << "XCB: WindowRecords()" << wins.length(); }
+  QList<LXCB::window_record> output;
+  xcb_connection_t *conn = QX11Info::connection();
+  xcb_get_property_cookie_t dcookie = xcb_ewmh_get_current_desktop_unchecked(&EWMH, 0);
+  QVector<xcb_get_property_cookie_t> classC(wins.length()), deskC(wins.length()), stateC(wins.length()), typeC(wins.length());
+  for(int i=0; i<wins.length(); i++){
+    classC[i] = xcb_icccm_get_wm_class_unchecked(conn, wins[i]);
+    deskC[i] = xcb_ewmh_get_wm_desktop_unchecked(&EWMH, wins[i]);
+    stateC[i] = xcb_ewmh_get_wm_state_unchecked(&EWMH, wins[i]);
+    typeC[i] = xcb_ewmh_get_wm_window_type_unchecked(&EWMH, wins[i]);
+  }
+  xcb_flush(conn);
+  //Now collect the replies
+  uint32_t wkspace = 0;
+  xcb_ewmh_get_current_desktop_reply(&EWMH, dcookie, &wkspace, NULL);
+  if(current!=0){ *current = wkspace; }
+  for(int i=0; i<wins.length(); i++){
+    LXCB::window_record rec;
+    rec.id = wins[i];
+    rec.desktop = 0;
+    xcb_icccm_get_wm_class_reply_t cvalue;
+    if( 1== xcb_icccm_get_wm_class_reply(conn, classC[i], &cvalue, NULL) ){
+      rec.wclass = QString::fromUtf8(cvalue.class_name);
+      xcb_icccm_get_wm_class_reply_wipe(&cvalue);
+    }
+    uint32_t desk = 0;
+    bool alldesks = false;
+    if(1==xcb_ewmh_get_wm_desktop_reply(&EWMH, deskC[i], &desk, NULL)){
+      rec.desktop = desk;
+      alldesks = (desk == 0xFFFFFFFF);
     }
+    xcb_ewmh_get_atoms_reply_t reply;
+    if(1==xcb_ewmh_get_wm_state_reply(&EWMH, stateC[i], &reply, NULL)){
+      rec.states = statesFromAtoms(&reply);
+      xcb_ewmh_get_atoms_reply_wipe(&reply);
+    }
+    if(1==xcb_ewmh_get_wm_window_type_reply(&EWMH, typeC[i], &reply, NULL)){
+      rec.types = typesFromAtoms(&reply);
+      xcb_ewmh_get_atoms_reply_wipe(&reply);
+    }
+    //Sticky windows are on every workspace - report the current one
+    if(alldesks || rec.states.contains(LXCB::S_STICKY)){ rec.desktop = wkspace; }
+    output << rec;
   }
   return output;
 }
@@ -104,12 +347,7 @@ QList<WId> LXCB::WindowList(bool rawlist){
 // === CurrentWorkspace() ===
 unsigned int LXCB::CurrentWorkspace(){
   if(DEBUG){ qDebug() << "XCB: CurrentWorkspace()"; }
-  //qDebug() << "Get Current Workspace";
-  xcb_get_property_cookie_t cookie = xcb_ewmh_get_current_desktop_unchecked(&EWMH, 0);
-  uint32_t wkspace = 0;
-  xcb_ewmh_get_current_desktop_reply(&EWMH, cookie, &wkspace, NULL);
-  //qDebug() << " - done:" << wkspace;
-  return wkspace;
+  return windowCardinal(QX11Info::appRootWindow(), EWMH._NET_CURRENT_DESKTOP, XCB_ATOM_CARDINAL, 0);
 }
 
 unsigned int LXCB::NumberOfWorkspaces(){
@@ -124,14 +362,8 @@ unsigned int LXCB::NumberOfWorkspaces(){
 
 // === ActiveWindow() ===
 WId LXCB::ActiveWindow(){
-  qDebug() << "XCB: ActiveWindow()";
-  xcb_get_property_cookie_t cookie = xcb_ewmh_get_active_window_unchecked(&EWMH, 0);
-  xcb_window_t actwin;
-  if(1 == xcb_ewmh_get_active_window_reply(&EWMH, cookie, &actwin, NULL) ){
-    return actwin;
-  }else{
-    return 0; //invalid ID/failure
-  }
+  if(DEBUG){ qDebug() << "XCB: ActiveWindow()"; }
+  return windowCardinal(QX11Info::appRootWindow(), EWMH._NET_ACTIVE_WINDOW, XCB_ATOM_WINDOW, 0); //0: invalid ID/failure
 }
 
 // === CheckDisableXinerama() ===
@@ -187,16 +419,9 @@ void LXCB::SetCurrentWorkspace(int number){
 // === WindowClass() ===
 QString LXCB::WindowClass(WId win){
   if(DEBUG){ qDebug() << "XCB: WindowClass()" << win; }
-  QString out;
   if(win==0){ return ""; }
-  xcb_get_property_cookie_t cookie = xcb_icccm_get_wm_class_unchecked(QX11Info::connection(), win);
-  if(cookie.sequence == 0){ return out; }
-  xcb_icccm_get_wm_class_reply_t value;
-  if( 1== xcb_icccm_get_wm_class_reply( QX11Info::connection(), cookie, &value, NULL) ){
-    out = QString::fromUtf8(value.class_name);
-    xcb_icccm_get_wm_class_reply_wipe(&value);
-  }
-  return out;
+  //WM_CLASS: "<instance name>\0<class name>\0"
+  return QString::fromUtf8( windowProperty(win, XCB_ATOM_WM_CLASS, XCB_ATOM_STRING, 8).split('\0').value(1) );
 }
 
 // === WindowWorkspace() ===
@@ -204,20 +429,9 @@ unsigned int LXCB::WindowWorkspace(WId win){
   if(DEBUG){ qDebug() << "XCB: WindowWorkspace()" << win; }
   //qDebug() << "Get Window Workspace";
   if(win==0){ return 0; }
-  uint32_t wkspace = 0;
-  xcb_get_property_cookie_t scookie = xcb_ewmh_get_wm_state_unchecked(&EWMH, win);
-  xcb_get_property_cookie_t cookie = xcb_ewmh_get_wm_desktop_unchecked(&EWMH, win);
-  if(cookie.sequence == 0){ return wkspace; }
-  xcb_ewmh_get_wm_desktop_reply(&EWMH, cookie, &wkspace, NULL);
-  xcb_ewmh_get_atoms_reply_t reply;
-  if(1==xcb_ewmh_get_wm_state_reply(&EWMH,scookie, &reply, NULL)){
-    //Also check if this window is "sticky", in which case return the current workspace (on all of them)
-    for(unsigned int i=0; i<reply.atoms_len; i++){
-      if(reply.atoms[i]==EWMH._NET_WM_STATE_STICKY){ wkspace = LXCB::CurrentWorkspace(); break; }
-    }
-  }
-  //qDebug() << " - done: " << wkspace;
-  return wkspace;
+  //Check if this window is "sticky", in which case return the current workspace (on all of them)
+  if(windowAtoms(win, EWMH._NET_WM_STATE).contains(EWMH._NET_WM_STATE_STICKY)){ return LXCB::CurrentWorkspace(); }
+  return windowCardinal(win, EWMH._NET_WM_DESKTOP, XCB_ATOM_CARDINAL, 0);
 }
 
 // === WindowGeometry() ===
@@ -283,29 +497,57 @@ QList<int> LXCB::WindowFrameGeometry(WId win){
   return geom;
 }
 
+// === WindowGeometries() ===
+QList<LXCB::window_geometry> LXCB::WindowGeometries(QList<WId> wins){
+  if(DEBUG){ qDebug() << "XCB: WindowGeometries()" << wins.length(); }
+  //Send the geometry, frame and position requests for every window first, then read the replies
+  QList<window_geometry> out;
+  xcb_connection_t *conn = QX11Info::connection();
+  QVector<xcb_get_geometry_cookie_t> gcookies(wins.length());
+  QVector<xcb_get_property_cookie_t> fcookies(wins.length());
+  QVector<xcb_translate_coordinates_cookie_t> tcookies(wins.length());
+  for(int i=0; i<wins.length(); i++){
+    gcookies[i] = xcb_get_geometry_unchecked(conn, wins[i]);
+    fcookies[i] = xcb_ewmh_get_frame_extents_unchecked(&EWMH, wins[i]);
+    tcookies[i] = xcb_translate_coordinates_unchecked(conn, wins[i], QX11Info::appRootWindow(), 0, 0);
+  }
+  xcb_flush(conn);
+  for(int i=0; i<wins.length(); i++){
+    window_geometry wg;
+    wg.id = wins[i];
+    xcb_get_geometry_reply_t *greply = xcb_get_geometry_reply(conn, gcookies[i], NULL);
+    if(greply!=0){
+      wg.geom = QRect(0, 0, greply->width, greply->height);
+      free(greply);
+    }
+    xcb_ewmh_get_extents_reply_t frame;
+    if(1 == xcb_ewmh_get_frame_extents_reply(&EWMH, fcookies[i], &frame, NULL) ){
+      wg.frame << frame.top << frame.bottom << frame.left << frame.right;
+    }else{
+      wg.frame << 0 << 0 << 0 << 0;
+    }
+    //Global position (sizing remains the same)
+    xcb_translate_coordinates_reply_t *trans = xcb_translate_coordinates_reply(conn, tcookies[i], NULL);
+    if(trans!=0){
+      if(!wg.geom.isNull()){ wg.geom.moveTo(trans->dst_x, trans->dst_y); }
+      free(trans);
+    }
+    out << wg;
+  }
+  return out;
+}
+
 // === WindowState() ===
 LXCB::WINDOWVISIBILITY LXCB::WindowState(WId win){
   if(DEBUG){ qDebug() << "XCB: WindowState()"; }
   if(win==0){ return IGNORE; }
-  xcb_get_property_cookie_t cookie = xcb_ewmh_get_wm_state_unchecked(&EWMH, win);
-  if(cookie.sequence == 0){ return IGNORE; } 
-  xcb_ewmh_get_atoms_reply_t states;
   WINDOWVISIBILITY cstate = IGNORE;
   //First Check for special states (ATTENTION in particular);
-  if( 1 == xcb_ewmh_get_wm_state_reply(&EWMH, cookie, &states, NULL) ){
-    for(unsigned int i=0; i<states.atoms_len; i++){
-      if(states.atoms[i] == EWMH._NET_WM_STATE_DEMANDS_ATTENTION){ cstate = ATTENTION; break; } //nothing more urgent - stop here
-      else if(states.atoms[i] == EWMH._NET_WM_STATE_HIDDEN){ cstate = INVISIBLE; }
-    }
-  }
+  QList<xcb_atom_t> states = windowAtoms(win, EWMH._NET_WM_STATE);
+  if(states.contains(EWMH._NET_WM_STATE_DEMANDS_ATTENTION)){ cstate = ATTENTION; } //nothing more urgent
+  else if(states.contains(EWMH._NET_WM_STATE_HIDDEN)){ cstate = INVISIBLE; }
   //Now check to see if the window is the active one
-  if(cstate == IGNORE){
-    xcb_get_property_cookie_t cookie = xcb_ewmh_get_active_window_unchecked(&EWMH, 0);
-    xcb_window_t actwin;
-    if(1 == xcb_ewmh_get_active_window_reply(&EWMH, cookie, &actwin, NULL) ){
-      if(actwin == win){ cstate = ACTIVE; }
-    }
-  }
+  if(cstate == IGNORE && LXCB::ActiveWindow() == win){ cstate = ACTIVE; }
   //Now check for ICCCM Urgency hint (not sure if this is still valid with EWMH instead)
   /*if(cstate == IGNORE){
     xcb_get_property_cookie_t cookie = xcb_icccm_get_wm_hints_unchecked(QX11Info::connection(), win);
@@ -331,184 +573,188 @@ LXCB::WINDOWVISIBILITY LXCB::WindowState(WId win){
 QString LXCB::WindowVisibleIconName(WId win){ //_NET_WM_VISIBLE_ICON_NAME
   if(DEBUG){ qDebug() << "XCB: WindowVisibleIconName()"; }
   if(win==0){ return ""; }
-  QString out;
-  xcb_get_property_cookie_t cookie = xcb_ewmh_get_wm_visible_icon_name_unchecked(&EWMH, win);
-  if(cookie.sequence == 0){ return out; } 
-  xcb_ewmh_get_utf8_strings_reply_t data;
-  if( 1 == xcb_ewmh_get_wm_visible_icon_name_reply(&EWMH, cookie, &data, NULL) ){
-      out = QString::fromUtf8(data.strings, data.strings_len);
-  }
-  return out;
+  return QString::fromUtf8( windowProperty(win, EWMH._NET_WM_VISIBLE_ICON_NAME, EWMH.UTF8_STRING, 8) );
 }
 
 // === WindowIconName() ===
 QString LXCB::WindowIconName(WId win){ //_NET_WM_ICON_NAME
   if(DEBUG){ qDebug() << "XCB: WindowIconName()"; }
   if(win==0){ return ""; }
-  QString out;
-  xcb_get_property_cookie_t cookie = xcb_ewmh_get_wm_icon_name_unchecked(&EWMH, win);
-  if(cookie.sequence == 0){ return out; } 
-  xcb_ewmh_get_utf8_strings_reply_t data;
-  if( 1 == xcb_ewmh_get_wm_icon_name_reply(&EWMH, cookie, &data, NULL) ){
-      out = QString::fromUtf8(data.strings, data.strings_len);
-  }
-  return out;
+  return QString::fromUtf8( windowProperty(win, EWMH._NET_WM_ICON_NAME, EWMH.UTF8_STRING, 8) );
 }
 
 // === WindowVisibleName() ===
 QString LXCB::WindowVisibleName(WId win){ //_NET_WM_VISIBLE_NAME
   if(DEBUG){ qDebug() << "XCB: WindowVisibleName()"; }
   if(win==0){ return ""; }
-  QString out;
-  xcb_get_property_cookie_t cookie = xcb_ewmh_get_wm_visible_name_unchecked(&EWMH, win);
-  if(cookie.sequence == 0){ return out; } 
-  xcb_ewmh_get_utf8_strings_reply_t data;
-  if( 1 == xcb_ewmh_get_wm_visible_name_reply(&EWMH, cookie, &data, NULL) ){
-      out = QString::fromUtf8(data.strings, data.strings_len);
-  }
-  return out;
+  return QString::fromUtf8( windowProperty(win, EWMH._NET_WM_VISIBLE_NAME, EWMH.UTF8_STRING, 8) );
 }
 
 // === WindowName() ===
 QString LXCB::WindowName(WId win){ //_NET_WM_NAME
   if(DEBUG){ qDebug() << "XCB: WindowName()"; }
   if(win==0){ return ""; }
-  QString out;
-  xcb_get_property_cookie_t cookie = xcb_ewmh_get_wm_name_unchecked(&EWMH, win);
-  if(cookie.sequence == 0){ return out; } 
-  xcb_ewmh_get_utf8_strings_reply_t data;
-  if( 1 == xcb_ewmh_get_wm_name_reply(&EWMH, cookie, &data, NULL) ){
-      out = QString::fromUtf8(data.strings, data.strings_len);
-  }
-  return out;
+  return QString::fromUtf8( windowProperty(win, EWMH._NET_WM_NAME, EWMH.UTF8_STRING, 8) );
 }
 
 // === OldWindowName() ===
 QString LXCB::OldWindowName(WId win){ //WM_NAME (old standard)
   if(DEBUG){ qDebug() << "XCB: OldWindowName()"; }
   if(win==0){ return ""; }
-  xcb_get_property_cookie_t cookie = xcb_icccm_get_wm_name_unchecked(QX11Info::connection(), win);
-  xcb_icccm_get_text_property_reply_t reply;
-  if(1 == xcb_icccm_get_wm_name_reply(QX11Info::connection(), cookie, &reply, NULL) ){
-    QString name = QString::fromLocal8Bit(reply.name, reply.name_len);
-    xcb_icccm_get_text_property_reply_wipe(&reply);
-    return name;
-  }else{
-    return "";
-  }	
+  return QString::fromLocal8Bit( windowProperty(win, XCB_ATOM_WM_NAME, XCB_GET_PROPERTY_TYPE_ANY, 0) );
 }
 
 // === OldWindowIconName() ===
 QString LXCB::OldWindowIconName(WId win){ //WM_ICON_NAME (old standard)
   if(DEBUG){ qDebug() << "XCB: OldWindowIconName()"; }
   if(win==0){ return ""; }
-  xcb_get_property_cookie_t cookie = xcb_icccm_get_wm_icon_name_unchecked(QX11Info::connection(), win);
-  xcb_icccm_get_text_property_reply_t reply;
-  if(1 == xcb_icccm_get_wm_icon_name_reply(QX11Info::connection(), cookie, &reply, NULL) ){
-    QString name = QString::fromLocal8Bit(reply.name, reply.name_len);
-    xcb_icccm_get_text_property_reply_wipe(&reply);
-    return name;
-  }else{
-    return "";
-  }	
+  return QString::fromLocal8Bit( windowProperty(win, XCB_ATOM_WM_ICON_NAME, XCB_GET_PROPERTY_TYPE_ANY, 0) );
+}
+
+// === WindowTitles() ===
+QStringList LXCB::WindowTitles(QList<WId> wins){
+  //Batched version of the title lookup: send every request first, then read the replies
+  // Order of preference: _NET_WM_VISIBLE_ICON_NAME, _NET_WM_ICON_NAME, _NET_WM_VISIBLE_NAME,
+  //   _NET_WM_NAME, WM_ICON_NAME, WM_NAME
+  if(DEBUG){ qDebug() << "XCB: WindowTitles()" << wins.length(); }
+  QStringList out;
+  xcb_connection_t *conn = QX11Info::connection();
+  QVector<xcb_get_property_cookie_t> cookies(wins.length()*6);
+  for(int i=0; i<wins.length(); i++){
+    cookies[i*6] = xcb_ewmh_get_wm_visible_icon_name_unchecked(&EWMH, wins[i]);
+    cookies[i*6+1] = xcb_ewmh_get_wm_icon_name_unchecked(&EWMH, wins[i]);
+    cookies[i*6+2] = xcb_ewmh_get_wm_visible_name_unchecked(&EWMH, wins[i]);
+    cookies[i*6+3] = xcb_ewmh_get_wm_name_unchecked(&EWMH, wins[i]);
+    cookies[i*6+4] = xcb_icccm_get_wm_icon_name_unchecked(conn, wins[i]);
+    cookies[i*6+5] = xcb_icccm_get_wm_name_unchecked(conn, wins[i]);
+  }
+  xcb_flush(conn);
+  for(int i=0; i<wins.length(); i++){
+    QString name;
+    for(int j=0; j<6; j++){
+      xcb_get_property_cookie_t cookie = cookies[i*6+j];
+      if(!name.simplified().isEmpty()){ xcb_discard_reply(conn, cookie.sequence); continue; } //already found
+      if(j<4){
+        xcb_ewmh_get_utf8_strings_reply_t data;
+        if( 1 == xcb_ewmh_get_utf8_strings_reply(&EWMH, cookie, &data, NULL) ){
+          name = QString::fromUtf8(data.strings, data.strings_len);
+          xcb_ewmh_get_utf8_strings_reply_wipe(&data);
+        }
+      }else{
+        xcb_icccm_get_text_property_reply_t reply;
+        if( 1 == xcb_icccm_get_text_property_reply(conn, cookie, &reply, NULL) ){
+          name = QString::fromLocal8Bit(reply.name, reply.name_len);
+          xcb_icccm_get_text_property_reply_wipe(&reply);
+        }
+      }
+    }
+    out << name;
+  }
+  return out;
 }
 
 // === WindowIsMaximized() ===
 bool LXCB::WindowIsMaximized(WId win){
   if(DEBUG){ qDebug() << "XCB: WindowIsMaximized()"; }
-  if(win==0){ return ""; }
+  if(win==0){ return false; }
   //See if the _NET_WM_STATE_MAXIMIZED_[VERT/HORZ] flags are set on the window
-  xcb_get_property_cookie_t cookie = xcb_ewmh_get_wm_state_unchecked(&EWMH, win);
-  if(cookie.sequence == 0){ return false; } 
-  xcb_ewmh_get_atoms_reply_t states;
-  if( 1 == xcb_ewmh_get_wm_state_reply(&EWMH, cookie, &states, NULL) ){
-    //Loop over the states
-    for(unsigned int i=0; i<states.atoms_len; i++){
-      if(states.atoms[i] == EWMH._NET_WM_STATE_MAXIMIZED_HORZ \
-	      || states.atoms[i] == EWMH._NET_WM_STATE_MAXIMIZED_VERT ){
-	return true;
-      }
-    }
-  }
-  return false;
+  QList<xcb_atom_t> states = windowAtoms(win, EWMH._NET_WM_STATE);
+  return ( states.contains(EWMH._NET_WM_STATE_MAXIMIZED_HORZ) || states.contains(EWMH._NET_WM_STATE_MAXIMIZED_VERT) );
 }
 
 // === WindowIsFullscreen() ===
 int LXCB::WindowIsFullscreen(WId win){
- if(DEBUG){ qDebug() << "XCB: WindowIsFullscreen()"; }
-  if(win==0){ return -1; }	
-  //bool fullS = false;
-  //See if the _NET_WM_STATE_FULLSCREEN flag is set on the window
-  /*xcb_get_property_cookie_t cookie = xcb_ewmh_get_wm_state_unchecked(&EWMH, win);
-  if(cookie.sequence == 0){ return false; } 
-  xcb_ewmh_get_atoms_reply_t states;
-  if( 1 == xcb_ewmh_get_wm_state_reply(&EWMH, cookie, &states, NULL) ){
-    //Loop over the states
-    for(unsigned int i=0; i<states.atoms_len; i++){
-      if(states.atoms[i] == EWMH._NET_WM_STATE_FULLSCREEN){
-	fullS = true; 
-	break;
-      }
-    }
-  }*/
-  //if(!fullS){
-    //Fallback check for windows which are painted above everything else 
-    // but don't have the FULLSCREEN flag set (even though they are technically full-screen)
-    int fscreen = -1;
-    //qDebug() << "FALLBACK FULLSCREEN CHECK:";
-    QRect geom = LXCB::WindowGeometry(win, false);
-    QDesktopWidget *desk = QApplication::desktop();
-    for(int i=0; i<desk->screenCount(); i++){
-      QRect sgeom = desk->screenGeometry(i);
-      qDebug() << " -- Check Window Geom:" << sgeom << geom << this->WindowClass(win);
-      if( sgeom.contains(geom.center()) ){
-	//Allow a 1 pixel variation in "full-screen" detection
-	qDebug() << " -- Found Screen:" << i;
-	if( geom.width() >= (sgeom.width()-1) && geom.height()>=(sgeom.height()-1) ){
-	  qDebug() << " -- Is Fullscreen!";
-	  //fullS = true;
-	  fscreen = i;
-	}
-	break; //found the screen which contains this window
-      }
-    }
-  //}
-  //return fullS;
-  return fscreen;
+  if(DEBUG){ qDebug() << "XCB: WindowIsFullscreen()"; }
+  if(win==0){ return -1; }
+  //Only ask for the geometry if the _NET_WM_STATE_FULLSCREEN flag is set (cached)
+  if(!windowAtoms(win, EWMH._NET_WM_STATE).contains(EWMH._NET_WM_STATE_FULLSCREEN)){ return -1; }
+  return WindowIsFullscreen(win, LXCB::WindowGeometry(win, false));
+}
+
+int LXCB::WindowIsFullscreen(WId win, QRect geom){
+  if(win==0 || geom.isNull()){ return -1; }
+  //See if the _NET_WM_STATE_FULLSCREEN flag is set on the window (cached)
+  if(!windowAtoms(win, EWMH._NET_WM_STATE).contains(EWMH._NET_WM_STATE_FULLSCREEN)){ return -1; }
+  //Then find the output it covers (any screen, not just the ones with a desktop)
+  QDesktopWidget *desk = QApplication::desktop();
+  for(int i=0; i<desk->screenCount(); i++){
+    QRect sgeom = desk->screenGeometry(i);
+    if( !sgeom.contains(geom.center()) ){ continue; }
+    //Allow a 1 pixel variation in "full-screen" detection
+    if( geom.width() >= (sgeom.width()-1) && geom.height() >= (sgeom.height()-1) ){ return i; }
+    break; //found the screen which contains this window
+  }
+  return -1;
 }
 
 // === WindowIcon() ===
-QIcon LXCB::WindowIcon(WId win){
+QIcon LXCB::WindowIcon(WId win, int size){
   //Fetch the _NET_WM_ICON for the window and return it as a QIcon
   if(DEBUG){ qDebug() << "XCB: WindowIcon()"; }
+  if(win==0){ return QIcon(); }
+  if(size<1){ size = 64; }
+  //Cached until the icon property changes (a larger request replaces a smaller one)
+  if(ICONCACHE.contains(win) && ICONCACHE[win].size >= size){ return ICONCACHE[win].icon; }
   QIcon icon;
-  if(win==0){ return icon; }
-  xcb_get_property_cookie_t cookie = xcb_ewmh_get_wm_icon_unchecked(&EWMH, win);
-  xcb_ewmh_get_wm_icon_reply_t reply;
-  if(1 == xcb_ewmh_get_wm_icon_reply(&EWMH, cookie, &reply, NULL)){
-    xcb_ewmh_wm_icon_iterator_t iter = xcb_ewmh_get_wm_icon_iterator(&reply);
-    //Just use the first
-    bool done =false;
-    while(!done){
-      //Now convert the current data into a Qt image
-      // - first 2 elements are width and height (removed via XCB functions)
-      // - data in rows from left to right and top to bottom
-      QImage image(iter.width, iter.height, QImage::Format_ARGB32); //initial setup
-	uint* dat = iter.data;
-	//dat+=2; //remember the first 2 element offset
-	for(int i=0; i<image.byteCount()/4; ++i, ++dat){
-	  ((uint*)image.bits())[i] = *dat;
-	}
-      icon.addPixmap(QPixmap::fromImage(image)); //layer this pixmap onto the icon
-      //Now see if there are any more icons available
-      done = (iter.rem<1); //number of icons remaining
-      if(!done){ xcb_ewmh_get_wm_icon_next(&iter); } //get the next icon data
-    }
-    xcb_ewmh_get_wm_icon_reply_wipe(&reply);
-  }
+  QImage image = fetchWindowIcon(win, size);
+  if(!image.isNull()){ icon.addPixmap(QPixmap::fromImage(image)); }
+  wm_icon_cache entry;
+    entry.icon = icon;
+    entry.size = size;
+  ICONCACHE.insert(win, entry);
   return icon;
 }
 
+// === InvalidateWindowIcon() ===
+void LXCB::InvalidateWindowIcon(WId win){
+  ICONCACHE.remove(win);
+}
+
+// private function
+QImage LXCB::fetchWindowIcon(WId win, int size){
+  // _NET_WM_ICON is a CARDINAL array of: [width, height, width*height ARGB pixels] for every size
+  // - Walk the (width, height) headers first so only the best size gets transferred
+  xcb_connection_t *conn = QX11Info::connection();
+  uint32_t offset = 0; //in 32-bit units
+  uint32_t bestoff = 0, bestw = 0, besth = 0;
+  for(int i=0; i<32; i++){ //sanity limit on the number of sizes
+    xcb_get_property_cookie_t cookie = xcb_get_property_unchecked(conn, 0, win, EWMH._NET_WM_ICON, XCB_ATOM_CARDINAL, offset, 2);
+    xcb_get_property_reply_t *reply = xcb_get_property_reply(conn, cookie, NULL);
+    if(reply==0){ break; }
+    uint32_t w = 0, h = 0;
+    uint32_t after = reply->bytes_after;
+    if(reply->format==32 && xcb_get_property_value_length(reply)==8){
+      uint32_t *dat = (uint32_t*) xcb_get_property_value(reply);
+      w = dat[0]; h = dat[1];
+    }
+    free(reply);
+    if(w==0 || h==0 || w>1024 || h>1024 || after < w*h*4){ break; } //invalid or truncated entry
+    //Smallest icon which is at least the requested size, otherwise the largest one available
+    bool better = (bestw==0);
+    if(!better && bestw < (uint32_t) size){ better = (w > bestw); }
+    else if(!better){ better = (w >= (uint32_t) size && w < bestw); }
+    if(better){ bestoff = offset+2; bestw = w; besth = h; }
+    if(after == w*h*4){ break; } //that was the last one
+    offset += 2 + w*h;
+  }
+  if(bestw==0){ return QImage(); }
+  //Now fetch the pixels for that one size (bounded request)
+  QImage image;
+  xcb_get_property_cookie_t cookie = xcb_get_property_unchecked(conn, 0, win, EWMH._NET_WM_ICON, XCB_ATOM_CARDINAL, bestoff, bestw*besth);
+  xcb_get_property_reply_t *reply = xcb_get_property_reply(conn, cookie, NULL);
+  if(reply==0){ return image; }
+  if(reply->format==32 && xcb_get_property_value_length(reply) == (int) (bestw*besth*4) ){
+    //The pixels are already 32-bit ARGB words in host byte order (QImage::Format_ARGB32)
+    // - copy whole rows instead of converting pixel by pixel
+    image = QImage(bestw, besth, QImage::Format_ARGB32);
+    const uchar *src = (const uchar*) xcb_get_property_value(reply);
+    for(uint32_t y=0; y<besth; y++){ memcpy(image.scanLine(y), src + y*bestw*4, bestw*4); }
+    image = image.convertToFormat(QImage::Format_ARGB32_Premultiplied); //faster to paint
+  }
+  free(reply);
+  return image;
+}
+
 // === SelectInput() ===
 void LXCB::SelectInput(WId win, bool isEmbed){
   uint32_t mask;
@@ -518,6 +764,7 @@ void LXCB::SelectInput(WId win, bool isEmbed){
     mask = XCB_EVENT_MASK_FOCUS_CHANGE | XCB_EVENT_MASK_PROPERTY_CHANGE;
   }
   xcb_change_window_attributes(QX11Info::connection(), win, XCB_CW_EVENT_MASK, &mask );
+  WATCHED << win; //property changes get reported from now on (cache is safe)
 }
 
 // === GenerateDamageID() ===
@@ -530,46 +777,201 @@ uint LXCB::GenerateDamageID(WId win){
 
 // === paintRoot() ===
 void LXCB::paintRoot(QRect area, const QPixmap *pix){
-  //Generate a graphics context for this paint
-  xcb_gcontext_t gc = xcb_generate_id(QX11Info::connection());
-  xcb_screen_t *screen = xcb_setup_roots_iterator(xcb_get_setup(QX11Info::connection())).data;
- uint32_t values[1];
-  values[0] = screen->black_pixel;
-
-    xcb_create_gc(QX11Info::connection(), 
-	gc,
-	screen->root,
-	XCB_GC_BACKGROUND,
-	values );
-  //Convert the QPixmap to a xcb_drawable_t
-  QImage qimage = pix->toImage().convertToFormat(QImage::Format_ARGB32); 
-  xcb_image_t *image = xcb_image_create(pix->width(), pix->height(), XCB_IMAGE_FORMAT_XY_PIXMAP,
-	32, qimage.depth(), 32, 32, XCB_IMAGE_ORDER_LSB_FIRST, XCB_IMAGE_ORDER_LSB_FIRST, 
-	0, qimage.byteCount(), qimage.bits()); 
+  if(pix==0 || pix->isNull()){ return; }
+  xcb_screen_t *screen = xcb_aux_get_screen(QX11Info::connection(), QX11Info::appScreen());
+  QSize rootSize(screen->width_in_pixels, screen->height_in_pixels);
+  //Ask for the atoms now (replies read later)
+  xcb_intern_atom_cookie_t xcookie = xcb_intern_atom(QX11Info::connection(), 0, 13, "_XROOTPMAP_ID");
+  xcb_intern_atom_cookie_t ecookie = xcb_intern_atom(QX11Info::connection(), 0, 16, "ESETROOT_PMAP_ID");
+  xcb_intern_atom_reply_t *xreply = xcb_intern_atom_reply(QX11Info::connection(), xcookie, NULL);
+  xcb_intern_atom_reply_t *ereply = xcb_intern_atom_reply(QX11Info::connection(), ecookie, NULL);
+  xcb_atom_t xatom = XCB_ATOM_NONE, eatom = XCB_ATOM_NONE;
+  if(xreply!=0){ xatom = xreply->atom; free(xreply); }
+  if(ereply!=0){ eatom = ereply->atom; free(ereply); }
+  //Keep a single server-side pixmap with the background of all the screens
+  xcb_pixmap_t old = 0;
+  if(rootPixmap==0 || rootPixmapSize!=rootSize){
+    if(rootPixmap==0){ killRootPixmap(screen->root, xatom, eatom); } //left behind by the previous setter
+    old = rootPixmap;
+    rootPixmap = createRootPixmap(screen, rootSize);
+    if(rootPixmap==0){ rootPixmap = old; return; }
+    xcb_gcontext_t gc = xcb_generate_id(QX11Info::connection());
+    uint32_t values[] = {screen->black_pixel};
+    xcb_create_gc(QX11Info::connection(), gc, rootPixmap, XCB_GC_FOREGROUND, values);
+    xcb_rectangle_t all = {0, 0, (uint16_t) rootSize.width(), (uint16_t) rootSize.height()};
+    xcb_poly_fill_rectangle(QX11Info::connection(), rootPixmap, gc, 1, &all);
+    if(old!=0){
+      //Keep the background of the other screens
+      xcb_copy_area(QX11Info::connection(), old, rootPixmap, gc, 0, 0, 0, 0, \
+		qMin(rootSize.width(), rootPixmapSize.width()), qMin(rootSize.height(), rootPixmapSize.height()) );
+    }
+    xcb_free_gc(QX11Info::connection(), gc);
+    rootPixmapSize = rootSize;
+  }
+  QImage img = pix->toImage();
+  if(img.size()!=area.size()){ img = img.scaled(area.size()); }
+  if(!PutImage(rootPixmap, img, area.topLeft(), screen->root_depth)){
+    //Not a 24/32-bit visual with 32 bits per pixel - convert to the visual's own pixel format
+    if(!putImageNative(rootPixmap, img, area.topLeft(), screen)){ qDebug() << "XCB: Could not paint the root background"; }
+  }
 
-  
-  //Now paint on the root window
-  xcb_image_put(QX11Info::connection(),
-	screen->root, //where to put it
-	gc,
-	image,
-	area.x(),
-	area.y(),
-	0);
-  /*xcb_copy_area(QX11Info::connection(),
-	//static_cast<xcb_drawable_t>( pix.handle() ) , //image to copy
-	*image,
-	screen->root,  //where to put it
-	gc,  //graphics context for destination
-	0,  //x origin of picture
-	0,  // y origin of picture
-	area.x(),  //x origin of where to place it
-	area.y(),  //y origin of where to place it
-	area.width(), 
-	area.height() );*/
+  //Publish the pixmap (pseudo-transparent clients read it instead of grabbing the root window)
+  if(xatom!=XCB_ATOM_NONE){
+    xcb_change_property(QX11Info::connection(), XCB_PROP_MODE_REPLACE, screen->root, xatom, XCB_ATOM_PIXMAP, 32, 1, &rootPixmap);
+  }
+  if(eatom!=XCB_ATOM_NONE){
+    xcb_change_property(QX11Info::connection(), XCB_PROP_MODE_REPLACE, screen->root, eatom, XCB_ATOM_PIXMAP, 32, 1, &rootPixmap);
+  }
+  uint32_t val[] = {rootPixmap};
+  xcb_change_window_attributes(QX11Info::connection(), screen->root, XCB_CW_BACK_PIXMAP, val);
+  xcb_clear_area(QX11Info::connection(), 0, screen->root, area.x(), area.y(), area.width(), area.height());
+  if(old!=0){ xcb_kill_client(QX11Info::connection(), old); } //frees the retained pixmap
   //Apply the change right now
   xcb_flush(QX11Info::connection());
-  xcb_image_destroy(image);
+}
+
+// private function
+xcb_pixmap_t LXCB::createRootPixmap(xcb_screen_t *screen, QSize size){
+  //Created on its own connection which the server keeps after it closes (like Esetroot),
+  // so _XROOTPMAP_ID/ESETROOT_PMAP_ID never point at a freed pixmap once we exit
+  xcb_connection_t *conn = xcb_connect(NULL, NULL);
+  if(xcb_connection_has_error(conn)){ xcb_disconnect(conn); return 0; }
+  xcb_pixmap_t pmap = xcb_generate_id(conn);
+  xcb_generic_error_t *err = xcb_request_check(conn, \
+		xcb_create_pixmap_checked(conn, screen->root_depth, pmap, screen->root, size.width(), size.height()) );
+  if(err!=0){ free(err); xcb_disconnect(conn); return 0; }
+  xcb_set_close_down_mode(conn, XCB_CLOSE_DOWN_RETAIN_PERMANENT);
+  xcb_aux_sync(conn);
+  xcb_disconnect(conn);
+  return pmap;
+}
+
+// private function
+void LXCB::killRootPixmap(xcb_window_t root, xcb_atom_t xatom, xcb_atom_t eatom){
+  //Only free the old pixmap when both properties agree (it was retained by a setter like us)
+  if(xatom==XCB_ATOM_NONE || eatom==XCB_ATOM_NONE){ return; }
+  xcb_get_property_cookie_t xcookie = xcb_get_property(QX11Info::connection(), 0, root, xatom, XCB_ATOM_PIXMAP, 0, 1);
+  xcb_get_property_cookie_t ecookie = xcb_get_property(QX11Info::connection(), 0, root, eatom, XCB_ATOM_PIXMAP, 0, 1);
+  xcb_get_property_reply_t *xreply = xcb_get_property_reply(QX11Info::connection(), xcookie, NULL);
+  xcb_get_property_reply_t *ereply = xcb_get_property_reply(QX11Info::connection(), ecookie, NULL);
+  if(xreply!=0 && ereply!=0 && xcb_get_property_value_length(xreply)==4 && xcb_get_property_value_length(ereply)==4){
+    xcb_pixmap_t xpmap = *((xcb_pixmap_t*) xcb_get_property_value(xreply));
+    xcb_pixmap_t epmap = *((xcb_pixmap_t*) xcb_get_property_value(ereply));
+    if(xpmap!=0 && xpmap==epmap){ xcb_kill_client(QX11Info::connection(), epmap); }
+  }
+  if(xreply!=0){ free(xreply); }
+  if(ereply!=0){ free(ereply); }
+}
+
+// private function
+bool LXCB::putImageNative(WId drawable, QImage img, QPoint pos, xcb_screen_t *screen){
+  //Slow path: build the pixels for the root visual's masks/bits per pixel through xcb_image
+  xcb_visualtype_t *visual = xcb_aux_find_visual_by_id(screen, screen->root_visual);
+  if(visual==0 || (visual->_class!=XCB_VISUAL_CLASS_TRUE_COLOR && visual->_class!=XCB_VISUAL_CLASS_DIRECT_COLOR)){ return false; }
+  uint32_t masks[3] = {visual->red_mask, visual->green_mask, visual->blue_mask};
+  int shifts[3], bits[3];
+  for(int c=0; c<3; c++){
+    shifts[c] = 0; bits[c] = 0;
+    if(masks[c]==0){ return false; }
+    while( !((masks[c]>>shifts[c]) & 1) ){ shifts[c]++; }
+    while( (masks[c]>>(shifts[c]+bits[c])) & 1 ){ bits[c]++; }
+  }
+  img = img.convertToFormat(QImage::Format_RGB32);
+  xcb_gcontext_t gc = xcb_generate_id(QX11Info::connection());
+  xcb_create_gc(QX11Info::connection(), gc, drawable, 0, NULL);
+  //Split into bands which fit into the maximum request length
+  uint32_t maxbytes = xcb_get_maximum_request_length(QX11Info::connection())*4 - 64;
+  int rows = qMax(1, (int) (maxbytes / (img.width()*4)));
+  bool ok = true;
+  for(int y=0; ok && y<img.height(); y+=rows){
+    int num = qMin(rows, img.height()-y);
+    xcb_image_t *band = xcb_image_create_native(QX11Info::connection(), img.width(), num, XCB_IMAGE_FORMAT_Z_PIXMAP, screen->root_depth, NULL, ~0, NULL);
+    if(band==0){ ok = false; break; }
+    for(int r=0; r<num; r++){
+      const QRgb *line = (const QRgb*) img.constScanLine(y+r);
+      for(int x=0; x<img.width(); x++){
+        int rgb[3] = {qRed(line[x]), qGreen(line[x]), qBlue(line[x])};
+        uint32_t pixel = 0;
+        for(int c=0; c<3; c++){
+          pixel |= ((uint32_t) ((rgb[c]*((1<<bits[c])-1) + 127)/255) << shifts[c]) & masks[c];
+        }
+        xcb_image_put_pixel(band, x, r, pixel);
+      }
+    }
+    xcb_image_put(QX11Info::connection(), drawable, gc, band, pos.x(), pos.y()+y, 0);
+    xcb_image_destroy(band);
+  }
+  xcb_free_gc(QX11Info::connection(), gc);
+  return ok;
+}
+
+// === PutImage() ===
+bool LXCB::PutImage(WId drawable, QImage img, QPoint pos, uint8_t depth){
+  if(drawable==0 || img.isNull() || !imageFormatOK(depth)){ return false; }
+  img = img.convertToFormat(depth==32 ? QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB32);
+  uint32_t bpl = img.width()*4;
+  xcb_gcontext_t gc = xcb_generate_id(QX11Info::connection());
+  xcb_create_gc(QX11Info::connection(), gc, drawable, 0, NULL);
+  bool ok = false;
+  if(shmAvailable && reserveShm(bpl*img.height())){
+    //Shared memory: the server reads the pixels directly
+    for(int y=0; y<img.height(); y++){ memcpy(shmData+(y*bpl), img.constScanLine(y), bpl); }
+    xcb_generic_error_t *err = xcb_request_check(QX11Info::connection(), \
+		xcb_shm_put_image_checked(QX11Info::connection(), drawable, gc, img.width(), img.height(), 0, 0, \
+		img.width(), img.height(), pos.x(), pos.y(), depth, XCB_IMAGE_FORMAT_Z_PIXMAP, 0, shmSeg, 0) );
+    //The reply also means the server is done with the segment (safe to reuse)
+    ok = (err==0);
+    free(err);
+  }
+  if(!ok){
+    //Socket: split into requests which fit into the maximum request length
+    uint32_t maxbytes = xcb_get_maximum_request_length(QX11Info::connection())*4 - 64;
+    int rows = qMax(1, (int) (maxbytes / bpl));
+    for(int y=0; y<img.height(); y+=rows){
+      int num = qMin(rows, img.height()-y);
+      xcb_put_image(QX11Info::connection(), XCB_IMAGE_FORMAT_Z_PIXMAP, drawable, gc, img.width(), num, \
+		pos.x(), pos.y()+y, 0, depth, num*bpl, img.constScanLine(y));
+    }
+    ok = true;
+  }
+  xcb_free_gc(QX11Info::connection(), gc);
+  return ok;
+}
+
+// === GetImage() ===
+QImage LXCB::GetImage(WId drawable, QRect area, uint8_t depth){
+  if(drawable==0 || area.isEmpty() || !imageFormatOK(depth)){ return QImage(); }
+  QImage image(area.width(), area.height(), depth==32 ? QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB32);
+  uint32_t bpl = area.width()*4;
+  uint8_t *data = 0;
+  uint32_t srcbpl = bpl;
+  xcb_get_image_reply_t *ireply = 0;
+  if(shmAvailable && reserveShm(bpl*area.height())){
+    //Shared memory: the server writes the pixels directly
+    xcb_shm_get_image_reply_t *sreply = xcb_shm_get_image_reply(QX11Info::connection(), \
+		xcb_shm_get_image(QX11Info::connection(), drawable, area.x(), area.y(), area.width(), area.height(), \
+		0xffffffff, XCB_IMAGE_FORMAT_Z_PIXMAP, shmSeg, 0), NULL);
+    if(sreply!=0){ data = shmData; free(sreply); }
+  }
+  if(data==0){
+    //Socket
+    ireply = xcb_get_image_reply(QX11Info::connection(), xcb_get_image_unchecked(QX11Info::connection(), \
+		XCB_IMAGE_FORMAT_Z_PIXMAP, drawable, area.x(), area.y(), area.width(), area.height(), 0xffffffff), NULL);
+    if(ireply==0){ return QImage(); }
+    data = xcb_get_image_data(ireply);
+    srcbpl = xcb_get_image_data_length(ireply) / area.height(); //bytes per line
+    if(srcbpl < bpl){ free(ireply); return QImage(); }
+  }
+  for(int y=0; y<area.height(); y++){
+    memcpy(image.scanLine(y), data+(y*srcbpl), bpl);
+    if(depth==24){
+      //No alpha channel on the drawable - make sure the pixels are opaque
+      QRgb *p = (QRgb*) image.scanLine(y);
+      for(int x=0; x<area.width(); x++){ p[x] |= 0xff000000; }
+    }
+  }
+  if(ireply!=0){ free(ireply); }
+  return image;
 }
 
 // === SetAsSticky() ===
@@ -937,9 +1339,12 @@ uint LXCB::EmbedWindow(WId win, WId container){
 bool LXCB::UnembedWindow(WId win){
   if(DEBUG){ qDebug() << "XCB: UnembedWindow()"; }
   if(win==0){ return false; }
+  ReleaseTrayImage(win);
   //Remove redirects
   uint32_t val[] = {XCB_EVENT_MASK_NO_EVENT};	
   xcb_change_window_attributes(QX11Info::connection(), win, XCB_CW_EVENT_MASK, val);
+  WATCHED.remove(win); //no more property events
+  PROPCACHE.remove(win);
   //Make sure it is invisible
   xcb_unmap_window(QX11Info::connection(), win);
   //Reparent the window back to the root window
@@ -949,69 +1354,60 @@ bool LXCB::UnembedWindow(WId win){
 
 // === TrayImage() ===
 QPixmap LXCB::TrayImage(WId win){
+  QImage img = TrayImage(win, QRect());
+  if(!img.isNull()){ return QPixmap::fromImage(img); }
+
+  //Not redirected (or unsupported visual) - grab the given window directly with Qt
   QPixmap pix;
-	
-  //Get the current QScreen (for XCB->Qt conversion)
   QList<QScreen*> scrnlist = QApplication::screens();
-  if(scrnlist.isEmpty()){ return pix; }	
+  if(scrnlist.isEmpty()){ return pix; }
+  pix = scrnlist[0]->grabWindow(win);
+  return pix;
+}
 
-  //Try to grab the given window directly with Qt
-  if(pix.isNull()){
-      pix = scrnlist[0]->grabWindow(win);
+QImage LXCB::TrayImage(WId win, QRect area){
+  if(DEBUG){ qDebug() << "XCB: TrayImage()" << win << area; }
+  if(win==0){ return QImage(); }
+  //The tray windows are redirected (see EmbedWindow()), so the contents live in an offscreen pixmap
+  // - name it once and keep reading from it until the window changes
+  if(!TRAYPIXMAPS.contains(win)){
+    tray_pixmap tp;
+    tp.pixmap = xcb_generate_id(QX11Info::connection());
+    xcb_void_cookie_t ncookie = xcb_composite_name_window_pixmap_checked(QX11Info::connection(), win, tp.pixmap);
+    xcb_get_geometry_cookie_t gcookie = xcb_get_geometry_unchecked(QX11Info::connection(), tp.pixmap);
+    xcb_generic_error_t *nerr = xcb_request_check(QX11Info::connection(), ncookie);
+    xcb_generic_error_t *gerr = 0;
+    xcb_get_geometry_reply_t *greply = xcb_get_geometry_reply(QX11Info::connection(), gcookie, &gerr);
+    bool ok = (nerr==0 && greply!=0);
+    if(ok){
+      tp.size = QSize(greply->width, greply->height);
+      tp.depth = greply->depth;
+      ok = imageFormatOK(tp.depth) && !tp.size.isEmpty(); //only plain 32-bit pixels are read directly
+    }
+    free(nerr);
+    free(gerr);
+    free(greply);
+    if(!ok){
+      if(nerr==0){ xcb_free_pixmap(QX11Info::connection(), tp.pixmap); }
+      return QImage();
+    }
+    TRAYPIXMAPS.insert(win, tp);
   }
-  return pix;
-  
-  //NOTE: Code below here saved for reference later (as necessary)
-  // -------------------------------
-  /*//First get the pixmap from the XCB compositing layer (since the tray images are redirected there)
-  xcb_pixmap_t pixmap = xcb_generate_id(QX11Info::connection());
-  xcb_composite_name_window_pixmap(QX11Info::connection(), win, pixmap);
-  //Get the sizing information about the pixmap
-  xcb_get_geometry_cookie_t Gcookie = xcb_get_geometry_unchecked(QX11Info::connection(), pixmap);
-  xcb_get_geometry_reply_t *Greply = xcb_get_geometry_reply(QX11Info::connection(), Gcookie, NULL);
-  if(Greply==0){ qDebug() << "[Tray Image] - Geom Fetch Error:"; return QPixmap(); } //Error in geometry detection
-  
-  //Now convert the XCB pixmap into an XCB image
-  xcb_get_image_cookie_t GIcookie = xcb_get_image_unchecked(QX11Info::connection(), XCB_IMAGE_FORMAT_Z_PIXMAP, pixmap, 0, 0, Greply->width, Greply->height, 0xffffffff);
-  xcb_get_image_reply_t *GIreply = xcb_get_image_reply(QX11Info::connection(), GIcookie, NULL);
-  if(GIreply==0){ qDebug() << "[Tray Image] - Image Convert Error:"; return QPixmap(); } //Error in conversion
-  uint8_t *GIdata = xcb_get_image_data(GIreply);
-  uint32_t BPL = xcb_get_image_data_length(GIreply) / Greply->height; //bytes per line
-  //Now convert the XCB image into a Qt Image
-  QImage image(const_cast<uint8_t *>(GIdata), Greply->width, Greply->height, BPL, QImage::Format_ARGB32_Premultiplied);
-  //Free the various data structures 
-  free(GIreply); //done with get image reply
-  xcb_free_pixmap(QX11Info::connection(), pixmap); //done with the raw pixmap
-  free(Greply); //done with geom reply*/
-  
-  /* NOTE: Found these little bit in the Qt sources - not sure if it is needed, but keep it here for reference
-        // we may have to swap the byte order based on system type
-        uint8_t image_byte_order = connection->setup()->image_byte_order;
-        if ((QSysInfo::ByteOrder == QSysInfo::LittleEndian && image_byte_order == XCB_IMAGE_ORDER_MSB_FIRST)
-            || (QSysInfo::ByteOrder == QSysInfo::BigEndian && image_byte_order == XCB_IMAGE_ORDER_LSB_FIRST))
-        {
-            for (int i=0; i < image.height(); i++) {
-                    uint *p = (uint*)image.scanLine(i);
-                    uint *end = p + image.width();
-                    while (p < end) {
-                        *p = ((*p << 24) & 0xff000000) | ((*p << 8) & 0x00ff0000)
-                            | ((*p >> 8) & 0x0000ff00) | ((*p >> 24) & 0x000000ff);
-                        p++;
-                    }
-            }
-        }*/
-
-        // fix-up alpha channel
-        /*if (image.format() == QImage::Format_RGB32) {
-            QRgb *p = (QRgb *)image.bits();
-            for (int y = 0; y < height; ++y) {
-                for (int x = 0; x < width; ++x)
-                    p[x] |= 0xff000000;
-                p += bytes_per_line / 4;
-            }*/
-
-  //Convert the QImage into a QPixmap and return it
-  //return QPixmap::fromImage(image.copy());
+  tray_pixmap tp = TRAYPIXMAPS.value(win);
+  if(area.isEmpty()){ area = QRect(QPoint(0,0), tp.size); }
+  else{ area = area.intersected(QRect(QPoint(0,0), tp.size)); }
+  if(area.isEmpty()){ return QImage(); }
+
+  //Only transfer the requested area
+  QImage image = GetImage(tp.pixmap, area, tp.depth);
+  if(image.isNull()){ ReleaseTrayImage(win); } //window changed - name the pixmap again next time
+  return image;
+}
+
+// === ReleaseTrayImage() ===
+void LXCB::ReleaseTrayImage(WId win){
+  if(!TRAYPIXMAPS.contains(win)){ return; }
+  xcb_free_pixmap(QX11Info::connection(), TRAYPIXMAPS.take(win).pixmap);
 }
 
 // ===== startSystemTray() =====
@@ -1287,13 +1683,7 @@ bool LXCB::setupEventsForRoot(WId root){
 // --------------------------------------------------
 // -- WM_NAME
 QString LXCB::WM_ICCCM_GetName(WId win){
-  xcb_get_property_cookie_t cookie = xcb_icccm_get_wm_name_unchecked(QX11Info::connection(), win);
-  xcb_icccm_get_text_property_reply_t reply;
-  if(1 != xcb_icccm_get_wm_name_reply(QX11Info::connection(), cookie, &reply, NULL) ){
-    return ""; //error in fetching name
-  }else{
-    return QString::fromLocal8Bit(reply.name);
-  }
+  return QString::fromLocal8Bit( windowProperty(win, XCB_ATOM_WM_NAME, XCB_GET_PROPERTY_TYPE_ANY, 0) );
 }
 
 void LXCB::WM_ICCCM_SetName(WId win, QString name){
@@ -1302,13 +1692,7 @@ void LXCB::WM_ICCCM_SetName(WId win, QString name){
 
 // -- WM_ICON_NAME
 QString LXCB::WM_ICCCM_GetIconName(WId win){
-  xcb_get_property_cookie_t cookie = xcb_icccm_get_wm_icon_name_unchecked(QX11Info::connection(), win);
-  xcb_icccm_get_text_property_reply_t reply;
-  if(1 != xcb_icccm_get_wm_icon_name_reply(QX11Info::connection(), cookie, &reply, NULL) ){
-    return ""; //error in fetching name
-  }else{
-    return QString::fromLocal8Bit(reply.name);
-  }
+  return QString::fromLocal8Bit( windowProperty(win, XCB_ATOM_WM_ICON_NAME, XCB_GET_PROPERTY_TYPE_ANY, 0) );
 }
 
 void LXCB::WM_ICCCM_SetIconName(WId win, QString name){
@@ -1317,13 +1701,7 @@ void LXCB::WM_ICCCM_SetIconName(WId win, QString name){
 
 // -- WM_CLIENT_MACHINE
 QString LXCB::WM_ICCCM_GetClientMachine(WId win){
-  xcb_get_property_cookie_t cookie = xcb_icccm_get_wm_client_machine_unchecked(QX11Info::connection(), win);
-  xcb_icccm_get_text_property_reply_t reply;
-  if(1 != xcb_icccm_get_wm_client_machine_reply(QX11Info::connection(), cookie, &reply, NULL) ){
-    return ""; //error in fetching name
-  }else{
-    return QString::fromLocal8Bit(reply.name);
-  }
+  return QString::fromLocal8Bit( windowProperty(win, XCB_ATOM_WM_CLIENT_MACHINE, XCB_GET_PROPERTY_TYPE_ANY, 0) );
 }
 
 void LXCB::WM_ICCCM_SetClientMachine(WId win, QString name){
@@ -1332,14 +1710,10 @@ void LXCB::WM_ICCCM_SetClientMachine(WId win, QString name){
 
 // -- WM_CLASS
 QString LXCB::WM_ICCCM_GetClass(WId win){
-  xcb_get_property_cookie_t cookie = xcb_icccm_get_wm_class_unchecked(QX11Info::connection(), win);
-  xcb_icccm_get_wm_class_reply_t reply;
-  if(1 != xcb_icccm_get_wm_class_reply(QX11Info::connection(), cookie, &reply, NULL) ){
-    return ""; //error in fetching name
-  }else{
-    //Returns: "<instance name>::::<class name>"
-    return ( QString::fromLocal8Bit(reply.instance_name)+"::::"+QString::fromLocal8Bit(reply.class_name) );
-  }
+  QList<QByteArray> names = windowProperty(win, XCB_ATOM_WM_CLASS, XCB_ATOM_STRING, 8).split('\0');
+  if(names.length()<2){ return ""; } //error in fetching name
+  //Returns: "<instance name>::::<class name>"
+  return ( QString::fromLocal8Bit(names[0])+"::::"+QString::fromLocal8Bit(names[1]) );
 }
 
 void LXCB::WM_ICCCM_SetClass(WId win, QString name){
@@ -1348,13 +1722,7 @@ void LXCB::WM_ICCCM_SetClass(WId win, QString name){
 
 // -- WM_TRANSIENT_FOR
 WId LXCB::WM_ICCCM_GetTransientFor(WId win){
-  xcb_get_property_cookie_t cookie = xcb_icccm_get_wm_transient_for_unchecked(QX11Info::connection(), win);
-  xcb_window_t trans;
-  if(1!= xcb_icccm_get_wm_transient_for_reply(QX11Info::connection(), cookie, &trans, NULL) ){
-    return win; //error in fetching transient window ID (or none found)
-  }else{
-    return trans;
-  }
+  return windowCardinal(win, XCB_ATOM_WM_TRANSIENT_FOR, XCB_ATOM_WINDOW, win); //"win" if none found
 }
 
 void LXCB::WM_ICCCM_SetTransientFor(WId win, WId transient){
@@ -1839,22 +2207,8 @@ QList<LXCB::WINDOWTYPE> LXCB::WM_Get_Window_Type(WId win){
   xcb_get_property_cookie_t cookie = xcb_ewmh_get_wm_window_type_unchecked(&EWMH, win);
   xcb_ewmh_get_atoms_reply_t reply;
   if(1==xcb_ewmh_get_wm_window_type_reply(&EWMH, cookie, &reply, NULL) ){
-    for(unsigned int i=0; i<reply.atoms_len; i++){
-      if(reply.atoms[i]==EWMH._NET_WM_WINDOW_TYPE_DESKTOP){ out << LXCB::T_DESKTOP; }
-      else if(reply.atoms[i]==EWMH._NET_WM_WINDOW_TYPE_DOCK){ out << LXCB::T_DOCK; }
-      else if(reply.atoms[i]==EWMH._NET_WM_WINDOW_TYPE_TOOLBAR){ out << LXCB::T_TOOLBAR; }
-      else if(reply.atoms[i]==EWMH._NET_WM_WINDOW_TYPE_MENU){ out << LXCB::T_MENU; }
-      else if(reply.atoms[i]==EWMH._NET_WM_WINDOW_TYPE_UTILITY){ out << LXCB::T_UTILITY; }
-      else if(reply.atoms[i]==EWMH._NET_WM_WINDOW_TYPE_SPLASH){ out << LXCB::T_SPLASH; }
-      else if(reply.atoms[i]==EWMH._NET_WM_WINDOW_TYPE_DIALOG){ out << LXCB::T_DIALOG; }
-      else if(reply.atoms[i]==EWMH._NET_WM_WINDOW_TYPE_DROPDOWN_MENU){ out << LXCB::T_DROPDOWN_MENU; }
-      else if(reply.atoms[i]==EWMH._NET_WM_WINDOW_TYPE_POPUP_MENU){ out << LXCB::T_POPUP_MENU; }
-      else if(reply.atoms[i]==EWMH._NET_WM_WINDOW_TYPE_TOOLTIP){ out << LXCB::T_TOOLTIP; }
-      else if(reply.atoms[i]==EWMH._NET_WM_WINDOW_TYPE_NOTIFICATION){ out << LXCB::T_NOTIFICATION; }
-      else if(reply.atoms[i]==EWMH._NET_WM_WINDOW_TYPE_COMBO){ out << LXCB::T_COMBO; }
-      else if(reply.atoms[i]==EWMH._NET_WM_WINDOW_TYPE_DND){ out << LXCB::T_DND; }
-      else if(reply.atoms[i]==EWMH._NET_WM_WINDOW_TYPE_NORMAL){ out << LXCB::T_NORMAL; }
-    }
+    out = typesFromAtoms(&reply);
+    xcb_ewmh_get_atoms_reply_wipe(&reply);
   }
   return out;
 }
@@ -1904,21 +2258,8 @@ QList<LXCB::WINDOWSTATE> LXCB::WM_Get_Window_States(WId win){
   xcb_get_property_cookie_t cookie = xcb_ewmh_get_wm_state_unchecked(&EWMH, win);
   xcb_ewmh_get_atoms_reply_t reply;
   if(1==xcb_ewmh_get_wm_state_reply(&EWMH, cookie, &reply, NULL) ){
-    for(unsigned int i=0; i<reply.atoms_len; i++){
-      if(reply.atoms[i]==EWMH._NET_WM_STATE_MODAL){ out << LXCB::S_MODAL; }
-      else if(reply.atoms[i]==EWMH._NET_WM_STATE_STICKY){ out << LXCB::S_STICKY; }
-      else if(reply.atoms[i]==EWMH._NET_WM_STATE_MAXIMIZED_VERT){ out << LXCB::S_MAX_VERT; }
-      else if(reply.atoms[i]==EWMH._NET_WM_STATE_MAXIMIZED_HORZ){ out << LXCB::S_MAX_HORZ; }
-      else if(reply.atoms[i]==EWMH._NET_WM_STATE_SHADED){ out << LXCB::S_SHADED; }
-      else if(reply.atoms[i]==EWMH._NET_WM_STATE_SKIP_TASKBAR){ out << LXCB::S_SKIP_TASKBAR; }
-      else if(reply.atoms[i]==EWMH._NET_WM_STATE_SKIP_PAGER){ out << LXCB::S_SKIP_PAGER; }
-      else if(reply.atoms[i]==EWMH._NET_WM_STATE_HIDDEN){ out << LXCB::S_HIDDEN; }
-      else if(reply.atoms[i]==EWMH._NET_WM_STATE_FULLSCREEN){ out << LXCB::S_FULLSCREEN; }
-      else if(reply.atoms[i]==EWMH._NET_WM_STATE_ABOVE){ out << LXCB::S_ABOVE; }
-      else if(reply.atoms[i]==EWMH._NET_WM_STATE_BELOW){ out << LXCB::S_BELOW; }
-      else if(reply.atoms[i]==EWMH._NET_WM_STATE_DEMANDS_ATTENTION){ out << LXCB::S_ATTENTION; }
-      //else if(reply.atoms[i]==EWMH._NET_WM_STATE_FOCUSED){ out << LXCB::FOCUSED; }
-    }
+    out = statesFromAtoms(&reply);
+    xcb_ewmh_get_atoms_reply_wipe(&reply);
   }
   return out;
 }
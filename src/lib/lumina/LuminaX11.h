@@ -22,8 +22,11 @@
 #include <QPainter>
 #include <QObject>
 #include <QFlags>
+#include <QHash>
+#include <QSet>
 
 #include <xcb/xcb_ewmh.h>
+#include <xcb/shm.h>
 
 //SYSTEM TRAY STANDARD DEFINITIONS
 #define _NET_SYSTEM_TRAY_ORIENTATION_HORZ 0
@@ -107,6 +110,22 @@ public:
 	enum MOVERESIZE_WINDOW_FLAG { X=0x0, Y=0x1, WIDTH=0x2, HEIGHT=0x3};
 	Q_DECLARE_FLAGS(MOVERESIZE_WINDOW_FLAGS, MOVERESIZE_WINDOW_FLAG);
 
+	//Per-window information from a batched query (see WindowRecords())
+	struct window_record{
+	  WId id;
+	  QString wclass; //WM_CLASS (class name)
+	  unsigned int desktop; //_NET_WM_DESKTOP (the current workspace for sticky windows)
+	  QList<LXCB::WINDOWSTATE> states; //_NET_WM_STATE
+	  QList<LXCB::WINDOWTYPE> types; //_NET_WM_WINDOW_TYPE
+	};
+
+	//Per-window geometry from a batched query (see WindowGeometries())
+	struct window_geometry{
+	  WId id;
+	  QRect geom; //window geometry in root coordinates (frame excluded) - null if not available
+	  QList<int> frame; //[top,bottom,left,right] sizes of the frame
+	};
+
 	xcb_ewmh_connection_t EWMH; //This is where all the screen info and atoms are located
 
 	LXCB();
@@ -115,6 +134,9 @@ public:
 	//== Main Interface functions ==
 	// General Information
 	QList<WId> WindowList(bool rawlist = false); //list all non-Lumina windows (rawlist -> all workspaces)
+	QList<WId> ClientList(); //_NET_CLIENT_LIST (unfiltered)
+	QList<LXCB::window_record> WindowListRecords(bool rawlist = false); //same as WindowList(), with the info for each window
+	QList<LXCB::window_record> WindowRecords(QList<WId> wins, unsigned int *current = 0); //batched: all requests are sent before any reply is read
 	unsigned int CurrentWorkspace();
 	unsigned int NumberOfWorkspaces();
 	WId ActiveWindow(); //fetch the ID for the currently active window
@@ -129,6 +151,7 @@ public:
 	unsigned int WindowWorkspace(WId); //The workspace the window is on
 	QRect WindowGeometry(WId win, bool includeFrame = true); //the geometry of the window (frame excluded)
 	QList<int> WindowFrameGeometry(WId win); //Returns: [top,bottom,left,right] sizes of the frame
+	QList<LXCB::window_geometry> WindowGeometries(QList<WId> wins); //batched WindowGeometry(win,false) + WindowFrameGeometry()
 	LXCB::WINDOWVISIBILITY WindowState(WId win); //Visible state of window
 	QString WindowVisibleIconName(WId win); //_NET_WM_VISIBLE_ICON_NAME
 	QString WindowIconName(WId win); //_NET_WM_ICON_NAME
@@ -138,13 +161,26 @@ public:
 	QString OldWindowIconName(WId win); //WM_ICON_NAME (old standard)
 	bool WindowIsMaximized(WId win);
 	int WindowIsFullscreen(WId win); //Returns the screen number if the window is fullscreen (or -1)
-	QIcon WindowIcon(WId win); //_NET_WM_ICON
+	int WindowIsFullscreen(WId win, QRect geom); //same, with the geometry already known (WindowGeometries())
+	QStringList WindowTitles(QList<WId> wins); //batched title lookup (same order of preference as the task manager)
+	QIcon WindowIcon(WId win, int size = 64); //_NET_WM_ICON (cached - best match for the given size)
+	void InvalidateWindowIcon(WId win); //use on PropertyNotify for _NET_WM_ICON (or when the window is gone)
+
+	//Property cache
+	// - Name/class/workspace/state getters (and the WM_ICCCM_* family) remember the raw property data
+	//   for every window with PropertyNotify selected (SelectInput()) until the property changes
+	void PropertyChanged(WId win, xcb_atom_t atom); //use on every PropertyNotify event
+	void ForgetWindow(WId win); //use on DestroyNotify or when it leaves the client list
 
 	//Window Modification
 	// - SubStructure simplifications (not commonly used)
 	void SelectInput(WId win, bool isEmbed = false); //XSelectInput replacement (to see window events)
 	uint GenerateDamageID(WId);
-	void paintRoot(QRect area, const QPixmap *pix);
+	void paintRoot(QRect area, const QPixmap *pix); //also published as _XROOTPMAP_ID/ESETROOT_PMAP_ID
+
+	// - Image transfers (MIT-SHM if the server shares memory with us, socket otherwise)
+	bool PutImage(WId drawable, QImage img, QPoint pos, uint8_t depth);
+	QImage GetImage(WId drawable, QRect area, uint8_t depth); //depth 24 (opaque) or 32 (ARGB) drawables only
 
 	// - General Window Modifications
 	void SetAsSticky(WId); //Stick to all workspaces
@@ -166,7 +202,9 @@ public:
 	//void SetWindowBackground(QWidget *parent, QRect area, WId client);
 	uint EmbedWindow(WId win, WId container); //returns the damage ID (or 0 for an error)
 	bool UnembedWindow(WId win);
-	QPixmap TrayImage(WId win);
+	QPixmap TrayImage(WId win); //whole window (composite pixmap - screen grab as a fallback)
+	QImage TrayImage(WId win, QRect area); //only the given area of the composite pixmap (empty area: whole window)
+	void ReleaseTrayImage(WId win); //use when the tray window was resized/unmapped/detached
 
 	//System Tray Management
 	WId startSystemTray(int screen = 0); //Startup the system tray (returns window ID for tray)
@@ -422,7 +460,51 @@ private:
 	QList<xcb_atom_t> ATOMS;
 	QStringList atoms;
 
+	//Window icon cache (_NET_WM_ICON)
+	struct wm_icon_cache{
+	  QIcon icon;
+	  int size; //size which was requested when fetched
+	};
+	QHash<WId, wm_icon_cache> ICONCACHE;
+	QImage fetchWindowIcon(WId win, int size); //transfer only the best icon size
+
+	//Property cache (see PropertyChanged())
+	QHash<WId, QHash<xcb_atom_t, QByteArray> > PROPCACHE; //window -> atom -> raw data
+	QSet<WId> WATCHED; //windows which send us PropertyNotify events
+	//raw property data (cached if possible), empty if not set or of another type/format (format 0: any)
+	QByteArray windowProperty(WId win, xcb_atom_t atom, xcb_atom_t type, uint8_t format);
+	uint32_t windowCardinal(WId win, xcb_atom_t atom, xcb_atom_t type, uint32_t fallback); //first 32-bit value
+	QList<xcb_atom_t> windowAtoms(WId win, xcb_atom_t atom);
+
+	//Named composite pixmaps for embedded tray windows
+	struct tray_pixmap{
+	  xcb_pixmap_t pixmap;
+	  QSize size;
+	  uint8_t depth;
+	};
+	QHash<WId, tray_pixmap> TRAYPIXMAPS;
+
+	//MIT-SHM segment (grown as needed and reused for every transfer)
+	bool shmAvailable;
+	xcb_shm_seg_t shmSeg;
+	int shmId;
+	uint8_t *shmData;
+	size_t shmSize;
+	void initShm(); //negotiated once at startup
+	bool reserveShm(size_t bytes);
+	void releaseShm();
+	bool imageFormatOK(uint8_t depth); //32 bits per pixel in the local byte order
+
+	//Root window background (kept on the server for pseudo-transparent clients)
+	xcb_pixmap_t rootPixmap;
+	QSize rootPixmapSize;
+	xcb_pixmap_t createRootPixmap(xcb_screen_t *screen, QSize size); //retained by the server (RetainPermanent)
+	void killRootPixmap(xcb_window_t root, xcb_atom_t xatom, xcb_atom_t eatom); //pixmap of the previous setter
+	bool putImageNative(WId drawable, QImage img, QPoint pos, xcb_screen_t *screen); //any TrueColor visual (slow)
+
 	void createWMAtoms(); //fill the private lists above
+	QList<LXCB::WINDOWSTATE> statesFromAtoms(xcb_ewmh_get_atoms_reply_t *reply);
+	QList<LXCB::WINDOWTYPE> typesFromAtoms(xcb_ewmh_get_atoms_reply_t *reply);
 };
 //Now also declare the flags for Qt to be able to use normal operations on them
 Q_DECLARE_OPERATORS_FOR_FLAGS(LXCB::ICCCM_PROTOCOLS);
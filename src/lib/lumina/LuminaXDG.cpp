@@ -56,6 +56,7 @@
 #include "LuminaXDG.h"
 //#include "LuminaOS.h"
 #include "LUtils.h"
+#include "LIconCache.h"
 #include <QObject>
 #include <QTimer>
 //#include <QMediaPlayer>
@@ -942,168 +943,9 @@ void LXDG::setEnvironmentVars(){
 
 QIcon LXDG::findIcon(QString iconName, QString fallback)
 {
-
-    // Get the currently-set theme
-    QString cTheme = QIcon::themeName();
-    if (cTheme.isEmpty() || cTheme == "hicolor") {
-        QIcon::setThemeName("Adwaita");
-        cTheme = "Adwaita";
-    }
-
-    // Setup theme path
-    /*if (cTheme == "Adwaita") {
-        QStringList iconPaths = QIcon::themeSearchPaths();
-        iconPaths.prepend(":/icons");
-        QIcon::setThemeSearchPaths(iconPaths);
-    }*/
-
-    // filter "bad" icons
-    iconName = Draco::filterIconName(iconName);
-
-    qDebug() << "FIND ICON" << iconName << fallback;
-    if (iconName.isEmpty()){
-        qDebug() << "EMPTY ICONNAME" << iconName << fallback;
-        QIcon fallbackIcon = QIcon::fromTheme(fallback);
-        if (!fallbackIcon.isNull()) {
-            qDebug() << "USE FALLBACK";
-            return fallbackIcon;
-        }
-        qDebug() << "NO ICON, RETURN DUMMY";
-        return QIcon::fromTheme("application-x-executable");
-    }
-
-    if (QFile::exists(iconName) &&
-        iconName.startsWith(QString("/")))
-    {
-        qDebug() << "FOUND VALID ICON WITH ABSOLUTE PATH" << iconName;
-        return QIcon(iconName);
-    }
-    else if (iconName.startsWith("/")) { iconName.section("/",-1); }
-
-    QIcon tmp = QIcon::fromTheme(iconName);
-    if (!tmp.isNull() &&
-       tmp.name()==iconName)
-    {
-        qDebug() << "FOUND ICON FROM THEME" << iconName;
-        return tmp;
-    }
-
-
-    // Now try to find the icon from the theme
-    qDebug() << "[LXDG] Start search for icon" << iconName;
-
-
-  //Make sure the current search paths correspond to this theme
-  if( QDir::searchPaths("icontheme").filter("/"+cTheme+"/").isEmpty() ){
-    //Need to reset search paths: setup the "icontheme" "material-design-light" and "fallback" sets
-    // - Get all the base icon directories
-    QStringList paths;
-      paths << QDir::homePath()+"/.icons/"; //ordered by priority - local user dirs first
-      QStringList xdd = QString(getenv("XDG_DATA_HOME")).split(":");
-        xdd << QString(getenv("XDG_DATA_DIRS")).split(":");
-        for(int i=0; i<xdd.length(); i++){
-          if(QFile::exists(xdd[i]+"/icons")){ paths << xdd[i]+"/icons/"; }
-        }
-        qDebug() << "ICON PATHS" << paths;
-    //Now load all the dirs into the search paths
-    QStringList theme, oxy, fall;
-    QStringList themedeps = getIconThemeDepChain(cTheme, paths);
-    for(int i=0; i<paths.length(); i++){
-      theme << getChildIconDirs( paths[i]+cTheme);
-      for(int j=0; j<themedeps.length(); j++){ theme << getChildIconDirs(paths[i]+themedeps[j]); }
-      //oxy << getChildIconDirs(paths[i]+"material-design-light"); //Lumina base icon set
-      fall << getChildIconDirs(paths[i]+"hicolor"); //XDG fallback (apps add to this)
-    }
-    //Now load all the icon theme dependencies in order (Theme1 -> Theme2 -> Theme3 -> Fallback)
-
-    //fall << LOS::AppPrefix()+"share/pixmaps"; //always use this as well as a final fallback
-    QDir::setSearchPaths("icontheme", theme);
-    QDir::setSearchPaths("default", oxy);
-    QDir::setSearchPaths("fallback", fall);
-    //qDebug() << "Setting Icon Search Paths:" << "\nicontheme:" << theme << "\nmaterial-design-light:" << oxy << "\nfallback:" << fall;
-  }
-  //Find the icon in the search paths
-  QIcon ico;
-  QStringList srch; srch << "icontheme" << "default" << "fallback";
-  for(int i=0; i<srch.length() && ico.isNull(); i++){
-
-    if(QFile::exists(srch[i]+":"+iconName+".png")){
-      //simple PNG image - load directly into the QIcon structure
-      ico.addFile(srch[i]+":"+iconName+".png");
-    } else if(QFile::exists(srch[i]+":"+iconName+".jpg")){
-        //simple JPG image - load directly into the QIcon structure
-        ico.addFile(srch[i]+":"+iconName+".jpg");
-      } else if(QFile::exists(srch[i]+":"+iconName+".xpm")){
-        // simple XPM image - load directly into the QIcon structure
-        ico.addFile(srch[i]+":"+iconName+".xpm");
-      }
-
-
-  }
-  //If still no icon found, look for any image format in the "pixmaps" directory
-  if(ico.isNull()){
-      qDebug() << "FALLBACK TO PIXMAPS!";
-    /*if(QFile::exists(LOS::AppPrefix()+"share/pixmaps/"+iconName)){
-      ico.addFile(LOS::AppPrefix()+"share/pixmaps/"+iconName);
-    }else{*/
-      //Need to scan for any close match in the directory
-
-      QStringList pixmaps = Draco::pixmapLocations(qApp->applicationFilePath());
-      for (int x = 0;x<pixmaps.size();++x) {
-
-      QDir pix(pixmaps.at(x));//(LOS::AppPrefix()+"share/pixmaps");
-      QStringList formats = LUtils::imageExtensions();
-      QStringList found = pix.entryList(QStringList() << iconName, QDir::Files, QDir::Unsorted);
-      if(found.isEmpty()){ found = pix.entryList(QStringList() << iconName+"*", QDir::Files, QDir::Unsorted); }
-      //qDebug() << "Found pixmaps:" << found << formats;
-      //Use the first one found that is a valid format
-      for(int i=0; i<found.length(); i++){
-        if( formats.contains(found[i].section(".",-1).toLower()) ){
-            QString pixFound = pix.absoluteFilePath(found[i]);
-            qDebug() << "FOUND PIXMAP!" << pixFound;
-      //ico.addFile( pix.absoluteFilePath(found[i]) );
-            ico.addFile(pixFound);
-             /*QIcon pixIco(pixFound);
-             if (!pixIco.isNull()) {
-                 qDebug() << "RETURN VALID PIX";
-                 return pixIco;
-             }*/
-	  break;
-	}
-      //}
-
-    }
-
-      }
-  }
-
-
-
-  //Use the fallback icon if necessary
-  if(ico.isNull() ){
-      qDebug() << "STILL NO ICON!";
-    if(!fallback.isEmpty()){ ico = LXDG::findIcon(fallback,""); }
-    else if(iconName.contains("-x-") && !iconName.endsWith("-x-generic")){
-      //mimetype - try to use the generic type icon
-      ico = LXDG::findIcon(iconName.section("-x-",0,0)+"-x-generic", "");
-    }else if(iconName.contains("-")){
-      ico = LXDG::findIcon(iconName.section("-",0,-2), ""); //chop the last modifier off the end and try again
-    }
-  }
-  if(ico.isNull()){
-      if (!fallback.isEmpty() &&
-         QIcon::hasThemeIcon(fallback))
-      {
-          qDebug() << "RETURN FALLBACK";
-          tmp = QIcon::fromTheme(fallback);
-          return tmp;
-      }
-    qDebug() << "FIND ICON FAIL!!!!!!" << iconName << fallback;
-    ico = QIcon::fromTheme("application-x-executable");
-  }
-  //Return the icon
-  qDebug() << "RETURN ICON FOR" << iconName << fallback << !ico.isNull();
-  return ico;
+    // The icon cache owns the theme index and the resolved icons,
+    // so repeated lookups from any widget share the same results
+    return LIconCache::instance()->findIcon(iconName, fallback);
 }
 
 QStringList LXDG::getChildIconDirs(QString parent){
@@ -243,7 +243,7 @@ public:
 	//static QString getDesktopExec(XDGDesktop *app, QString ActionID = "");
 	//Set all the default XDG Environment variables
 	static void setEnvironmentVars();
-	//Find an icon from the current/default theme
+	//Find an icon from the current/default theme (served by LIconCache::instance())
 	static QIcon findIcon(QString iconName, QString fallback = "");
 	//Recursivly compile a list of child directories with *.png files in them
 	static QStringList getChildIconDirs(QString parent);
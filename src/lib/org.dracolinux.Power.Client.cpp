@@ -20,6 +20,12 @@
 */
 
 #include "org.dracolinux.Power.Client.h"
+#include "draco.h"
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
+#include <QDBusServiceWatcher>
 #include <QDebug>
 
 double PowerClient::getBatteryLeft(QDBusInterface *iface)
@@ -158,3 +164,133 @@ bool PowerClient::poweroff(QDBusInterface *iface)
     qDebug() << "reply" << ok;
     return ok;
 }
+
+PowerStateClient::PowerStateClient(QObject *parent)
+    : QObject(parent)
+    , pending(false)
+    , watcher(nullptr)
+{
+    QDBusConnection session = QDBusConnection::sessionBus();
+    session.connect(Draco::powerSessionName(),
+                    Draco::powerSessionPath(),
+                    Draco::powerSessionName(),
+                    "StateChanged",
+                    this,
+                    SLOT(handleStateChanged(QVariantMap)));
+    watcher = new QDBusServiceWatcher(Draco::powerSessionName(),
+                                      session,
+                                      QDBusServiceWatcher::WatchForRegistration |
+                                      QDBusServiceWatcher::WatchForUnregistration,
+                                      this);
+    connect(watcher,
+            SIGNAL(serviceRegistered(QString)),
+            this,
+            SLOT(handleServiceRegistered()));
+    connect(watcher,
+            SIGNAL(serviceUnregistered(QString)),
+            this,
+            SLOT(handleServiceUnregistered()));
+    refresh();
+}
+
+bool PowerStateClient::isValid()
+{
+    return !_state.isEmpty();
+}
+
+QVariantMap PowerStateClient::state()
+{
+    return _state;
+}
+
+double PowerStateClient::batteryLeft()
+{
+    return _state.value("BatteryLeft", 0).toDouble();
+}
+
+bool PowerStateClient::hasBattery()
+{
+    return _state.value("HasBattery", false).toBool();
+}
+
+bool PowerStateClient::onBattery()
+{
+    return _state.value("OnBattery", false).toBool();
+}
+
+qlonglong PowerStateClient::timeToEmpty()
+{
+    return _state.value("TimeToEmpty", 0).toLongLong();
+}
+
+bool PowerStateClient::canHibernate()
+{
+    return _state.value("CanHibernate", false).toBool();
+}
+
+bool PowerStateClient::canSuspend()
+{
+    return _state.value("CanSuspend", false).toBool();
+}
+
+bool PowerStateClient::canRestart()
+{
+    return _state.value("CanRestart", false).toBool();
+}
+
+bool PowerStateClient::canPowerOff()
+{
+    return _state.value("CanPowerOff", false).toBool();
+}
+
+bool PowerStateClient::lidIsPresent()
+{
+    return _state.value("LidIsPresent", false).toBool();
+}
+
+// ask for the full state (async)
+void PowerStateClient::refresh()
+{
+    if (pending) { return; }
+    QDBusMessage call = QDBusMessage::createMethodCall(Draco::powerSessionName(),
+                                                       Draco::powerSessionPath(),
+                                                       Draco::powerSessionName(),
+                                                       "State");
+    QDBusPendingCall reply = QDBusConnection::sessionBus().asyncCall(call);
+    QDBusPendingCallWatcher *callWatcher = new QDBusPendingCallWatcher(reply, this);
+    connect(callWatcher,
+            SIGNAL(finished(QDBusPendingCallWatcher*)),
+            this,
+            SLOT(handleState(QDBusPendingCallWatcher*)));
+    pending = true;
+}
+
+void PowerStateClient::handleState(QDBusPendingCallWatcher *call)
+{
+    pending = false;
+    QDBusPendingReply<QVariantMap> reply = *call;
+    call->deleteLater();
+    if (reply.isError()) {
+        qDebug() << "power state not available" << reply.error().message();
+        return;
+    }
+    handleStateChanged(reply.value());
+}
+
+void PowerStateClient::handleStateChanged(const QVariantMap &state)
+{
+    if (state == _state) { return; }
+    _state = state;
+    emit stateChanged();
+}
+
+void PowerStateClient::handleServiceRegistered()
+{
+    refresh();
+}
+
+void PowerStateClient::handleServiceUnregistered()
+{
+    _state.clear();
+    emit stateChanged();
+}
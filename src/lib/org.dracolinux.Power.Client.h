@@ -22,8 +22,13 @@
 #ifndef POWER_CLIENT_H
 #define POWER_CLIENT_H
 
+#include <QObject>
+#include <QVariantMap>
 #include <QDBusInterface>
 
+class QDBusPendingCallWatcher;
+class QDBusServiceWatcher;
+
 class PowerClient
 {
 public:
@@ -43,4 +48,42 @@ public:
     static bool poweroff(QDBusInterface *iface);
 };
 
+// Local mirror of the power state, filled by one async State() call
+// and kept up to date from the StateChanged signal (no blocking calls)
+class PowerStateClient : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PowerStateClient(QObject *parent = nullptr);
+    bool isValid();
+    QVariantMap state();
+    double batteryLeft();
+    bool hasBattery();
+    bool onBattery();
+    qlonglong timeToEmpty();
+    bool canHibernate();
+    bool canSuspend();
+    bool canRestart();
+    bool canPowerOff();
+    bool lidIsPresent();
+
+private:
+    QVariantMap _state;
+    bool pending;
+    QDBusServiceWatcher *watcher;
+
+signals:
+    void stateChanged();
+
+public slots:
+    void refresh();
+
+private slots:
+    void handleState(QDBusPendingCallWatcher *call);
+    void handleStateChanged(const QVariantMap &state);
+    void handleServiceRegistered();
+    void handleServiceUnregistered();
+};
+
 #endif // POWER_CLIENT_H
@@ -22,7 +22,10 @@
 #include "org.dracolinux.Power.Device.h"
 
 #include <QDBusConnection>
-#include <QStringList>
+#include <QDBusMessage>
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
+#include <QDebug>
 
 #define PROP_CHANGED "PropertiesChanged"
 #define PROP_DEV_MODEL "Model"
@@ -34,6 +37,7 @@
 #define PROP_DEV_ENERGY_FULL "EnergyFull"
 #define PROP_DEV_ENERGY_EMPTY "EnergyEmpty"
 #define PROP_DEV_ENERGY "Energy"
+#define PROP_DEV_ENERGY_RATE "EnergyRate"
 #define PROP_DEV_ONLINE "Online"
 #define PROP_DEV_POWER_SUPPLY "PowerSupply"
 #define PROP_DEV_TIME_TO_EMPTY "TimeToEmpty"
@@ -45,6 +49,7 @@
 Device::Device(const QString block, QObject *parent)
     : QObject(parent)
     , path(block)
+    , type(DeviceUnknown)
     , isRechargable(false)
     , isPresent(false)
     , percentage(0)
@@ -57,69 +62,144 @@ Device::Device(const QString block, QObject *parent)
     , energyFullDesign(0)
     , energyFull(0)
     , energyEmpty(0)
-    , dbus(nullptr)
-    , dbusp(nullptr)
+    , energyRate(0)
+    , timeToEmpty(0)
+    , timeToFull(0)
+    , pending(false)
 {
     QDBusConnection system = QDBusConnection::systemBus();
-    dbus = new QDBusInterface(UPOWER_SERVICE,
-                              path,
-                              QString("%1.%2").arg(UPOWER_SERVICE).arg(DBUS_DEVICE),
-                              system,
-                              parent);
-    system.connect(dbus->service(),
-                   dbus->path(),
+    system.connect(UPOWER_SERVICE,
+                   path,
                    QString("%1.%2").arg(UPOWER_SERVICE).arg(DBUS_DEVICE),
                    DBUS_CHANGED,
                    this,
                    SLOT(updateDeviceProperties()));
-    dbusp = new QDBusInterface(UPOWER_SERVICE,
-                               path,
-                               DBUS_PROPERTIES,
-                               system,
-                               parent);
-    system.connect(dbusp->service(),
-                   dbusp->path(),
+    system.connect(UPOWER_SERVICE,
+                   path,
                    DBUS_PROPERTIES,
                    PROP_CHANGED,
                    this,
-                   SLOT(updateDeviceProperties()));
+                   SLOT(handlePropertiesChanged(QString,QVariantMap,QStringList)));
     if (name.isEmpty()) { name = path.split("/").takeLast(); }
     updateDeviceProperties();
 }
 
-// get device properties
+// get all device properties (async)
 void Device::updateDeviceProperties()
 {
-    if (!dbus->isValid()) { return; }
-
-    model = dbus->property(PROP_DEV_MODEL).toString();
-    capacity =  dbus->property(PROP_DEV_CAPACITY).toDouble();
-    isRechargable =  dbus->property(PROP_DEV_IS_RECHARGE).toBool();
-    isPresent =  dbus->property(PROP_DEV_PRESENT).toBool();
-    percentage =  dbus->property(PROP_DEV_PERCENT).toDouble();
-    energyFullDesign = dbus->property(PROP_DEV_ENERGY_FULL_DESIGN).toDouble();
-    energyFull = dbus->property(PROP_DEV_ENERGY_FULL).toDouble();
-    energyEmpty = dbus->property(PROP_DEV_ENERGY_EMPTY).toDouble();
-    energy = dbus->property(PROP_DEV_ENERGY).toDouble();
-    online = dbus->property(PROP_DEV_ONLINE).toBool();
-    hasPowerSupply = dbus->property(PROP_DEV_POWER_SUPPLY).toBool();
-    timeToEmpty = dbus->property(PROP_DEV_TIME_TO_EMPTY).toLongLong();
-    timeToFull = dbus->property(PROP_DEV_TIME_TO_FULL).toLongLong();
-    type = (DeviceType)dbus->property(PROP_DEV_TYPE).toUInt();
+    // a pending reply is sent after any change we were told about
+    if (pending) { return; }
+    QDBusMessage call = QDBusMessage::createMethodCall(UPOWER_SERVICE,
+                                                       path,
+                                                       DBUS_PROPERTIES,
+                                                       "GetAll");
+    call << QString("%1.%2").arg(UPOWER_SERVICE).arg(DBUS_DEVICE);
+    QDBusPendingCall reply = QDBusConnection::systemBus().asyncCall(call);
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(reply, this);
+    connect(watcher,
+            SIGNAL(finished(QDBusPendingCallWatcher*)),
+            this,
+            SLOT(handleDeviceProperties(QDBusPendingCallWatcher*)));
+    pending = true;
+}
 
-    if (type == DeviceBattery) { isBattery = true; }
-    else {
-        isBattery = false;
-        if (type == DeviceLinePower) { isAC = true; }
-        else { isAC = false; }
+void Device::handleDeviceProperties(QDBusPendingCallWatcher *watcher)
+{
+    pending = false;
+    QDBusPendingReply<QVariantMap> reply = *watcher;
+    watcher->deleteLater();
+    if (reply.isError()) {
+        qWarning() << "failed to get device properties" << path << reply.error().message();
+        return;
     }
+    // a refresh that changed nothing must not trigger another one
+    if (reply.value() == lastProperties) { return; }
+    lastProperties = reply.value();
+    applyProperties(lastProperties);
+    emit deviceChanged(path);
+}
 
-    vendor = dbus->property(PROP_DEV_VENDOR).toString();
-    nativePath = dbus->property(PROP_DEV_NATIVEPATH).toString();
-
+// apply the properties from the signal as-is
+void Device::handlePropertiesChanged(const QString &interface,
+                                     const QVariantMap &changedProperties,
+                                     const QStringList &invalidatedProperties)
+{
+    if (interface != QString("%1.%2").arg(UPOWER_SERVICE).arg(DBUS_DEVICE)) { return; }
+    if (!invalidatedProperties.isEmpty()) {
+        updateDeviceProperties();
+        return;
+    }
+    if (changedProperties.isEmpty()) { return; }
+    QMapIterator<QString, QVariant> property(changedProperties);
+    while (property.hasNext()) {
+        property.next();
+        lastProperties[property.key()] = property.value();
+    }
+    applyProperties(changedProperties);
     emit deviceChanged(path);
 }
 
+void Device::applyProperties(const QVariantMap &properties)
+{
+    if (properties.contains(PROP_DEV_MODEL)) {
+        model = properties.value(PROP_DEV_MODEL).toString();
+    }
+    if (properties.contains(PROP_DEV_CAPACITY)) {
+        capacity = properties.value(PROP_DEV_CAPACITY).toDouble();
+    }
+    if (properties.contains(PROP_DEV_IS_RECHARGE)) {
+        isRechargable = properties.value(PROP_DEV_IS_RECHARGE).toBool();
+    }
+    if (properties.contains(PROP_DEV_PRESENT)) {
+        isPresent = properties.value(PROP_DEV_PRESENT).toBool();
+    }
+    if (properties.contains(PROP_DEV_PERCENT)) {
+        percentage = properties.value(PROP_DEV_PERCENT).toDouble();
+    }
+    if (properties.contains(PROP_DEV_ENERGY_FULL_DESIGN)) {
+        energyFullDesign = properties.value(PROP_DEV_ENERGY_FULL_DESIGN).toDouble();
+    }
+    if (properties.contains(PROP_DEV_ENERGY_FULL)) {
+        energyFull = properties.value(PROP_DEV_ENERGY_FULL).toDouble();
+    }
+    if (properties.contains(PROP_DEV_ENERGY_EMPTY)) {
+        energyEmpty = properties.value(PROP_DEV_ENERGY_EMPTY).toDouble();
+    }
+    if (properties.contains(PROP_DEV_ENERGY)) {
+        energy = properties.value(PROP_DEV_ENERGY).toDouble();
+    }
+    if (properties.contains(PROP_DEV_ENERGY_RATE)) {
+        energyRate = properties.value(PROP_DEV_ENERGY_RATE).toDouble();
+    }
+    if (properties.contains(PROP_DEV_ONLINE)) {
+        online = properties.value(PROP_DEV_ONLINE).toBool();
+    }
+    if (properties.contains(PROP_DEV_POWER_SUPPLY)) {
+        hasPowerSupply = properties.value(PROP_DEV_POWER_SUPPLY).toBool();
+    }
+    if (properties.contains(PROP_DEV_TIME_TO_EMPTY)) {
+        timeToEmpty = properties.value(PROP_DEV_TIME_TO_EMPTY).toLongLong();
+    }
+    if (properties.contains(PROP_DEV_TIME_TO_FULL)) {
+        timeToFull = properties.value(PROP_DEV_TIME_TO_FULL).toLongLong();
+    }
+    if (properties.contains(PROP_DEV_TYPE)) {
+        type = (DeviceType)properties.value(PROP_DEV_TYPE).toUInt();
+        if (type == DeviceBattery) { isBattery = true; }
+        else {
+            isBattery = false;
+            if (type == DeviceLinePower) { isAC = true; }
+            else { isAC = false; }
+        }
+    }
+    if (properties.contains(PROP_DEV_VENDOR)) {
+        vendor = properties.value(PROP_DEV_VENDOR).toString();
+    }
+    if (properties.contains(PROP_DEV_NATIVEPATH)) {
+        nativePath = properties.value(PROP_DEV_NATIVEPATH).toString();
+    }
+}
+
 void Device::update()
 {
     updateDeviceProperties();
@@ -127,7 +207,5 @@ void Device::update()
 
 void Device::updateBattery()
 {
-    percentage =  dbus->property(PROP_DEV_PERCENT).toDouble();
-    timeToEmpty = dbus->property(PROP_DEV_TIME_TO_EMPTY).toLongLong();
-    timeToFull = dbus->property(PROP_DEV_TIME_TO_FULL).toLongLong();
+    updateDeviceProperties();
 }
@@ -23,7 +23,10 @@
 #define DEVICE_H
 
 #include <QObject>
-#include <QDBusInterface>
+#include <QVariantMap>
+#include <QStringList>
+
+class QDBusPendingCallWatcher;
 
 #define UPOWER_SERVICE "org.freedesktop.UPower"
 #define DBUS_PROPERTIES "org.freedesktop.DBus.Properties"
@@ -66,18 +69,24 @@ public:
     double energyFullDesign;
     double energyFull;
     double energyEmpty;
+    double energyRate;
     qlonglong timeToEmpty;
     qlonglong timeToFull;
 
 private:
-    QDBusInterface *dbus;
-    QDBusInterface *dbusp;
+    bool pending;
+    QVariantMap lastProperties;
+    void applyProperties(const QVariantMap &properties);
 
 signals:
     void deviceChanged(const QString &devicePath);
 
 private slots:
     void updateDeviceProperties();
+    void handleDeviceProperties(QDBusPendingCallWatcher *watcher);
+    void handlePropertiesChanged(const QString &interface,
+                                 const QVariantMap &changedProperties,
+                                 const QStringList &invalidatedProperties);
 public slots:
     void update();
     void updateBattery();
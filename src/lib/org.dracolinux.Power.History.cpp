@@ -0,0 +1,240 @@
+/*
+#
+# Draco Desktop Environment <https://dracolinux.org>
+# Copyright (c) 2019, Ole-André Rodlie <ole.andre.rodlie@gmail.com>
+# All rights reserved.
+#
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser Public License as published by
+* the Free Software Foundation; either version 2.1 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>
+#
+*/
+
+#include "org.dracolinux.Power.History.h"
+#include "draco.h"
+
+#include <string.h>
+#include <atomic>
+#include <qmath.h>
+
+PowerHistory::PowerHistory(bool writable, const QString &path)
+    : data(nullptr)
+    , writable(writable)
+{
+    file.setFileName(path.isEmpty()?getFile():path);
+    open();
+}
+
+PowerHistory::~PowerHistory()
+{
+    if (data) { file.unmap(data); }
+    file.close();
+}
+
+const QString PowerHistory::getFile()
+{
+    return QString("%1/%2").arg(Draco::cacheDir()).arg(HISTORY_FILE);
+}
+
+bool PowerHistory::open()
+{
+    qint64 size = sizeof(history_header)+sizeof(history_sample)*HISTORY_CAPACITY;
+    if (!writable) {
+        if (!file.open(QIODevice::ReadOnly) || file.size()!=size) { return false; }
+        data = file.map(0, size);
+        if (data && header()->magic == HISTORY_MAGIC &&
+            header()->version == HISTORY_VERSION &&
+            header()->capacity == HISTORY_CAPACITY) { return true; }
+        if (data) { file.unmap(data); }
+        data = nullptr;
+        return false;
+    }
+
+    if (!file.open(QIODevice::ReadWrite)) { return false; }
+    bool reset = file.size()!=size;
+    if (reset && !file.resize(size)) { return false; }
+    data = file.map(0, size);
+    if (!data) { return false; }
+    if (reset ||
+        header()->magic != HISTORY_MAGIC ||
+        header()->version != HISTORY_VERSION ||
+        header()->capacity != HISTORY_CAPACITY ||
+        header()->head >= HISTORY_CAPACITY ||
+        header()->count > HISTORY_CAPACITY ||
+        header()->sequence.load() & 1) {
+        memset(data, 0, size);
+        header()->magic = HISTORY_MAGIC;
+        header()->version = HISTORY_VERSION;
+        header()->capacity = HISTORY_CAPACITY;
+    }
+    return true;
+}
+
+bool PowerHistory::isValid()
+{
+    return data != nullptr;
+}
+
+history_header *PowerHistory::header()
+{
+    return reinterpret_cast<history_header*>(data);
+}
+
+history_sample *PowerHistory::sample(quint32 index)
+{
+    return reinterpret_cast<history_sample*>(data+sizeof(history_header))+index;
+}
+
+bool PowerHistory::append(const history_sample &value)
+{
+    if (!data || !writable) { return false; }
+    quint32 sequence = header()->sequence.load();
+    header()->sequence.store(sequence+1);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    quint32 head = header()->head;
+    *sample(head) = value;
+    header()->head = (head+1)%HISTORY_CAPACITY;
+    if (header()->count<HISTORY_CAPACITY) { header()->count++; }
+
+    header()->sequence.storeRelease(sequence+2);
+    return true;
+}
+
+// copy out a consistent view, retry if the writer was active meanwhile
+bool PowerHistory::read(QVector<history_sample> *result,
+                        qint64 since,
+                        int maxPoints,
+                        bool lastOnly)
+{
+    if (!data) { return false; }
+    for (int retry=0;retry<HISTORY_READ_RETRIES;++retry) {
+        result->clear();
+        quint32 sequence = header()->sequence.loadAcquire();
+        if (sequence & 1) { continue; }
+
+        quint32 head = header()->head%HISTORY_CAPACITY;
+        int total = qMin(header()->count, (quint32)HISTORY_CAPACITY);
+        quint32 first = (head+HISTORY_CAPACITY-total)%HISTORY_CAPACITY;
+        if (lastOnly) {
+            if (total>0) { *result << *sample((head+HISTORY_CAPACITY-1)%HISTORY_CAPACITY); }
+        } else if (total>0) {
+            // samples are in time order, skip the old ones
+            int start = 0;
+            int end = total;
+            while (start<end) {
+                int mid = (start+end)/2;
+                if (sample((first+mid)%HISTORY_CAPACITY)->time<since) { start = mid+1; }
+                else { end = mid; }
+            }
+            // every n'th sample if more than maxPoints
+            int step = 1;
+            if (maxPoints>0 && total-start>maxPoints) { step = (total-start+maxPoints-1)/maxPoints; }
+            result->reserve((total-start)/step+1);
+            for (int i=start;i<total;i+=step) {
+                *result << *sample((first+i)%HISTORY_CAPACITY);
+            }
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (header()->sequence.load() == sequence) { return true; }
+    }
+    result->clear();
+    return false;
+}
+
+int PowerHistory::count()
+{
+    if (!data) { return 0; }
+    for (int retry=0;retry<HISTORY_READ_RETRIES;++retry) {
+        quint32 sequence = header()->sequence.loadAcquire();
+        if (sequence & 1) { continue; }
+        int result = qMin(header()->count, (quint32)HISTORY_CAPACITY);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (header()->sequence.load() == sequence) { return result; }
+    }
+    return 0;
+}
+
+history_sample PowerHistory::last()
+{
+    QVector<history_sample> result;
+    if (read(&result, 0, 0, true) && result.size()==1) { return result.first(); }
+    history_sample empty;
+    memset(&empty, 0, sizeof(empty));
+    return empty;
+}
+
+QVector<history_sample> PowerHistory::samples(qint64 since, int maxPoints)
+{
+    // oldest first
+    QVector<history_sample> result;
+    read(&result, since, maxPoints, false);
+    return result;
+}
+
+PowerDischarge::PowerDischarge()
+    : _rate(0)
+    , lastEnergy(0)
+    , lastTime(0)
+{
+}
+
+void PowerDischarge::add(qint64 time, double energy, double rate, bool ac)
+{
+    if (ac) {
+        _rate = 0;
+        lastTime = 0;
+        return;
+    }
+    if (_rate<=0 && rate>0) { _rate = rate; }
+    if (lastTime==0 || energy>lastEnergy) {
+        lastEnergy = energy;
+        lastTime = time;
+        return;
+    }
+    qint64 dt = time-lastTime;
+    if (energy==lastEnergy || dt<=0) { return; } // no new reading yet
+    double measured = (lastEnergy-energy)*3600/dt;
+    double alpha = 1-qExp(-(double)dt/DISCHARGE_TAU);
+    if (_rate>0) { _rate += alpha*(measured-_rate); }
+    else { _rate = measured; }
+    lastEnergy = energy;
+    lastTime = time;
+}
+
+// keep the rate, but don't measure across a gap (suspend, restart)
+void PowerDischarge::restart()
+{
+    lastTime = 0;
+}
+
+double PowerDischarge::rate()
+{
+    return _rate;
+}
+
+// secs until energy reaches empty (Wh) at the smoothed rate, -1 if unknown
+qlonglong PowerDischarge::timeToEmpty(double energy, double empty)
+{
+    if (_rate<=0) { return -1; }
+    if (energy<=empty) { return 0; }
+    return qRound64((energy-empty)*3600/_rate);
+}
+
+// percentage left after n seconds at the smoothed rate (never below 1%)
+double PowerDischarge::batteryLeft(double left, double full, int seconds)
+{
+    if (left<=0 || full<=0 || _rate<=0) { return left; }
+    double drop = _rate*seconds/3600/full*100;
+    return qMax(left-drop, qMin(left, 1.0));
+}
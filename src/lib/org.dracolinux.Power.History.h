@@ -0,0 +1,103 @@
+/*
+#
+# Draco Desktop Environment <https://dracolinux.org>
+# Copyright (c) 2019, Ole-André Rodlie <ole.andre.rodlie@gmail.com>
+# All rights reserved.
+#
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser Public License as published by
+* the Free Software Foundation; either version 2.1 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>
+#
+*/
+
+#ifndef POWER_HISTORY_H
+#define POWER_HISTORY_H
+
+#include <QFile>
+#include <QString>
+#include <QVector>
+#include <QAtomicInteger>
+#include <QtGlobal>
+
+#define HISTORY_FILE "battery.history"
+#define HISTORY_MAGIC 0x44504248 // DPBH
+#define HISTORY_VERSION 2
+#define HISTORY_CAPACITY 2880 // 48 hours at one sample per minute
+#define HISTORY_READ_RETRIES 16
+#define DISCHARGE_TAU 600 // secs, smoothing of the discharge rate
+
+struct history_header
+{
+    quint32 magic;
+    quint32 version;
+    quint32 capacity;
+    quint32 head; // next slot to write
+    quint32 count;
+    QBasicAtomicInteger<quint32> sequence; // odd while a write is in progress
+};
+
+struct history_sample
+{
+    qint64 time; // secs since epoch
+    float energy; // Wh
+    float rate; // W, as reported
+    float percentage;
+    quint32 ac;
+};
+
+// fixed size ring buffer of battery samples in a mmap'd file, the
+// power service writes it and anyone else can map it read-only to
+// draw graphs without asking the service. Writes are guarded by a
+// sequence counter, readers retry if a write happened while copying.
+class PowerHistory
+{
+public:
+    explicit PowerHistory(bool writable = false,
+                          const QString &path = QString());
+    ~PowerHistory();
+    bool isValid();
+    bool append(const history_sample &sample);
+    int count();
+    history_sample last();
+    QVector<history_sample> samples(qint64 since = 0, int maxPoints = 0);
+    static const QString getFile();
+
+private:
+    QFile file;
+    uchar *data;
+    bool writable;
+
+    history_header *header();
+    history_sample *sample(quint32 index);
+    bool open();
+    bool read(QVector<history_sample> *result, qint64 since, int maxPoints, bool lastOnly);
+};
+
+// discharge rate smoothed from energy deltas (exponential, DISCHARGE_TAU),
+// the reported rate is only used until the first real delta arrives
+class PowerDischarge
+{
+public:
+    PowerDischarge();
+    void add(qint64 time, double energy, double rate, bool ac);
+    void restart();
+    double rate();
+    qlonglong timeToEmpty(double energy, double empty);
+    double batteryLeft(double left, double full, int seconds);
+
+private:
+    double _rate;
+    double lastEnergy;
+    qint64 lastTime;
+};
+
+#endif // POWER_HISTORY_H
@@ -25,15 +25,15 @@ HotPlug::HotPlug(QObject *parent) :
     QObject(parent)
   , _scanning(false)
 {
-    moveToThread(&t);
-    t.start();
+    connect(Screens::instance(),
+            SIGNAL(outputChanged(QString,bool)),
+            this,
+            SLOT(handleOutputChanged(QString,bool)));
 }
 
 HotPlug::~HotPlug()
 {
     _scanning = false;
-    t.wait();
-    t.quit();
 }
 
 void HotPlug::requestScan()
@@ -45,36 +45,7 @@ void HotPlug::scan()
 {
     if (_scanning) { return; }
     _scanning = true;
-
-    Display *dpy;
-    if ((dpy = XOpenDisplay(nullptr)) == nullptr) { return; }
-
-    XRRScreenResources *sr;
-    XRROutputInfo *info;
-    XEvent ev;
-
-    getScreens(dpy);
-
-    XRRSelectInput(dpy, DefaultRootWindow(dpy), RROutputChangeNotifyMask);
-    XSync(dpy, 0);
-    while(_scanning) {
-        if (!XNextEvent(dpy, &ev)) {
-            sr = XRRGetScreenResources(OCNE(&ev)->display, OCNE(&ev)->window);
-            if (sr == nullptr) { continue; }
-            info = XRRGetOutputInfo(OCNE(&ev)->display, sr, OCNE(&ev)->output);
-            if (info == nullptr) {
-                XRRFreeScreenResources(sr);
-                continue;
-            }
-            QString screenName = info->name;
-            bool screenConnected = false;
-            if (info->connection == RR_Connected) { screenConnected = true; }
-            emit status(screenName, screenConnected);
-            XRRFreeScreenResources(sr);
-            XRRFreeOutputInfo(info);
-        }
-    }
-    XCloseDisplay(dpy);
+    getScreens();
 }
 
 void HotPlug::requestSetScan(bool scanning)
@@ -82,14 +53,18 @@ void HotPlug::requestSetScan(bool scanning)
     QMetaObject::invokeMethod(this, "setScan", Q_ARG(bool, scanning));
 }
 
-void HotPlug::getScreens(Display *dpy)
+void HotPlug::getScreens()
 {
-    if (dpy == nullptr) { return; }
-    QMap<QString,bool> result = Screens::outputsDpy(dpy);
-    emit found(result);
+    emit found(Screens::outputs());
 }
 
 void HotPlug::setScan(bool scanning)
 {
     _scanning = scanning;
 }
+
+void HotPlug::handleOutputChanged(const QString &name, bool connected)
+{
+    if (!_scanning) { return; }
+    emit status(name, connected);
+}
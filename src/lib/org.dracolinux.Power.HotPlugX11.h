@@ -23,19 +23,11 @@
 #define HOTPLUG_H
 
 #include <QObject>
-#include <QThread>
 #include <QMap>
 
 #include "org.dracolinux.Power.ScreenX11.h"
-#include <X11/extensions/Xrandr.h>
-
-// fix X11 inc
-#undef Bool
-#undef None
-#undef Status
-
-#define OCNE(X) ((XRROutputChangeNotifyEvent*)X)
 
+// Forwards output changes from the shared display connection (Screens)
 class HotPlug : public QObject
 {
     Q_OBJECT
@@ -45,7 +37,6 @@ public:
     ~HotPlug();
 
 private:
-    QThread t;
     bool _scanning;
 
 signals:
@@ -57,8 +48,9 @@ public slots:
     void requestSetScan(bool scanning);
 private slots:
     void scan();
-    void getScreens(Display *dpy);
+    void getScreens();
     void setScan(bool scanning);
+    void handleOutputChanged(const QString &name, bool connected);
 };
 
 #endif // HOTPLUG_H
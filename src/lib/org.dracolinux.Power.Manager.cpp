@@ -26,7 +26,6 @@
 #include <QDBusInterface>
 #include <QDBusMessage>
 #include <QDBusPendingReply>
-#include <QXmlStreamReader>
 #include <QProcess>
 #include <QMapIterator>
 #include <QDebug>
@@ -44,7 +43,12 @@ Power::Power(QObject *parent) : QObject(parent)
   , suspendWakeupBattery(0)
   , suspendWakeupAC(0)
   , lockScreenOnSuspend(true)
+  , history(nullptr)
+  , lastHistoryTime(0)
+  , lastHistoryAC(false)
 {
+    history = new PowerHistory(true);
+    loadHistory();
     setup();
     timer.setInterval(TIMEOUT_CHECK);
     connect(&timer, SIGNAL(timeout()),
@@ -56,6 +60,7 @@ Power::~Power()
 {
     clearDevices();
     releaseSuspendLock();
+    delete history;
 }
 
 QMap<QString, Device *> Power::getDevices()
@@ -190,26 +195,15 @@ QStringList Power::find()
 {
     QStringList result;
     QDBusMessage call = QDBusMessage::createMethodCall(UPOWER_SERVICE,
-                                                       QString("%1/devices").arg(UPOWER_PATH),
-                                                       DBUS_INTROSPECTABLE,
-                                                       "Introspect");
-    QDBusPendingReply<QString> reply = QDBusConnection::systemBus().call(call);
+                                                       UPOWER_PATH,
+                                                       UPOWER_MANAGER,
+                                                       UPOWER_ENUMERATE_DEVICES);
+    QDBusPendingReply<QList<QDBusObjectPath> > reply = QDBusConnection::systemBus().call(call);
     if (reply.isError()) {
         qWarning() << "power manager find devices failed, check the upower service!!!";
         return result;
     }
-    QList<QDBusObjectPath> objects;
-    QXmlStreamReader xml(reply.value());
-    if (xml.hasError()) { return result; }
-    while (!xml.atEnd()) {
-        xml.readNext();
-        if (xml.tokenType() == QXmlStreamReader::StartElement &&
-            xml.name().toString() == "node" ) {
-            QString name = xml.attributes().value("name").toString();
-            if (!name.isEmpty()) { objects << QDBusObjectPath(UPOWER_DEVICES + name); }
-        }
-    }
-    foreach (QDBusObjectPath device, objects) {
+    foreach (QDBusObjectPath device, reply.value()) {
         result << device.path();
     }
     return result;
@@ -308,6 +302,7 @@ void Power::setup()
                                      this);
         }
         if (!suspendLock) { registerSuspendLock(); }
+        refreshCapabilities();
         scan();
     }
 }
@@ -320,25 +315,40 @@ void Power::check()
     }
     if (!suspendLock) { registerSuspendLock(); }
     if (!upower->isValid()) { scan(); }
+    // upower signals changes, this only catches missed ones
+    else if (OnBattery()) { UpdateBattery(); }
 }
 
+// full scan, only needed on startup or if upower was restarted
 void Power::scan()
 {
     QStringList foundDevices = find();
     for (int i=0; i < foundDevices.size(); i++) {
-        QString foundDevicePath = foundDevices.at(i);
-        if (devices.contains(foundDevicePath)) { continue; }
-        Device *newDevice = new Device(foundDevicePath, this);
-        connect(newDevice,
-                SIGNAL(deviceChanged(QString)),
-                this,
-                SLOT(handleDeviceChanged(QString)));
-        devices[foundDevicePath] = newDevice;
+        addDevice(foundDevices.at(i));
+    }
+    QMapIterator<QString, Device*> device(devices);
+    while (device.hasNext()) {
+        device.next();
+        if (foundDevices.contains(device.key())) { continue; }
+        delete devices.take(device.key());
+        emit DeviceWasRemoved(device.key());
     }
     UpdateDevices();
     emit UpdatedDevices();
 }
 
+bool Power::addDevice(const QString &path)
+{
+    if (devices.contains(path)) { return false; }
+    Device *newDevice = new Device(path, this);
+    connect(newDevice,
+            SIGNAL(deviceChanged(QString)),
+            this,
+            SLOT(handleDeviceChanged(QString)));
+    devices[path] = newDevice;
+    return true;
+}
+
 void Power::deviceAdded(const QDBusObjectPath &obj)
 {
     deviceAdded(obj.path());
@@ -348,8 +358,9 @@ void Power::deviceAdded(const QString &path)
 {
     if (!upower->isValid()) { return; }
     if (path.startsWith(QString(DBUS_JOBS).arg(UPOWER_PATH))) { return; }
+    if (!addDevice(path)) { return; }
     emit DeviceWasAdded(path);
-    scan();
+    emit UpdatedDevices();
 }
 
 void Power::deviceRemoved(const QDBusObjectPath &obj)
@@ -360,14 +371,11 @@ void Power::deviceRemoved(const QDBusObjectPath &obj)
 void Power::deviceRemoved(const QString &path)
 {
     if (!upower->isValid()) { return; }
-    bool deviceExists = devices.contains(path);
     if (path.startsWith(QString(DBUS_JOBS).arg(UPOWER_PATH))) { return; }
-    if (deviceExists) {
-        if (find().contains(path)) { return; }
-        delete devices.take(path);
-        emit DeviceWasRemoved(path);
-    }
-    scan();
+    if (!devices.contains(path)) { return; }
+    delete devices.take(path);
+    emit DeviceWasRemoved(path);
+    emit UpdatedDevices();
 }
 
 void Power::deviceChanged()
@@ -390,7 +398,9 @@ void Power::deviceChanged()
     }
     wasOnBattery = OnBattery();
 
+    updateHistory();
     emit UpdatedDevices();
+    updateState();
 }
 
 void Power::handleDeviceChanged(const QString &device)
@@ -423,6 +433,7 @@ void Power::handlePrepareForSuspend(bool prepare)
         releaseSuspendLock(); // we are ready for suspend
     }
     else { // resume
+        discharge.restart(); // don't count the time we slept
         UpdateDevices();
         if (hasWakeAlarm() &&
              wakeAlarmDate.isValid() &&
@@ -729,7 +740,11 @@ bool Power::OnBattery()
 
 double Power::BatteryLeft()
 {
-    if (OnBattery()) { UpdateBattery(); }
+    return calcBatteryLeft();
+}
+
+double Power::calcBatteryLeft()
+{
     double batteryLeft = 0;
     QMapIterator<QString, Device*> device(devices);
     int batteries = 0;
@@ -743,6 +758,7 @@ double Power::BatteryLeft()
             batteries++;
         } else { continue; }
     }
+    if (batteries == 0) { return 0; }
     return batteryLeft/batteries;
 }
 
@@ -767,7 +783,11 @@ bool Power::HasBattery()
 
 qlonglong Power::TimeToEmpty()
 {
-    if (OnBattery()) { UpdateBattery(); }
+    return calcTimeToEmpty();
+}
+
+qlonglong Power::calcTimeToEmpty()
+{
     qlonglong result = 0;
     QMapIterator<QString, Device*> device(devices);
     while (device.hasNext()) {
@@ -782,7 +802,11 @@ qlonglong Power::TimeToEmpty()
 
 qlonglong Power::TimeToFull()
 {
-    if (OnBattery()) { UpdateBattery(); }
+    return calcTimeToFull();
+}
+
+qlonglong Power::calcTimeToFull()
+{
     qlonglong result = 0;
     QMapIterator<QString, Device*> device(devices);
     while (device.hasNext()) {
@@ -795,6 +819,92 @@ qlonglong Power::TimeToFull()
     return result;
 }
 
+double Power::DischargeRate()
+{
+    if (!OnBattery()) { return 0; }
+    return discharge.rate();
+}
+
+// time to empty from the smoothed rate, upower's estimate until we have one
+qlonglong Power::PredictedTimeToEmpty()
+{
+    if (!OnBattery()) { return 0; }
+    if (discharge.rate()<=0) { return calcTimeToEmpty(); }
+    double energy, empty, full, rate;
+    batteryEnergy(&energy, &empty, &full, &rate);
+    return discharge.timeToEmpty(energy, empty);
+}
+
+// where the battery will be in n seconds at the current rate (never below 1%)
+double Power::PredictedBatteryLeft(int seconds)
+{
+    double left = calcBatteryLeft();
+    if (left<=0 || !OnBattery() || discharge.rate()<=0) { return left; }
+    double energy, empty, full, rate;
+    batteryEnergy(&energy, &empty, &full, &rate);
+    return discharge.batteryLeft(left, full, seconds);
+}
+
+void Power::batteryEnergy(double *energy, double *empty, double *full, double *rate)
+{
+    *energy = 0;
+    *empty = 0;
+    *full = 0;
+    *rate = 0;
+    QMapIterator<QString, Device*> device(devices);
+    while (device.hasNext()) {
+        device.next();
+        if (device.value()->isBattery &&
+            device.value()->isPresent &&
+            !device.value()->nativePath.isEmpty())
+        {
+            *energy += device.value()->energy;
+            *empty += device.value()->energyEmpty;
+            *full += device.value()->energyFull;
+            *rate += device.value()->energyRate;
+        }
+    }
+}
+
+// warm up the estimator from the recent history
+void Power::loadHistory()
+{
+    if (!history->isValid()) { return; }
+    qint64 now = QDateTime::currentMSecsSinceEpoch()/1000;
+    QVector<history_sample> samples = history->samples(now-DISCHARGE_TAU*3);
+    for (int i=0;i<samples.size();++i) {
+        const history_sample &sample = samples.at(i);
+        discharge.add(sample.time, sample.energy, sample.rate, sample.ac);
+    }
+    discharge.restart(); // the service was down since the last sample
+    history_sample last = history->last();
+    lastHistoryTime = last.time;
+    lastHistoryAC = last.ac;
+}
+
+void Power::updateHistory()
+{
+    if (!HasBattery()) { return; }
+    double energy, empty, full, rate;
+    batteryEnergy(&energy, &empty, &full, &rate);
+    if (energy<=0) { return; }
+    bool ac = !OnBattery();
+    qint64 now = QDateTime::currentMSecsSinceEpoch()/1000;
+    discharge.add(now, energy, rate, ac);
+
+    if (!history->isValid()) { return; }
+    if (now-lastHistoryTime<HISTORY_INTERVAL && ac == lastHistoryAC) { return; }
+    history_sample sample;
+    sample.time = now;
+    sample.energy = energy;
+    sample.rate = rate;
+    sample.percentage = calcBatteryLeft();
+    sample.ac = ac;
+    history->append(sample);
+    lastHistoryTime = now;
+    lastHistoryAC = ac;
+}
+
 void Power::UpdateDevices()
 {
     QMapIterator<QString, Device*> device(devices);
@@ -818,6 +928,42 @@ void Power::UpdateBattery()
 void Power::UpdateConfig()
 {
     emit Update();
+    refreshCapabilities();
+    updateState();
+}
+
+// full power state in one call, clients mirror this and listen to StateChanged
+QVariantMap Power::State()
+{
+    QVariantMap state = capabilities;
+    state["OnBattery"] = OnBattery();
+    state["BatteryLeft"] = calcBatteryLeft();
+    state["HasBattery"] = HasBattery();
+    state["TimeToEmpty"] = PredictedTimeToEmpty();
+    state["DischargeRate"] = DischargeRate();
+    state["TimeToFull"] = calcTimeToFull();
+    state["LidIsPresent"] = LidIsPresent();
+    state["LidIsClosed"] = LidIsClosed();
+    state["IsDocked"] = IsDocked();
+    return state;
+}
+
+// these are blocking calls to logind/ck/upower and rarely change
+void Power::refreshCapabilities()
+{
+    capabilities["CanSuspend"] = CanSuspend();
+    capabilities["CanHibernate"] = CanHibernate();
+    capabilities["CanHybridSleep"] = CanHybridSleep();
+    capabilities["CanRestart"] = CanRestart();
+    capabilities["CanPowerOff"] = CanPowerOff();
+}
+
+void Power::updateState()
+{
+    QVariantMap state = State();
+    if (state == lastState) { return; }
+    lastState = state;
+    emit StateChanged(state);
 }
 
 QStringList Power::ScreenSaverInhibitors()
@@ -882,3 +1028,24 @@ bool Power::setDisplayBacklight(const QString &device, int value)
     qDebug() << "BACKLIGHT OK?" << backlight << reply.errorMessage();
     return backlight;
 }
+
+void Power::fadeDisplayBacklight(const QString &device, int value)
+{
+    // powerd runs the transition, don't wait for it
+    if (!pmd) { return; }
+    if (!pmd->isValid()) { return; }
+    pmd->asyncCall("FadeDisplayBacklight",
+                   device,
+                   value,
+                   BACKLIGHT_FADE_DURATION);
+}
+
+void Power::adjustDisplayBacklight(const QString &device, int delta)
+{
+    if (!pmd) { return; }
+    if (!pmd->isValid()) { return; }
+    pmd->asyncCall("AdjustDisplayBacklight",
+                   device,
+                   delta,
+                   BACKLIGHT_FADE_DURATION);
+}
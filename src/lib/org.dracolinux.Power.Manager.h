@@ -25,6 +25,7 @@
 #include <QObject>
 #include <QStringList>
 #include <QMap>
+#include <QVariantMap>
 #include <QDBusInterface>
 #include <QDBusObjectPath>
 #include <QTimer>
@@ -32,6 +33,7 @@
 #include <QDBusUnixFileDescriptor>
 
 #include "org.dracolinux.Power.Device.h"
+#include "org.dracolinux.Power.History.h"
 
 #define CONSOLEKIT_SERVICE "org.freedesktop.ConsoleKit"
 #define CONSOLEKIT_PATH "/org/freedesktop/ConsoleKit/Manager"
@@ -51,6 +53,7 @@
 #define UPOWER_ON_BATTERY "OnBattery"
 #define UPOWER_NOTIFY_RESUME "NotifyResume"
 #define UPOWER_NOTIFY_SLEEP "NotifySleep"
+#define UPOWER_ENUMERATE_DEVICES "EnumerateDevices"
 
 #define PK_PREPARE_FOR_SUSPEND "PrepareForSuspend"
 #define PK_PREPARE_FOR_SLEEP "PrepareForSleep"
@@ -83,6 +86,7 @@
 #define XSCREENSAVER_LOCK "xscreensaver-command -lock"
 
 #define TIMEOUT_CHECK 60000
+#define HISTORY_INTERVAL 60 // secs between stored samples
 
 class Power : public QObject
 {
@@ -146,6 +150,14 @@ private:
 
     bool lockScreenOnSuspend;
 
+    QVariantMap capabilities;
+    QVariantMap lastState;
+
+    PowerHistory *history;
+    qint64 lastHistoryTime;
+    bool lastHistoryAC;
+    PowerDischarge discharge;
+
 signals:
     void Update();
     void UpdatedDevices();
@@ -158,6 +170,7 @@ signals:
     void DeviceWasRemoved(const QString &path);
     void DeviceWasAdded(const QString &path);
     void UpdatedInhibitors();
+    void StateChanged(const QVariantMap &state);
 
 private slots:
     bool availableService(const QString &service,
@@ -172,6 +185,7 @@ private slots:
     void setup();
     void check();
     void scan();
+    bool addDevice(const QString &path);
 
     void deviceAdded(const QDBusObjectPath &obj);
     void deviceAdded(const QString &path);
@@ -195,6 +209,16 @@ private slots:
     bool registerSuspendLock();
     void setWakeAlarmFromSettings();
 
+    double calcBatteryLeft();
+    qlonglong calcTimeToEmpty();
+    qlonglong calcTimeToFull();
+    void refreshCapabilities();
+    void updateState();
+
+    void batteryEnergy(double *energy, double *empty, double *full, double *rate);
+    void loadHistory();
+    void updateHistory();
+
 public slots:
     bool HasConsoleKit();
     bool HasLogind();
@@ -225,17 +249,23 @@ public slots:
     bool HasBattery();
     qlonglong TimeToEmpty();
     qlonglong TimeToFull();
+    double DischargeRate();
+    qlonglong PredictedTimeToEmpty();
+    double PredictedBatteryLeft(int seconds);
     void UpdateDevices();
     void UpdateBattery();
     void UpdateConfig();
     QStringList ScreenSaverInhibitors();
     QStringList PowerManagementInhibitors();
+    QVariantMap State();
     const QDateTime getWakeAlarm();
     void releaseSuspendLock();
     void setSuspendWakeAlarmOnBattery(int value);
     void setSuspendWakeAlarmOnAC(int value);
     void setLockScreenOnSuspend(bool lock);
     bool setDisplayBacklight(QString const &device, int value);
+    void fadeDisplayBacklight(QString const &device, int value);
+    void adjustDisplayBacklight(QString const &device, int delta);
 };
 
 #endif // POWER_MANAGER_H
@@ -21,6 +21,77 @@
 
 #include "org.dracolinux.Power.ScreenX11.h"
 
+#include <QCoreApplication>
+#include <QSocketNotifier>
+
+#include <X11/extensions/Xrandr.h>
+#include <X11/extensions/scrnsaver.h>
+#include <X11/extensions/sync.h>
+#include <string.h>
+
+Screens::Screens(QObject *parent) :
+    QObject(parent)
+  , dpy(nullptr)
+  , notifier(nullptr)
+  , rrEventBase(-1)
+  , syncEventBase(-1)
+  , idleCounter(0)
+  , resetAlarm(0)
+  , idleOffset(0)
+{
+    if ((dpy = XOpenDisplay(nullptr)) == nullptr) { return; }
+    int rrErrorBase;
+    if (XRRQueryExtension(dpy, &rrEventBase, &rrErrorBase)) {
+        XRRSelectInput(dpy,
+                       DefaultRootWindow(dpy),
+                       RROutputChangeNotifyMask);
+    } else { rrEventBase = -1; }
+    refresh();
+
+    int syncErrorBase, syncMajor, syncMinor;
+    if (XSyncQueryExtension(dpy, &syncEventBase, &syncErrorBase) &&
+        XSyncInitialize(dpy, &syncMajor, &syncMinor)) {
+        int ncounters = 0;
+        XSyncSystemCounter *counters = XSyncListSystemCounters(dpy, &ncounters);
+        for (int i = 0; i < ncounters; ++i) {
+            if (strcmp(counters[i].name, "IDLETIME") == 0) {
+                idleCounter = counters[i].counter;
+                break;
+            }
+        }
+        if (counters) { XSyncFreeSystemCounterList(counters); }
+    } else { syncEventBase = -1; }
+
+    notifier = new QSocketNotifier(ConnectionNumber(dpy),
+                                   QSocketNotifier::Read,
+                                   this);
+    connect(notifier,
+            SIGNAL(activated(int)),
+            this,
+            SLOT(processEvents()));
+    XFlush(dpy);
+}
+
+Screens::~Screens()
+{
+    if (dpy) {
+        clearIdleAlarms();
+        XCloseDisplay(dpy);
+    }
+}
+
+Screens *Screens::instance()
+{
+    static Screens *service = nullptr;
+    if (service == nullptr) { service = new Screens(qApp); }
+    return service;
+}
+
+Display *Screens::display()
+{
+    return dpy;
+}
+
 QMap<QString, bool> Screens::outputsDpy(Display *dpy)
 {
     QMap<QString,bool> result;
@@ -48,12 +119,7 @@ QMap<QString, bool> Screens::outputsDpy(Display *dpy)
 
 QMap<QString, bool> Screens::outputs()
 {
-    QMap<QString, bool> result;
-    Display *dpy;
-    if ((dpy = XOpenDisplay(nullptr)) == nullptr) { return result; }
-    result = outputsDpy(dpy);
-    XCloseDisplay(dpy);
-    return result;
+    return instance()->_outputs;
 }
 
 QString Screens::internalDpy(Display *dpy)
@@ -73,10 +139,161 @@ QString Screens::internalDpy(Display *dpy)
 
 QString Screens::internal()
 {
-    QString result;
-    Display *dpy;
-    if ((dpy = XOpenDisplay(nullptr)) == nullptr) { return result; }
-    result = internalDpy(dpy);
-    XCloseDisplay(dpy);
-    return result;
+    return instance()->_internal;
+}
+
+int Screens::idle()
+{
+    Screens *service = instance();
+    if (service->dpy == nullptr) { return 0; }
+    long idle = service->queryIdle();
+    // the reply may have pulled pending events into the queue
+    service->processEvents();
+    return idle;
+}
+
+long Screens::queryIdle()
+{
+    long idle = 0;
+    XScreenSaverInfo *info = XScreenSaverAllocInfo();
+    if (info) {
+        XScreenSaverQueryInfo(dpy, DefaultRootWindow(dpy), info);
+        idle = info->idle;
+        XFree(info);
+    }
+    return idle;
+}
+
+bool Screens::hasIdleCounter()
+{
+    return instance()->idleCounter != 0;
+}
+
+void Screens::setIdleThresholds(const QList<int> &seconds, long offset)
+{
+    idleThresholds = seconds;
+    idleOffset = offset;
+    armIdleAlarms();
+}
+
+unsigned long Screens::createIdleAlarm(long value, bool positive)
+{
+    XSyncAlarmAttributes attr;
+    attr.trigger.counter = idleCounter;
+    attr.trigger.value_type = XSyncAbsolute;
+    attr.trigger.test_type = positive ? XSyncPositiveTransition : XSyncNegativeTransition;
+    XSyncIntsToValue(&attr.trigger.wait_value,
+                     (unsigned int)(value & 0xffffffff),
+                     (int)(value >> 32));
+    XSyncIntToValue(&attr.delta, 0); // fire once, re-armed on activity
+    attr.events = True;
+    return XSyncCreateAlarm(dpy,
+                            XSyncCACounter |
+                            XSyncCAValueType |
+                            XSyncCATestType |
+                            XSyncCAValue |
+                            XSyncCADelta |
+                            XSyncCAEvents,
+                            &attr);
+}
+
+// one positive transition alarm per threshold,
+// plus a negative transition alarm that drops the offset on activity
+void Screens::armIdleAlarms()
+{
+    if (dpy == nullptr || idleCounter == 0) { return; }
+    clearIdleAlarms();
+    if (idleOffset != 0) {
+        resetAlarm = createIdleAlarm(1, false);
+        // activity before the alarm existed is not a transition, check once
+        if (queryIdle() < idleOffset) {
+            XSyncDestroyAlarm(dpy, resetAlarm);
+            resetAlarm = 0;
+            idleOffset = 0;
+        }
+    }
+    for (int i = 0; i < idleThresholds.size(); ++i) {
+        if (idleThresholds.at(i) <= 0) { continue; }
+        long value = idleOffset + (long)idleThresholds.at(i)*1000;
+        idleAlarms[createIdleAlarm(value, true)] = idleThresholds.at(i);
+    }
+    XFlush(dpy);
+}
+
+void Screens::clearIdleAlarms()
+{
+    QMapIterator<unsigned long,int> i(idleAlarms);
+    while (i.hasNext()) {
+        i.next();
+        XSyncDestroyAlarm(dpy, i.key());
+    }
+    idleAlarms.clear();
+    if (resetAlarm) {
+        XSyncDestroyAlarm(dpy, resetAlarm);
+        resetAlarm = 0;
+    }
+}
+
+// full enumeration, only needed on startup and for unknown outputs
+void Screens::refresh()
+{
+    if (dpy == nullptr) { return; }
+    _outputs.clear();
+    _names.clear();
+    _internal.clear();
+    XRRScreenResources *sr = XRRGetScreenResourcesCurrent(dpy,
+                                                          DefaultRootWindow(dpy));
+    if (sr == nullptr) { return; }
+    for (int i = 0; i < sr->noutput; ++i) {
+        XRROutputInfo *info = XRRGetOutputInfo(dpy, sr, sr->outputs[i]);
+        if (info == nullptr) { continue; }
+        QString output = info->name;
+        if (i == 0) { _internal = output; }
+        _names[sr->outputs[i]] = output;
+        _outputs[output] = (info->connection == RR_Connected);
+        XRRFreeOutputInfo(info);
+    }
+    XRRFreeScreenResources(sr);
+}
+
+void Screens::processEvents()
+{
+    if (dpy == nullptr) { return; }
+    bool changed = false;
+    while (XPending(dpy)) {
+        XEvent ev;
+        XNextEvent(dpy, &ev);
+        if (syncEventBase >= 0 && ev.type == syncEventBase + XSyncAlarmNotify) {
+            XSyncAlarmNotifyEvent *ae = (XSyncAlarmNotifyEvent*)&ev;
+            if (ae->state == XSyncAlarmDestroyed) { continue; }
+            if (resetAlarm && ae->alarm == resetAlarm) {
+                // user activity, idle counter went back to zero,
+                // so the thresholds count from zero again
+                idleOffset = 0;
+                armIdleAlarms();
+                emit idleReset();
+            } else if (idleAlarms.contains(ae->alarm)) {
+                // watch for activity (negative transition)
+                if (resetAlarm == 0) { resetAlarm = createIdleAlarm(1, false); }
+                XFlush(dpy);
+                emit idleReached(idleAlarms.value(ae->alarm));
+            }
+            continue;
+        }
+        if (rrEventBase < 0 || ev.type != rrEventBase + RRNotify) { continue; }
+        XRRNotifyEvent *ne = (XRRNotifyEvent*)&ev;
+        if (ne->subtype != RRNotify_OutputChange) { continue; }
+        XRROutputChangeNotifyEvent *oce = (XRROutputChangeNotifyEvent*)&ev;
+        bool connected = (oce->connection == RR_Connected);
+        if (!_names.contains(oce->output)) {
+            // new output, rescan once
+            refresh();
+            if (!_names.contains(oce->output)) { continue; }
+        } else if (_outputs.value(_names.value(oce->output)) == connected) { continue; }
+        QString name = _names.value(oce->output);
+        _outputs[name] = connected;
+        emit outputChanged(name, connected);
+        changed = true;
+    }
+    if (changed) { emit outputsChanged(_outputs); }
 }
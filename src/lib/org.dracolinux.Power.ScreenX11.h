@@ -22,18 +22,64 @@
 #ifndef SCREENS_H
 #define SCREENS_H
 
+#include <QObject>
 #include <QMap>
+#include <QList>
 #include <QString>
 
-#include <X11/extensions/Xrandr.h>
+class QSocketNotifier;
+typedef struct _XDisplay Display;
 
-class Screens
+// One persistent X connection for the power tray.
+// Output state is cached and kept up to date from RRNotify events,
+// so the static queries below are just lookups.
+// Idle thresholds are XSync IDLETIME alarms, nothing is polled.
+class Screens : public QObject
 {
+    Q_OBJECT
+
 public:
+    static Screens *instance();
     static QMap<QString,bool> outputsDpy(Display *dpy);
     static QMap<QString,bool> outputs();
     static QString internalDpy(Display *dpy);
     static QString internal();
+    static int idle(); // user idle time in ms
+    static bool hasIdleCounter();
+    Display *display();
+    // arm one alarm per threshold (seconds), offset (ms) is added to all of them
+    // until the next user activity
+    void setIdleThresholds(const QList<int> &seconds, long offset = 0);
+
+signals:
+    void outputChanged(const QString &name, bool connected);
+    void outputsChanged(const QMap<QString,bool> &outputs);
+    void idleReached(int seconds);
+    void idleReset();
+
+private:
+    explicit Screens(QObject *parent = nullptr);
+    ~Screens();
+    Display *dpy;
+    QSocketNotifier *notifier;
+    int rrEventBase;
+    QMap<QString,bool> _outputs;
+    QMap<unsigned long,QString> _names; // RROutput -> name
+    QString _internal;
+    int syncEventBase;
+    unsigned long idleCounter; // XSyncCounter
+    unsigned long resetAlarm; // XSyncAlarm
+    QMap<unsigned long,int> idleAlarms; // XSyncAlarm -> threshold
+    QList<int> idleThresholds;
+    long idleOffset;
+    void refresh();
+    long queryIdle();
+    unsigned long createIdleAlarm(long value, bool positive);
+    void armIdleAlarms();
+    void clearIdleAlarms();
+
+private slots:
+    void processEvents();
 };
 
 #endif // SCREENS_H
@@ -33,6 +33,7 @@
 PowerSettingsWidget::PowerSettingsWidget(QWidget *parent)
     : QWidget(parent)
     , dbus(nullptr)
+    , power(nullptr)
     , lidActionBattery(nullptr)
     , lidActionAC(nullptr)
     , criticalActionBattery(nullptr)
@@ -71,6 +72,11 @@ PowerSettingsWidget::PowerSettingsWidget(QWidget *parent)
                               Draco::powerSessionPath(),
                               Draco::powerSessionName(),
                               session, this);
+    power = new PowerStateClient(this);
+    connect(power,
+            SIGNAL(stateChanged()),
+            this,
+            SLOT(handlePowerState()));
     if (!dbus->isValid()) {
         QMessageBox::warning(this,
                              tr("Power manager not running"),
@@ -823,8 +829,7 @@ void PowerSettingsWidget::loadSettings()
     backlightMouseWheel->setChecked(defaultBacklightMouseWheel);
 
     enableBacklight(backlightDevice.isEmpty()?false:true);
-    enableLid(PowerClient::lidIsPresent(dbus));
-    enableBattery(PowerClient::hasBattery(dbus));
+    handlePowerState();
 }
 
 void PowerSettingsWidget::saveSettings()
@@ -992,9 +997,20 @@ void PowerSettingsWidget::handleAutoSleepACAction(int index)
     PowerSettings::setValue(CONF_SUSPEND_AC_ACTION, index);
 }
 
+void PowerSettingsWidget::handlePowerState()
+{
+    // widgets are only created when the service was up at startup
+    if (!power->isValid() || !lidActionBattery) { return; }
+    enableLid(power->lidIsPresent());
+    enableBattery(power->hasBattery());
+    checkPerms();
+}
+
 void PowerSettingsWidget::checkPerms()
 {
-    bool weCanHibernate = PowerClient::canHibernate(dbus);
+    // don't touch the actions until we know what the system supports
+    if (!power->isValid()) { return; }
+    bool weCanHibernate = power->canHibernate();
     suspendACWakeTimer->setEnabled(weCanHibernate);
     suspendACWakeTimerLabel->setEnabled(weCanHibernate);
     suspendBatteryWakeTimer->setEnabled(weCanHibernate);
@@ -1033,7 +1049,7 @@ void PowerSettingsWidget::checkPerms()
         }
         if (warnCantHibernate) { hibernateWarn(); }
     }
-    if (!PowerClient::canSuspend(dbus)) {
+    if (!power->canSuspend()) {
         bool warnCantSleep = false;
         if (lidActionAC->currentIndex() == lidSleep) {
             warnCantSleep = true;
@@ -40,6 +40,8 @@
 #include <QDateTime>
 #include <QScrollArea>
 
+#include "org.dracolinux.Power.Client.h"
+
 class PowerSettingsWidget : public QWidget
 {
     Q_OBJECT
@@ -50,6 +52,7 @@ public:
 
 private:
     QDBusInterface *dbus;
+    PowerStateClient *power;
     QComboBox *lidActionBattery;
     QComboBox *lidActionAC;
     QComboBox *criticalActionBattery;
@@ -109,6 +112,7 @@ private slots:
     void handleAutoSleepBatteryAction(int index);
     void handleAutoSleepACAction(int index);
     void checkPerms();
+    void handlePowerState();
     void handleBacklightBatteryCheck(bool triggered);
     void handleBacklightACCheck(bool triggered);
     void handleBacklightBatterySlider(int value);
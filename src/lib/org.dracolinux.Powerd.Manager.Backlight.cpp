@@ -25,9 +25,21 @@
 #include <QDirIterator>
 #include <QDebug>
 
+QString PowerBacklight::_root = LINUX_SYS;
+
+void PowerBacklight::setSysRoot(const QString &root)
+{
+    _root = root;
+}
+
+const QString PowerBacklight::getSysRoot()
+{
+    return _root;
+}
+
 const QString PowerBacklight::getDevice()
 {
-    QString path = "/sys/class/backlight";
+    QString path = QString("%1/%2").arg(_root).arg(LINUX_BACKLIGHT);
     QDirIterator it(path, QDirIterator::Subdirectories);
     while (it.hasNext()) {
         QString foundDir = it.next();
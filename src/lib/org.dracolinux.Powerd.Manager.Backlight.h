@@ -24,9 +24,16 @@
 
 #include <QString>
 
+#ifndef LINUX_SYS
+#define LINUX_SYS "/sys"
+#endif
+#define LINUX_BACKLIGHT "class/backlight"
+
 class PowerBacklight
 {
 public:
+    static void setSysRoot(const QString &root);
+    static const QString getSysRoot();
     static const QString getDevice();
     static bool canAdjustBrightness(const QString &device);
     static bool canAdjustBrightness();
@@ -36,6 +43,9 @@ public:
     static int getCurrentBrightness();
     static bool setCurrentBrightness(const QString &device, int value);
     static bool setCurrentBrightness(int value);
+
+private:
+    static QString _root;
 };
 
 #endif // POWER_BACKLIGHT_H
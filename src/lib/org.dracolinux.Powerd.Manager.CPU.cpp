@@ -22,42 +22,199 @@
 #include "org.dracolinux.Powerd.Manager.CPU.h"
 
 #include <QFile>
+#include <QFileInfo>
+#include <QDir>
 #include <QTextStream>
 
-int PowerCpu::getTotal()
+QString PowerCpu::_root = LINUX_SYS;
+bool PowerCpu::_valid = false;
+QString PowerCpu::_online;
+QList<int> PowerCpu::_possible;
+QList<int> PowerCpu::_onlineList;
+QList<cpu_policy> PowerCpu::_policies;
+
+void PowerCpu::setSysRoot(const QString &root)
+{
+    if (root == _root) { return; }
+    _root = root;
+    _valid = false;
+}
+
+const QString PowerCpu::getSysRoot()
+{
+    return _root;
+}
+
+const QString PowerCpu::cpuSys()
+{
+    return QString("%1/%2").arg(_root).arg(LINUX_CPU_SYS);
+}
+
+void PowerCpu::refresh()
 {
-    int counter = 0;
-    while(1) {
-        if (QFile::exists(QString("%1/cpu%2")
-                          .arg(LINUX_CPU_SYS)
-                          .arg(counter))) { counter++; }
-        else { break; }
+    _possible = parseRange(readValue(QString("%1/%2")
+                                     .arg(cpuSys())
+                                     .arg(LINUX_CPU_POSSIBLE)));
+    _online = readValue(QString("%1/%2")
+                        .arg(cpuSys())
+                        .arg(LINUX_CPU_ONLINE));
+    _onlineList = parseRange(_online);
+    _policies.clear();
+
+    // one cpufreq policy can cover several cpus
+    QStringList paths;
+    QDir dir(QString("%1/%2").arg(cpuSys()).arg(LINUX_CPU_DIR));
+    QStringList policies = dir.entryList(QStringList() << QString("%1*").arg(LINUX_CPU_POLICY),
+                                         QDir::Dirs|QDir::NoDotAndDotDot);
+    for (int i=0;i<policies.size();++i) {
+        paths << QString("%1/%2").arg(dir.absolutePath()).arg(policies.at(i));
     }
-    if (counter>0) { return counter; }
-    return -1;
+    if (paths.isEmpty()) { // old kernels, no policyN
+        for (int i=0;i<_onlineList.size();++i) {
+            QFileInfo info(QString("%1/cpu%2/%3")
+                           .arg(cpuSys())
+                           .arg(_onlineList.at(i))
+                           .arg(LINUX_CPU_DIR));
+            if (!info.exists()) { continue; }
+            QString path = info.canonicalFilePath();
+            if (!paths.contains(path)) { paths << path; }
+        }
+    }
+
+    for (int i=0;i<paths.size();++i) {
+        cpu_policy policy;
+        policy.path = paths.at(i);
+        policy.cpus = parseRange(readValue(QString("%1/%2")
+                                           .arg(policy.path)
+                                           .arg(LINUX_CPU_RELATED)));
+        policy.online = parseRange(readValue(QString("%1/%2")
+                                             .arg(policy.path)
+                                             .arg(LINUX_CPU_AFFECTED)));
+        policy.governors = readValue(QString("%1/%2")
+                                     .arg(policy.path)
+                                     .arg(LINUX_CPU_GOVERNORS))
+                           .split(" ", QString::SkipEmptyParts);
+        policy.frequencies = readValue(QString("%1/%2")
+                                       .arg(policy.path)
+                                       .arg(LINUX_CPU_FREQUENCIES))
+                             .split(" ", QString::SkipEmptyParts);
+        policy.preferences = readValue(QString("%1/%2")
+                                       .arg(policy.path)
+                                       .arg(LINUX_CPU_EPPS))
+                             .split(" ", QString::SkipEmptyParts);
+        policy.minFreq = readValue(QString("%1/%2")
+                                   .arg(policy.path)
+                                   .arg(LINUX_CPU_INFO_MIN)).toInt();
+        policy.maxFreq = readValue(QString("%1/%2")
+                                   .arg(policy.path)
+                                   .arg(LINUX_CPU_INFO_MAX)).toInt();
+        _policies << policy;
+    }
+    _valid = true;
 }
 
-const QString PowerCpu::getGovernor(int cpu)
+void PowerCpu::checkTopology()
+{
+    // a single read tells us if cpus were hotplugged
+    if (_valid && _online == readValue(QString("%1/%2")
+                                       .arg(cpuSys())
+                                       .arg(LINUX_CPU_ONLINE))) { return; }
+    refresh();
+}
+
+const QList<int> PowerCpu::parseRange(const QString &range)
+{
+    // "0-3,6,8-11"
+    QList<int> result;
+    QStringList parts = range.split(",", QString::SkipEmptyParts);
+    for (int i=0;i<parts.size();++i) {
+        QStringList bounds = parts.at(i).trimmed().split("-");
+        bool okFirst = false;
+        bool okLast = false;
+        int first = bounds.first().toInt(&okFirst);
+        int last = bounds.last().toInt(&okLast);
+        if (!okFirst || !okLast) { continue; }
+        for (int cpu=first;cpu<=last;++cpu) { result << cpu; }
+    }
+    return result;
+}
+
+const QString PowerCpu::readValue(const QString &path)
 {
     QString result;
-    QFile gov(QString("%1/cpu%2/%3/%4")
-              .arg(LINUX_CPU_SYS)
-              .arg(cpu)
-              .arg(LINUX_CPU_DIR)
-              .arg(LINUX_CPU_GOVERNOR));
-    if (!gov.exists()) { return result; }
-    if (gov.open(QIODevice::ReadOnly|QIODevice::Text)) {
-        result = gov.readAll().trimmed();
-        gov.close();
+    QFile file(path);
+    if (file.open(QIODevice::ReadOnly|QIODevice::Text)) {
+        result = file.readAll().trimmed();
+        file.close();
     }
     return result;
 }
 
+bool PowerCpu::writeValue(const QString &path, const QString &value)
+{
+    QFile file(path);
+    if (file.open(QIODevice::WriteOnly|QIODevice::Truncate)) {
+        QTextStream out(&file);
+        out << value;
+        file.close();
+        return true;
+    }
+    return false;
+}
+
+int PowerCpu::policyForCpu(int cpu)
+{
+    checkTopology();
+    for (int i=0;i<_policies.size();++i) {
+        if (_policies.at(i).cpus.contains(cpu)) { return i; }
+    }
+    return -1;
+}
+
+const QList<int> PowerCpu::getPossible()
+{
+    checkTopology();
+    return _possible;
+}
+
+const QList<int> PowerCpu::getOnline()
+{
+    checkTopology();
+    return _onlineList;
+}
+
+const QList<cpu_policy> PowerCpu::getPolicies()
+{
+    checkTopology();
+    return _policies;
+}
+
+int PowerCpu::getTotal()
+{
+    checkTopology();
+    if (_possible.size()>0) { return _possible.size(); }
+    return -1;
+}
+
+const QString PowerCpu::getGovernor(int cpu)
+{
+    int policy = policyForCpu(cpu);
+    if (policy<0) { return QString(); }
+    return readValue(QString("%1/%2")
+                     .arg(_policies.at(policy).path)
+                     .arg(LINUX_CPU_GOVERNOR));
+}
+
 const QStringList PowerCpu::getGovernors()
 {
+    // one entry per active policy
     QStringList result;
-    for (int i=0;i<getTotal();++i) {
-        QString value = getGovernor(i);
+    checkTopology();
+    for (int i=0;i<_policies.size();++i) {
+        if (_policies.at(i).online.isEmpty()) { continue; }
+        QString value = readValue(QString("%1/%2")
+                                  .arg(_policies.at(i).path)
+                                  .arg(LINUX_CPU_GOVERNOR));
         if (!value.isEmpty()) { result << value; }
     }
     return result;
@@ -65,19 +222,11 @@ const QStringList PowerCpu::getGovernors()
 
 const QStringList PowerCpu::getAvailableGovernors()
 {
-    QStringList result;
-    QFile gov(QString("%1/cpu%2/%3/%4")
-              .arg(LINUX_CPU_SYS)
-              .arg(0)
-              .arg(LINUX_CPU_DIR)
-              .arg(LINUX_CPU_GOVERNORS));
-    if (!gov.exists()) { return result; }
-    if (gov.open(QIODevice::ReadOnly|QIODevice::Text)) {
-        QString value = gov.readAll().trimmed();
-        result = value.split(" ", QString::SkipEmptyParts);
-        gov.close();
+    checkTopology();
+    for (int i=0;i<_policies.size();++i) {
+        if (!_policies.at(i).governors.isEmpty()) { return _policies.at(i).governors; }
     }
-    return result;
+    return QStringList();
 }
 
 bool PowerCpu::governorExists(const QString &gov)
@@ -86,29 +235,29 @@ bool PowerCpu::governorExists(const QString &gov)
     return getAvailableGovernors().contains(gov);
 }
 
+bool PowerCpu::setPolicyGovernor(const cpu_policy &policy, const QString &gov)
+{
+    if (!policy.governors.contains(gov)) { return false; }
+    QString path = QString("%1/%2").arg(policy.path).arg(LINUX_CPU_GOVERNOR);
+    if (readValue(path) == gov) { return true; }
+    if (!writeValue(path, gov)) { return false; }
+    return gov == readValue(path);
+}
+
 bool PowerCpu::setGovernor(const QString &gov, int cpu)
 {
-    if (!governorExists(gov)) { return false; }
-    QFile file(QString("%1/cpu%2/%3/%4")
-              .arg(LINUX_CPU_SYS)
-              .arg(cpu)
-              .arg(LINUX_CPU_DIR)
-              .arg(LINUX_CPU_GOVERNOR));
-    if (file.open(QIODevice::WriteOnly|QIODevice::Truncate)) {
-        QTextStream out(&file);
-        out << gov;
-        file.close();
-        if (gov == getGovernor(cpu)) { return true;}
-    }
-    return false;
+    int policy = policyForCpu(cpu);
+    if (policy<0) { return false; }
+    return setPolicyGovernor(_policies.at(policy), gov);
 }
 
 bool PowerCpu::setGovernor(const QString &gov)
 {
     if (!governorExists(gov)) { return false; }
     bool failed = false;
-    for (int i=0;i<getTotal();++i) {
-        if (!setGovernor(gov, i)) { failed = true; }
+    for (int i=0;i<_policies.size();++i) {
+        if (_policies.at(i).online.isEmpty()) { continue; }
+        if (!setPolicyGovernor(_policies.at(i), gov)) { failed = true; }
     }
     if (failed) { return false; }
     return true;
@@ -116,25 +265,23 @@ bool PowerCpu::setGovernor(const QString &gov)
 
 const QString PowerCpu::getFrequency(int cpu)
 {
-    QString result;
-    QFile freq(QString("%1/cpu%2/%3/%4")
-              .arg(LINUX_CPU_SYS)
-              .arg(cpu)
-              .arg(LINUX_CPU_DIR)
-              .arg(LINUX_CPU_FREQUENCY));
-    if (!freq.exists()) { return result; }
-    if (freq.open(QIODevice::ReadOnly|QIODevice::Text)) {
-        result = freq.readAll().trimmed();
-        freq.close();
-    }
-    return result;
+    int policy = policyForCpu(cpu);
+    if (policy<0) { return QString(); }
+    return readValue(QString("%1/%2")
+                     .arg(_policies.at(policy).path)
+                     .arg(LINUX_CPU_FREQUENCY));
 }
 
 const QStringList PowerCpu::getFrequencies()
 {
+    // one entry per active policy
     QStringList result;
-    for (int i=0;i<getTotal();++i) {
-        QString value = getFrequency(i);
+    checkTopology();
+    for (int i=0;i<_policies.size();++i) {
+        if (_policies.at(i).online.isEmpty()) { continue; }
+        QString value = readValue(QString("%1/%2")
+                                  .arg(_policies.at(i).path)
+                                  .arg(LINUX_CPU_FREQUENCY));
         if (!value.isEmpty()) { result << value; }
     }
     return result;
@@ -142,19 +289,11 @@ const QStringList PowerCpu::getFrequencies()
 
 const QStringList PowerCpu::getAvailableFrequency()
 {
-    QStringList result;
-    QFile gov(QString("%1/cpu%2/%3/%4")
-              .arg(LINUX_CPU_SYS)
-              .arg(0)
-              .arg(LINUX_CPU_DIR)
-              .arg(LINUX_CPU_FREQUENCIES));
-    if (!gov.exists()) { return result; }
-    if (gov.open(QIODevice::ReadOnly|QIODevice::Text)) {
-        QString value = gov.readAll().trimmed();
-        result = value.split(" ", QString::SkipEmptyParts);
-        gov.close();
+    checkTopology();
+    for (int i=0;i<_policies.size();++i) {
+        if (!_policies.at(i).frequencies.isEmpty()) { return _policies.at(i).frequencies; }
     }
-    return result;
+    return QStringList();
 }
 
 bool PowerCpu::frequencyExists(const QString &freq)
@@ -163,41 +302,92 @@ bool PowerCpu::frequencyExists(const QString &freq)
     return getAvailableFrequency().contains(freq);
 }
 
+bool PowerCpu::setPolicyFrequency(const cpu_policy &policy, const QString &freq)
+{
+    if (!policy.frequencies.contains(freq)) { return false; }
+    if (!setPolicyGovernor(policy, "userspace")) { return false; }
+    if (!writeValue(QString("%1/%2")
+                    .arg(policy.path)
+                    .arg(LINUX_CPU_SET_SPEED), freq)) { return false; }
+    return freq == readValue(QString("%1/%2")
+                             .arg(policy.path)
+                             .arg(LINUX_CPU_FREQUENCY));
+}
+
 bool PowerCpu::setFrequency(const QString &freq, int cpu)
 {
-    if (!frequencyExists(freq)) { return false; }
-    if (getGovernor(cpu) != "userspace") {
-        if (!setGovernor("userspace", cpu)) { return false; }
-    }
-    QFile file(QString("%1/cpu%2/%3/%4")
-              .arg(LINUX_CPU_SYS)
-              .arg(cpu)
-              .arg(LINUX_CPU_DIR)
-              .arg(LINUX_CPU_SET_SPEED));
-    if (file.open(QIODevice::WriteOnly|QIODevice::Truncate)) {
-        QTextStream out(&file);
-        out << freq;
-        file.close();
-        if (freq == getFrequency(cpu)) { return true;}
-    }
-    return false;
+    int policy = policyForCpu(cpu);
+    if (policy<0) { return false; }
+    return setPolicyFrequency(_policies.at(policy), freq);
 }
 
 bool PowerCpu::setFrequency(const QString &freq)
 {
     if (!frequencyExists(freq)) { return false; }
     bool failed = false;
-    for (int i=0;i<getTotal();++i) {
-        if (!setFrequency(freq, i)) { failed = true; }
+    for (int i=0;i<_policies.size();++i) {
+        if (_policies.at(i).online.isEmpty()) { continue; }
+        if (!setPolicyFrequency(_policies.at(i), freq)) { failed = true; }
     }
     if (failed) { return false; }
     return true;
 }
 
+const QString PowerCpu::getPreference(const cpu_policy &policy)
+{
+    return readValue(QString("%1/%2")
+                     .arg(policy.path)
+                     .arg(LINUX_CPU_EPP));
+}
+
+bool PowerCpu::setPreference(const cpu_policy &policy, const QString &pref)
+{
+    if (!policy.preferences.contains(pref)) { return false; }
+    QString path = QString("%1/%2").arg(policy.path).arg(LINUX_CPU_EPP);
+    if (readValue(path) == pref) { return true; }
+    if (!writeValue(path, pref)) { return false; }
+    return pref == readValue(path);
+}
+
+bool PowerCpu::setMaxPerf(const cpu_policy &policy, int percent)
+{
+    if (policy.maxFreq<=0) { return false; }
+    if (percent>100) { percent = 100; }
+    qlonglong freq = (qlonglong)policy.maxFreq*percent/100;
+    if (freq<policy.minFreq) { freq = policy.minFreq; }
+    QString path = QString("%1/%2").arg(policy.path).arg(LINUX_CPU_FREQUENCY_MAX);
+    QString value = QString::number(freq);
+    if (readValue(path) == value) { return true; }
+    return writeValue(path, value);
+}
+
+bool PowerCpu::hasTurbo()
+{
+    if (hasPState()) { return hasPStateTurbo(); }
+    return readValue(QString("%1/%2/%3")
+                     .arg(cpuSys())
+                     .arg(LINUX_CPU_DIR)
+                     .arg(LINUX_CPU_BOOST)) == "1";
+}
+
+bool PowerCpu::setTurbo(bool turbo)
+{
+    if (hasPState()) { return setPStateTurbo(turbo); }
+    QString path = QString("%1/%2/%3")
+                   .arg(cpuSys())
+                   .arg(LINUX_CPU_DIR)
+                   .arg(LINUX_CPU_BOOST);
+    if (!QFile::exists(path)) { return false; }
+    QString value = turbo?"1":"0";
+    if (readValue(path) == value) { return true; }
+    if (!writeValue(path, value)) { return false; }
+    return value == readValue(path);
+}
+
 bool PowerCpu::hasPState()
 {
-    return QFile::exists(QString("%1/%1")
-                         .arg(LINUX_CPU_SYS)
+    return QFile::exists(QString("%1/%2")
+                         .arg(cpuSys())
                          .arg(LINUX_CPU_PSTATE));
 }
 
@@ -205,59 +395,64 @@ bool PowerCpu::hasPStateTurbo()
 {
     bool result = false;
     if (!hasPState()) { return result; }
-    QFile turbo(QString("%1/%2/%3")
-                .arg(LINUX_CPU_SYS)
-                .arg(LINUX_CPU_PSTATE)
-                .arg(LINUX_CPU_PSTATE_NOTURBO));
-    if (!turbo.exists()) { return result; }
-    if (turbo.open(QIODevice::ReadOnly|QIODevice::Text)) {
-        QString value = turbo.readAll().trimmed();
-        turbo.close();
-        if (value=="1") { result = false; }
-        else if (value=="0") { result = true; }
-    }
+    QString value = readValue(QString("%1/%2/%3")
+                              .arg(cpuSys())
+                              .arg(LINUX_CPU_PSTATE)
+                              .arg(LINUX_CPU_PSTATE_NOTURBO));
+    if (value=="1") { result = false; }
+    else if (value=="0") { result = true; }
     return result;
 }
 
 bool PowerCpu::setPStateTurbo(bool turbo)
 {
     if (!hasPState()) { return false; }
-    QFile file(QString("%1/%2/%3")
-              .arg(LINUX_CPU_SYS)
-              .arg(LINUX_CPU_PSTATE)
-              .arg(LINUX_CPU_PSTATE_NOTURBO));
-    if (file.open(QIODevice::WriteOnly|QIODevice::Truncate)) {
-        QTextStream out(&file);
-        if (turbo) { out << "0"; }
-        else { out << "1"; }
-        file.close();
-        if (turbo == hasPStateTurbo()) { return true; }
-    }
-    return false;
+    if (turbo == hasPStateTurbo()) { return true; }
+    if (!writeValue(QString("%1/%2/%3")
+                    .arg(cpuSys())
+                    .arg(LINUX_CPU_PSTATE)
+                    .arg(LINUX_CPU_PSTATE_NOTURBO), turbo?"0":"1")) { return false; }
+    return turbo == hasPStateTurbo();
 }
 
-// TODO
 int PowerCpu::getPStateMax()
 {
-    return 0;
+    if (!hasPState()) { return 0; }
+    return readValue(QString("%1/%2/%3")
+                     .arg(cpuSys())
+                     .arg(LINUX_CPU_PSTATE)
+                     .arg(LINUX_CPU_PSTATE_MAX_PERF)).toInt();
 }
 
-// TODO
 int PowerCpu::getPStateMin()
 {
-    return 0;
+    if (!hasPState()) { return 0; }
+    return readValue(QString("%1/%2/%3")
+                     .arg(cpuSys())
+                     .arg(LINUX_CPU_PSTATE)
+                     .arg(LINUX_CPU_PSTATE_MIN_PERF)).toInt();
 }
 
-// TODO
 bool PowerCpu::setPStateMax(int maxState)
 {
-    Q_UNUSED(maxState)
-    return false;
+    if (!hasPState() || maxState<0 || maxState>100) { return false; }
+    if (maxState == getPStateMax()) { return true; }
+    if (!writeValue(QString("%1/%2/%3")
+                    .arg(cpuSys())
+                    .arg(LINUX_CPU_PSTATE)
+                    .arg(LINUX_CPU_PSTATE_MAX_PERF),
+                    QString::number(maxState))) { return false; }
+    return maxState == getPStateMax();
 }
 
-// TODO
 bool PowerCpu::setPStateMin(int minState)
 {
-    Q_UNUSED(minState)
-    return false;
+    if (!hasPState() || minState<0 || minState>100) { return false; }
+    if (minState == getPStateMin()) { return true; }
+    if (!writeValue(QString("%1/%2/%3")
+                    .arg(cpuSys())
+                    .arg(LINUX_CPU_PSTATE)
+                    .arg(LINUX_CPU_PSTATE_MIN_PERF),
+                    QString::number(minState))) { return false; }
+    return minState == getPStateMin();
 }
@@ -25,8 +25,16 @@
 #include <QStringList>
 #include <QDBusInterface>
 
-#define LINUX_CPU_SYS "/sys/devices/system/cpu"
+#ifndef LINUX_SYS
+#define LINUX_SYS "/sys"
+#endif
+#define LINUX_CPU_SYS "devices/system/cpu"
 #define LINUX_CPU_DIR "cpufreq"
+#define LINUX_CPU_POSSIBLE "possible"
+#define LINUX_CPU_ONLINE "online"
+#define LINUX_CPU_POLICY "policy"
+#define LINUX_CPU_RELATED "related_cpus"
+#define LINUX_CPU_AFFECTED "affected_cpus"
 #define LINUX_CPU_FREQUENCIES "scaling_available_frequencies"
 #define LINUX_CPU_FREQUENCY "scaling_cur_freq"
 #define LINUX_CPU_FREQUENCY_MAX "scaling_max_freq"
@@ -34,15 +42,41 @@
 #define LINUX_CPU_GOVERNORS "scaling_available_governors"
 #define LINUX_CPU_GOVERNOR "scaling_governor"
 #define LINUX_CPU_SET_SPEED "scaling_setspeed"
+#define LINUX_CPU_INFO_MAX "cpuinfo_max_freq"
+#define LINUX_CPU_INFO_MIN "cpuinfo_min_freq"
+#define LINUX_CPU_EPP "energy_performance_preference"
+#define LINUX_CPU_EPPS "energy_performance_available_preferences"
+#define LINUX_CPU_BOOST "boost"
 #define LINUX_CPU_PSTATE "intel_pstate"
 #define LINUX_CPU_PSTATE_STATUS "status"
 #define LINUX_CPU_PSTATE_NOTURBO "no_turbo"
 #define LINUX_CPU_PSTATE_MAX_PERF "max_perf_pct"
 #define LINUX_CPU_PSTATE_MIN_PERF "min_perf_pct"
 
+struct cpu_policy
+{
+    QString path;
+    QList<int> cpus; // related cpus
+    QList<int> online; // affected cpus
+    QStringList governors;
+    QStringList frequencies;
+    QStringList preferences;
+    int minFreq;
+    int maxFreq;
+};
+
+// cpu topology is read once and only rebuilt when the
+// online cpu mask changes (hotplug), all cpufreq writes
+// are done once per policy and not once per cpu.
 class PowerCpu
 {
 public:
+    static void setSysRoot(const QString &root);
+    static const QString getSysRoot();
+    static void refresh();
+    static const QList<int> getPossible();
+    static const QList<int> getOnline();
+    static const QList<cpu_policy> getPolicies();
     static int getTotal();
 
     static const QString getGovernor(int cpu);
@@ -59,6 +93,13 @@ public:
     static bool setFrequency(const QString &freq, int cpu);
     static bool setFrequency(const QString &freq);
 
+    static const QString getPreference(const cpu_policy &policy);
+    static bool setPreference(const cpu_policy &policy, const QString &pref);
+    static bool setMaxPerf(const cpu_policy &policy, int percent);
+
+    static bool hasTurbo();
+    static bool setTurbo(bool turbo);
+
     static bool hasPState();
     static bool hasPStateTurbo();
     static bool setPStateTurbo(bool turbo);
@@ -66,6 +107,23 @@ public:
     static int getPStateMin();
     static bool setPStateMax(int maxState);
     static bool setPStateMin(int minState);
+
+private:
+    static QString _root;
+    static bool _valid;
+    static QString _online;
+    static QList<int> _possible;
+    static QList<int> _onlineList;
+    static QList<cpu_policy> _policies;
+
+    static const QString cpuSys();
+    static void checkTopology();
+    static const QList<int> parseRange(const QString &range);
+    static const QString readValue(const QString &path);
+    static bool writeValue(const QString &path, const QString &value);
+    static int policyForCpu(int cpu);
+    static bool setPolicyGovernor(const cpu_policy &policy, const QString &gov);
+    static bool setPolicyFrequency(const cpu_policy &policy, const QString &freq);
 };
 
 #endif // POWER_CPU_H
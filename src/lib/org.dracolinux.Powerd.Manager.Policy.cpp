@@ -0,0 +1,285 @@
+/*
+#
+# Draco Desktop Environment <https://dracolinux.org>
+# Copyright (c) 2019, Ole-André Rodlie <ole.andre.rodlie@gmail.com>
+# All rights reserved.
+#
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser Public License as published by
+* the Free Software Foundation; either version 2.1 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>
+#
+*/
+
+#include "org.dracolinux.Powerd.Manager.Policy.h"
+#include "org.dracolinux.Powerd.Manager.CPU.h"
+
+#include <QFile>
+#include <QDir>
+#include <QStringList>
+#include <QDebug>
+
+static const QString readValue(const QString &path)
+{
+    QString result;
+    QFile file(path);
+    if (file.open(QIODevice::ReadOnly|QIODevice::Text)) {
+        result = file.readAll().trimmed();
+        file.close();
+    }
+    return result;
+}
+
+PowerPolicy::PowerPolicy(QObject *parent)
+    : QObject(parent)
+    , timer(nullptr)
+    , sysRoot(LINUX_SYS)
+    , procRoot(LINUX_PROC)
+    , _profile(cpuProfileNone)
+    , _level(-1)
+    , _onBattery(false)
+    , lastTotal(0)
+    , lastIdle(0)
+    , quietSamples(0)
+{
+    timer = new QTimer(this);
+    timer->setInterval(POLICY_INTERVAL);
+    connect(timer,
+            SIGNAL(timeout()),
+            this,
+            SLOT(sample()));
+}
+
+void PowerPolicy::setSysRoot(const QString &root)
+{
+    sysRoot = root;
+    PowerCpu::setSysRoot(root);
+}
+
+void PowerPolicy::setProcRoot(const QString &root)
+{
+    procRoot = root;
+    lastTotal = 0;
+    lastIdle = 0;
+}
+
+int PowerPolicy::profile()
+{
+    return _profile;
+}
+
+const QString PowerPolicy::profileName()
+{
+    switch (_profile) {
+    case cpuProfilePerformance:
+        return QString("performance");
+    case cpuProfileBalanced:
+        return QString("balanced");
+    case cpuProfilePowersave:
+        return QString("powersave");
+    default:;
+    }
+    return QString();
+}
+
+bool PowerPolicy::setProfile(const QString &name)
+{
+    int profile = cpuProfileNone;
+    if (name == "performance") { profile = cpuProfilePerformance; }
+    else if (name == "balanced") { profile = cpuProfileBalanced; }
+    else if (name == "powersave") { profile = cpuProfilePowersave; }
+    else if (!name.isEmpty()) { return false; }
+
+    _profile = profile;
+    if (_profile == cpuProfileNone) {
+        timer->stop();
+        if (_level>=0) { restoreDefaults(); }
+        _level = -1;
+        return true;
+    }
+    _onBattery = readOnBattery();
+    int level = _level;
+    if (level<minLevel()) { level = minLevel(); }
+    else if (level>maxLevel()) { level = maxLevel(); }
+    _level = -1; // force, the profile may change the level settings
+    applyLevel(level);
+    quietSamples = 0;
+    readLoad(); // prime the counters
+    timer->start();
+    return true;
+}
+
+int PowerPolicy::level()
+{
+    return _level;
+}
+
+bool PowerPolicy::onBattery()
+{
+    return _onBattery;
+}
+
+double PowerPolicy::readLoad()
+{
+    // cpu  user nice system idle iowait irq softirq steal ...
+    QStringList fields;
+    QFile file(QString("%1/%2").arg(procRoot).arg(LINUX_PROC_STAT));
+    if (file.open(QIODevice::ReadOnly|QIODevice::Text)) {
+        fields = QString(file.readLine()).simplified().split(" ");
+        file.close();
+    }
+    if (fields.size()<9 || fields.at(0) != "cpu") { return 0; }
+    qulonglong total = 0;
+    for (int i=1;i<9;++i) { total += fields.at(i).toULongLong(); }
+    qulonglong idle = fields.at(4).toULongLong()+fields.at(5).toULongLong();
+
+    double result = 0;
+    if (lastTotal>0 && total>lastTotal) {
+        qulonglong busy = (total-lastTotal)-(idle-lastIdle);
+        result = 100.0*busy/(total-lastTotal);
+    }
+    lastTotal = total;
+    lastIdle = idle;
+    return result;
+}
+
+double PowerPolicy::readPressure()
+{
+    // some avg10=0.00 avg60=0.00 avg300=0.00 total=0
+    QFile file(QString("%1/%2").arg(procRoot).arg(LINUX_PROC_PSI_CPU));
+    if (!file.open(QIODevice::ReadOnly|QIODevice::Text)) { return 0; }
+    QString line = file.readLine();
+    file.close();
+    if (!line.startsWith("some")) { return 0; }
+    QStringList fields = line.simplified().split(" ");
+    for (int i=1;i<fields.size();++i) {
+        if (fields.at(i).startsWith("avg10=")) {
+            return fields.at(i).mid(6).toDouble();
+        }
+    }
+    return 0;
+}
+
+bool PowerPolicy::readOnBattery()
+{
+    // on battery if there is a mains supply and none are online
+    QDir dir(QString("%1/%2").arg(sysRoot).arg(LINUX_POWER_SUPPLY));
+    QStringList supplies = dir.entryList(QDir::Dirs|QDir::NoDotAndDotDot);
+    bool hasMains = false;
+    for (int i=0;i<supplies.size();++i) {
+        QString path = QString("%1/%2").arg(dir.absolutePath()).arg(supplies.at(i));
+        if (readValue(QString("%1/type").arg(path)) != "Mains") { continue; }
+        hasMains = true;
+        if (readValue(QString("%1/online").arg(path)) == "1") { return false; }
+    }
+    return hasMains;
+}
+
+int PowerPolicy::minLevel()
+{
+    switch (_profile) {
+    case cpuProfilePerformance:
+        return _onBattery?cpuLevelMid:cpuLevelHigh;
+    case cpuProfileBalanced:
+        return _onBattery?cpuLevelLow:cpuLevelMid;
+    default:;
+    }
+    return cpuLevelLow;
+}
+
+int PowerPolicy::maxLevel()
+{
+    switch (_profile) {
+    case cpuProfilePerformance:
+    case cpuProfileBalanced:
+        return cpuLevelHigh;
+    case cpuProfilePowersave:
+        return _onBattery?cpuLevelLow:cpuLevelMid;
+    default:;
+    }
+    return cpuLevelLow;
+}
+
+void PowerPolicy::applyLevel(int level)
+{
+    if (level == _level) { return; }
+    QString pref;
+    int maxPerf = 100;
+    bool turbo = true;
+    switch (level) {
+    case cpuLevelLow:
+        pref = "power";
+        maxPerf = POLICY_LOW_MAX_PERF;
+        turbo = false;
+        break;
+    case cpuLevelMid:
+        pref = _onBattery?"balance_power":"balance_performance";
+        turbo = !_onBattery;
+        break;
+    default:
+        pref = "performance";
+    }
+    qDebug() << "CPU policy level" << level << pref << maxPerf << turbo;
+
+    QList<cpu_policy> policies = PowerCpu::getPolicies();
+    for (int i=0;i<policies.size();++i) {
+        const cpu_policy &policy = policies.at(i);
+        if (policy.online.isEmpty()) { continue; }
+        if (!policy.preferences.isEmpty() && !PowerCpu::setPreference(policy, pref)) {
+            PowerCpu::setPreference(policy, "default");
+        }
+        PowerCpu::setMaxPerf(policy, maxPerf);
+    }
+    PowerCpu::setTurbo(turbo);
+
+    _level = level;
+    emit levelChanged(_level);
+}
+
+// undo what the levels wrote, so disabling the policy never leaves the cpu capped
+void PowerPolicy::restoreDefaults()
+{
+    qDebug() << "CPU policy disabled, restore defaults";
+    QList<cpu_policy> policies = PowerCpu::getPolicies();
+    for (int i=0;i<policies.size();++i) {
+        const cpu_policy &policy = policies.at(i);
+        if (policy.online.isEmpty()) { continue; }
+        if (!policy.preferences.isEmpty()) { PowerCpu::setPreference(policy, "default"); }
+        PowerCpu::setMaxPerf(policy, 100);
+    }
+    PowerCpu::setTurbo(true);
+}
+
+void PowerPolicy::sample()
+{
+    if (_profile == cpuProfileNone) { return; }
+    bool battery = readOnBattery();
+    double load = qMax(readLoad(), readPressure());
+
+    int level = _level;
+    if (battery != _onBattery) { // new range, and mid differs on battery
+        _onBattery = battery;
+        _level = -1;
+    }
+    if (load>=POLICY_LOAD_UP) {
+        quietSamples = 0;
+        level++;
+    } else if (load<=POLICY_LOAD_DOWN) {
+        if (++quietSamples>=POLICY_DOWN_SAMPLES) {
+            quietSamples = 0;
+            level--;
+        }
+    } else { quietSamples = 0; }
+
+    if (level<minLevel()) { level = minLevel(); }
+    else if (level>maxLevel()) { level = maxLevel(); }
+    applyLevel(level);
+}
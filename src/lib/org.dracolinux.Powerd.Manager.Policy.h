@@ -0,0 +1,99 @@
+/*
+#
+# Draco Desktop Environment <https://dracolinux.org>
+# Copyright (c) 2019, Ole-André Rodlie <ole.andre.rodlie@gmail.com>
+# All rights reserved.
+#
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser Public License as published by
+* the Free Software Foundation; either version 2.1 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>
+#
+*/
+
+#ifndef POWER_POLICY_H
+#define POWER_POLICY_H
+
+#include <QObject>
+#include <QTimer>
+#include <QString>
+
+#define LINUX_PROC "/proc"
+#define LINUX_PROC_STAT "stat"
+#define LINUX_PROC_PSI_CPU "pressure/cpu"
+#define LINUX_POWER_SUPPLY "class/power_supply"
+
+#define POLICY_INTERVAL 2000 // ms between samples
+#define POLICY_LOAD_UP 60 // % busy (or stalled) to step up
+#define POLICY_LOAD_DOWN 25 // % busy (or stalled) to step down
+#define POLICY_DOWN_SAMPLES 5 // quiet samples needed to step down
+#define POLICY_LOW_MAX_PERF 60 // % of max freq on the low level
+
+enum cpuProfile
+{
+    cpuProfileNone,
+    cpuProfilePerformance,
+    cpuProfileBalanced,
+    cpuProfilePowersave
+};
+
+enum cpuLevel
+{
+    cpuLevelLow,
+    cpuLevelMid,
+    cpuLevelHigh
+};
+
+// samples cpu load and pressure, and moves every cpufreq policy
+// between three levels (epp, max freq and turbo) within the range
+// allowed by the profile and power source. Steps up on the first
+// busy sample, steps down only after several quiet ones.
+class PowerPolicy : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PowerPolicy(QObject *parent = nullptr);
+    void setSysRoot(const QString &root);
+    void setProcRoot(const QString &root);
+    int profile();
+    const QString profileName();
+    bool setProfile(const QString &name);
+    int level();
+    bool onBattery();
+
+private:
+    QTimer *timer;
+    QString sysRoot;
+    QString procRoot;
+    int _profile;
+    int _level;
+    bool _onBattery;
+    qulonglong lastTotal;
+    qulonglong lastIdle;
+    int quietSamples;
+
+    double readLoad();
+    double readPressure();
+    bool readOnBattery();
+    int minLevel();
+    int maxLevel();
+    void applyLevel(int level);
+    void restoreDefaults();
+
+signals:
+    void levelChanged(int level);
+
+private slots:
+    void sample();
+};
+
+#endif // POWER_POLICY_H
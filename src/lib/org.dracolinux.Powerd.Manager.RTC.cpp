@@ -21,6 +21,8 @@
 
 #include "org.dracolinux.Powerd.Manager.RTC.h"
 
+#include <QFile>
+
 #ifdef Q_OS_LINUX
 #include <linux/rtc.h>
 #include <sys/ioctl.h>
@@ -31,10 +33,39 @@
 #define RTC_DEV "/dev/rtc"
 #endif
 
+QString PowerRtc::_root = LINUX_SYS;
+
+void PowerRtc::setSysRoot(const QString &root)
+{
+    _root = root;
+}
+
+const QString PowerRtc::getSysRoot()
+{
+    return _root;
+}
+
+bool PowerRtc::setWakeAlarm(const QDateTime &date)
+{
+    // seconds since epoch, must be cleared before a new alarm is set
+    QString path = QString("%1/%2").arg(_root).arg(LINUX_RTC_WAKEALARM);
+    if (!QFile::exists(path)) { return false; }
+    QFile clear(path);
+    if (!clear.open(QIODevice::WriteOnly|QIODevice::Truncate)) { return false; }
+    clear.write("0");
+    clear.close();
+    QFile alarm(path);
+    if (!alarm.open(QIODevice::WriteOnly|QIODevice::Truncate)) { return false; }
+    bool result = alarm.write(QByteArray::number(date.toTime_t()))>0;
+    alarm.close();
+    return result;
+}
+
 bool PowerRtc::setAlarm(const QDateTime &date)
 {
 #ifdef Q_OS_LINUX
     if (!date.isValid() || date.isNull()) { return false; }
+    if (setWakeAlarm(date)) { return true; }
 
     int fd, result = 0;
     struct rtc_time rtc;
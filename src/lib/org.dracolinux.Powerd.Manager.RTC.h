@@ -23,11 +23,23 @@
 #define POWER_RTC_H
 
 #include <QDateTime>
+#include <QString>
+
+#ifndef LINUX_SYS
+#define LINUX_SYS "/sys"
+#endif
+#define LINUX_RTC_WAKEALARM "class/rtc/rtc0/wakealarm"
 
 class PowerRtc
 {
 public:
+    static void setSysRoot(const QString &root);
+    static const QString getSysRoot();
     static bool setAlarm(const QDateTime &date);
+
+private:
+    static QString _root;
+    static bool setWakeAlarm(const QDateTime &date);
 };
 
 #endif // POWER_RTC_H
@@ -0,0 +1,94 @@
+/*
+#
+# Draco Desktop Environment <https://dracolinux.org>
+# Copyright (c) 2019, Ole-André Rodlie <ole.andre.rodlie@gmail.com>
+# All rights reserved.
+#
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser Public License as published by
+* the Free Software Foundation; either version 2.1 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>
+#
+*/
+
+#include "org.dracolinux.Powerd.Manager.Transition.h"
+#include "org.dracolinux.Powerd.Manager.Backlight.h"
+
+PowerTransition::PowerTransition(QObject *parent)
+    : QObject(parent)
+    , timer(nullptr)
+    , curve(QEasingCurve::OutCubic)
+{
+    timer = new QTimer(this);
+    timer->setInterval(TRANSITION_INTERVAL);
+    connect(timer,
+            SIGNAL(timeout()),
+            this,
+            SLOT(step()));
+}
+
+bool PowerTransition::start(const QString &device, int value, int duration)
+{
+    if (!PowerBacklight::canAdjustBrightness(device)) { return false; }
+    backlight_transition transition;
+    transition.from = currentValue(device);
+    transition.last = transition.from;
+    transition.max = PowerBacklight::getMaxBrightness(device);
+    transition.to = qBound(0, value, transition.max);
+    transition.duration = qBound(0, duration, TRANSITION_MAX_DURATION);
+    transition.elapsed.start();
+    transitions[device] = transition;
+    if (transition.duration==0) { step(); }
+    else if (!timer->isActive()) { timer->start(); }
+    return true;
+}
+
+bool PowerTransition::adjust(const QString &device, int delta, int duration)
+{
+    // relative to where we are heading, not where we are
+    int value;
+    if (transitions.contains(device)) { value = transitions.value(device).to; }
+    else { value = PowerBacklight::getCurrentBrightness(device); }
+    return start(device, value+delta, duration);
+}
+
+void PowerTransition::stop(const QString &device)
+{
+    transitions.remove(device);
+    if (transitions.isEmpty()) { timer->stop(); }
+}
+
+int PowerTransition::currentValue(const QString &device)
+{
+    if (transitions.contains(device)) { return transitions.value(device).last; }
+    return PowerBacklight::getCurrentBrightness(device);
+}
+
+void PowerTransition::step()
+{
+    QMap<QString, backlight_transition>::iterator it = transitions.begin();
+    while (it != transitions.end()) {
+        backlight_transition &transition = it.value();
+        qint64 elapsed = transition.elapsed.elapsed();
+        int value = transition.to;
+        if (transition.duration>0 && elapsed<transition.duration) {
+            qreal progress = curve.valueForProgress((qreal)elapsed/transition.duration);
+            value = transition.from+qRound((transition.to-transition.from)*progress);
+        }
+        if (value != transition.last) {
+            PowerBacklight::setCurrentBrightness(it.key(), value);
+            transition.last = value;
+        }
+        if (value == transition.to) { it = transitions.erase(it); }
+        else { ++it; }
+    }
+    if (transitions.isEmpty()) { timer->stop(); }
+}
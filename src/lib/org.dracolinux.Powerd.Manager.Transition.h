@@ -0,0 +1,68 @@
+/*
+#
+# Draco Desktop Environment <https://dracolinux.org>
+# Copyright (c) 2019, Ole-André Rodlie <ole.andre.rodlie@gmail.com>
+# All rights reserved.
+#
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser Public License as published by
+* the Free Software Foundation; either version 2.1 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>
+#
+*/
+
+#ifndef POWER_TRANSITION_H
+#define POWER_TRANSITION_H
+
+#include <QObject>
+#include <QTimer>
+#include <QMap>
+#include <QElapsedTimer>
+#include <QEasingCurve>
+
+#define TRANSITION_INTERVAL 16 // ms between backlight writes
+#define TRANSITION_MAX_DURATION 2000
+
+struct backlight_transition
+{
+    int from;
+    int to;
+    int max;
+    int last; // last value written
+    int duration;
+    QElapsedTimer elapsed;
+};
+
+// eased backlight changes done on our own timer, a new request for
+// a device continues from where the running one is, so overlapping
+// requests are merged and sysfs is written at most once per tick.
+class PowerTransition : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PowerTransition(QObject *parent = nullptr);
+    bool start(const QString &device, int value, int duration);
+    bool adjust(const QString &device, int delta, int duration);
+    void stop(const QString &device);
+
+private:
+    QTimer *timer;
+    QEasingCurve curve;
+    QMap<QString, backlight_transition> transitions;
+
+    int currentValue(const QString &device);
+
+private slots:
+    void step();
+};
+
+#endif // POWER_TRANSITION_H
@@ -23,11 +23,31 @@
 #include "org.dracolinux.Powerd.Manager.RTC.h"
 #include "org.dracolinux.Powerd.Manager.Backlight.h"
 #include "org.dracolinux.Powerd.Manager.CPU.h"
+#include "org.dracolinux.Powerd.Manager.Policy.h"
+#include "org.dracolinux.Powerd.Manager.Transition.h"
 
 #include <QDebug>
 
 Manager::Manager(QObject *parent) : QObject(parent)
+  , policy(NULL)
+  , transition(NULL)
 {
+    policy = new PowerPolicy(this);
+    transition = new PowerTransition(this);
+}
+
+void Manager::setSysRoot(const QString &root)
+{
+    qDebug() << "Using sysfs root" << root;
+    PowerBacklight::setSysRoot(root);
+    PowerRtc::setSysRoot(root);
+    policy->setSysRoot(root); // also sets the PowerCpu root
+}
+
+void Manager::setProcRoot(const QString &root)
+{
+    qDebug() << "Using procfs root" << root;
+    policy->setProcRoot(root);
 }
 
 bool Manager::SetWakeAlarm(const QString &alarm)
@@ -42,12 +62,23 @@ bool Manager::SetDisplayBacklight(const QString &device, int value)
 {
     qDebug() << "Try to set DISPLAY backlight" << device << value;
     if (!PowerBacklight::canAdjustBrightness(device)) { return false; }
+    transition->stop(device);
     int light = value;
     if (light>PowerBacklight::getMaxBrightness(device)) { light = PowerBacklight::getMaxBrightness(device); }
     else if (light<0) { light = 0; }
     return PowerBacklight::setCurrentBrightness(device, light);
 }
 
+bool Manager::FadeDisplayBacklight(const QString &device, int value, int duration)
+{
+    return transition->start(device, value, duration);
+}
+
+bool Manager::AdjustDisplayBacklight(const QString &device, int delta, int duration)
+{
+    return transition->adjust(device, delta, duration);
+}
+
 bool Manager::SetCpuGovernor(const QString &gov)
 {
     qDebug() << "Try to set CPU governor" << gov;
@@ -60,3 +91,13 @@ bool Manager::SetCpuFrequency(const QString &freq)
     return  PowerCpu::setFrequency(freq);
 }
 
+bool Manager::SetCpuProfile(const QString &profile)
+{
+    qDebug() << "Try to set CPU profile" << profile;
+    return policy->setProfile(profile);
+}
+
+const QString Manager::CpuProfile()
+{
+    return policy->profileName();
+}
@@ -25,18 +25,31 @@
 #include <QObject>
 #include <QString>
 
+class PowerPolicy;
+class PowerTransition;
+
 class Manager : public QObject
 {
     Q_OBJECT
 
 public:
     explicit Manager(QObject *parent = NULL);
+    void setSysRoot(const QString &root);
+    void setProcRoot(const QString &root);
+
+private:
+    PowerPolicy *policy;
+    PowerTransition *transition;
 
 public slots:
     bool SetWakeAlarm(const QString &alarm);
     bool SetDisplayBacklight(const QString &device, int value);
+    bool FadeDisplayBacklight(const QString &device, int value, int duration);
+    bool AdjustDisplayBacklight(const QString &device, int delta, int duration);
     bool SetCpuGovernor(const QString &gov);
     bool SetCpuFrequency(const QString &freq);
+    bool SetCpuProfile(const QString &profile);
+    const QString CpuProfile();
 };
 
 #endif // MANAGER_H
@@ -69,8 +69,11 @@ enum criticalAction
 #define CRITICAL_DEFAULT criticalNone
 
 #define BACKLIGHT_MOVE_VALUE 10
+#define BACKLIGHT_FADE_DURATION 200 // ms
+#define BACKLIGHT_WHEEL_DELAY 50 // ms to collect wheel steps
 #define LOW_BATTERY 5 // % over critical
 #define CRITICAL_BATTERY 10
+#define BATTERY_PREDICT_AHEAD 60 // secs, act before the next check
 #define AUTO_SLEEP_BATTERY 15
 #define DEFAULT_THEME "Adwaita"
 #define DEFAULT_AC_ICON "ac-adapter"
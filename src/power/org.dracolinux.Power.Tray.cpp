@@ -23,6 +23,7 @@
 #include "power_def.h"
 #include "draco.h"
 #include "keyboard_common.h"
+#include "lumina/LIconDiskCache.h"
 #include <QMessageBox>
 #include <QApplication>
 
@@ -69,6 +70,8 @@ SysTray::SysTray(QObject *parent)
     , notifyOnAC(true)
     , backlightMouseWheel(true)
     , ignoreKernelResume(false)
+    , backlightWheelDelta(0)
+    , backlightWheelTimer(nullptr)
 {
     // setup tray
     tray = new TrayIcon(this);
@@ -81,6 +84,15 @@ SysTray::SysTray(QObject *parent)
             this,
             SLOT(handleTrayWheel(TrayIcon::WheelAction)));
 
+    // collect wheel steps, send one adjustment
+    backlightWheelTimer = new QTimer(this);
+    backlightWheelTimer->setSingleShot(true);
+    backlightWheelTimer->setInterval(BACKLIGHT_WHEEL_DELAY);
+    connect(backlightWheelTimer,
+            SIGNAL(timeout()),
+            this,
+            SLOT(handleTrayWheelTimeout()));
+
     // setup manager
     man = new Power(this);
     connect(man,
@@ -184,6 +196,16 @@ SysTray::SysTray(QObject *parent)
             SIGNAL(timeout()),
             this,
             SLOT(timeout()));
+
+    // setup idle alarms (the timer only polls the idle time without them)
+    connect(Screens::instance(),
+            SIGNAL(idleReached(int)),
+            this,
+            SLOT(handleIdle(int)));
+    connect(Screens::instance(),
+            SIGNAL(idleReset()),
+            this,
+            SLOT(handleIdleReset()));
     timer->start();
 
     // check for config
@@ -196,7 +218,7 @@ SysTray::SysTray(QObject *parent)
         QIcon::setThemeName("Adwaita");
     }
     if (tray->icon().isNull()) {
-        tray->setIcon(QIcon::fromTheme(DEFAULT_BATTERY_ICON));
+        tray->setIcon(LIconDiskCache::icon(DEFAULT_BATTERY_ICON));
     }
 
     // load settings and register service
@@ -262,10 +284,11 @@ void SysTray::checkDevices()
     //qDebug() << "battery at" << batteryLeft;
     if (batteryLeft > 0 && man->HasBattery()) {
         tray->setToolTip(QString("%1 %2%").arg(tr("Battery at")).arg(batteryLeft));
-        if (man->TimeToEmpty()>0 && man->OnBattery()) {
+        qlonglong timeToEmpty = man->PredictedTimeToEmpty();
+        if (timeToEmpty>0 && man->OnBattery()) {
             tray->setToolTip(tray->toolTip()
                              .append(QString(", %1 %2")
-                             .arg(QDateTime::fromTime_t((uint)man->TimeToEmpty())
+                             .arg(QDateTime::fromTime_t((uint)timeToEmpty)
                                                         .toUTC().toString("hh:mm")))
                              .arg(tr("left")));
         }
@@ -308,14 +331,17 @@ void SysTray::checkDevices()
     // draw battery systray
     drawBattery(batteryLeft);
 
+    // where will the battery be at the next check?
+    double predictedLeft = man->PredictedBatteryLeft(BATTERY_PREDICT_AHEAD);
+
     // low battery?
-    handleLow(batteryLeft);
+    handleLow(predictedLeft);
 
     // very low battery?
-    handleVeryLow(batteryLeft);
+    handleVeryLow(predictedLeft);
 
     // critical battery?
-    handleCritical(batteryLeft);
+    handleCritical(predictedLeft);
 
     // Register service if not already registered
     if (!hasService) { registerService(); }
@@ -375,6 +401,8 @@ void SysTray::handleOpenedLid()
 // do something when switched to battery power
 void SysTray::handleOnBattery()
 {
+    setupIdle();
+
     if (notifyOnBattery) {
         showMessage(tr("On Battery"),
                     tr("Switched to battery power."));
@@ -393,7 +421,7 @@ void SysTray::handleOnBattery()
         /*if (hasBacklight) {
             Common::adjustBacklight(backlightDevice, backlightBatteryValue);
         } else {*/
-            man->setDisplayBacklight(backlightDevice, backlightBatteryValue);
+            man->fadeDisplayBacklight(backlightDevice, backlightBatteryValue);
         //}
     }
 }
@@ -401,6 +429,8 @@ void SysTray::handleOnBattery()
 // do something when switched to ac power
 void SysTray::handleOnAC()
 {
+    setupIdle();
+
     if (notifyOnAC) {
         showMessage(tr("On AC"),
                     tr("Switched to AC power."));
@@ -422,7 +452,7 @@ void SysTray::handleOnAC()
         /*if (hasBacklight) {
             Common::adjustBacklight(backlightDevice, backlightACValue);
         } else {*/
-            man->setDisplayBacklight(backlightDevice, backlightACValue);
+            man->fadeDisplayBacklight(backlightDevice, backlightACValue);
         //}
     }
 }
@@ -545,6 +575,9 @@ void SysTray::loadSettings()
 
     // keyboard
     KeyboardCommon::loadKeyboard();
+
+    // idle
+    setupIdle();
 }
 
 // register session services
@@ -615,6 +648,7 @@ void SysTray::registerService()
 void SysTray::handleHasInhibitChanged(bool has_inhibit)
 {
     if (has_inhibit) { resetTimer(); }
+    else { setupIdle(); }
 }
 
 void SysTray::handleLow(double left)
@@ -686,30 +720,30 @@ void SysTray::drawBattery(double left)
         QIcon::setThemeName("Adwaita");
     }
 
-    QIcon icon = QIcon::fromTheme(DEFAULT_AC_ICON);
+    QIcon icon = LIconDiskCache::icon(DEFAULT_AC_ICON);
     if (left <= 0 || !man->HasBattery()) {
         tray->setIcon(icon);
         return;
     }
 
     if (left <= 10) {
-        icon = QIcon::fromTheme(man->OnBattery()?DEFAULT_BATTERY_ICON_CRIT:DEFAULT_BATTERY_ICON_CRIT_AC);
+        icon = LIconDiskCache::icon(man->OnBattery()?DEFAULT_BATTERY_ICON_CRIT:DEFAULT_BATTERY_ICON_CRIT_AC);
     } else if (left <= 25) {
-        icon = QIcon::fromTheme(man->OnBattery()?DEFAULT_BATTERY_ICON_LOW:DEFAULT_BATTERY_ICON_LOW_AC);
+        icon = LIconDiskCache::icon(man->OnBattery()?DEFAULT_BATTERY_ICON_LOW:DEFAULT_BATTERY_ICON_LOW_AC);
     } else if (left <= 75) {
-        icon = QIcon::fromTheme(man->OnBattery()?DEFAULT_BATTERY_ICON_GOOD:DEFAULT_BATTERY_ICON_GOOD_AC);
+        icon = LIconDiskCache::icon(man->OnBattery()?DEFAULT_BATTERY_ICON_GOOD:DEFAULT_BATTERY_ICON_GOOD_AC);
     } else if (left <= 90) {
-        icon = QIcon::fromTheme(man->OnBattery()?DEFAULT_BATTERY_ICON_FULL:DEFAULT_BATTERY_ICON_FULL_AC);
+        icon = LIconDiskCache::icon(man->OnBattery()?DEFAULT_BATTERY_ICON_FULL:DEFAULT_BATTERY_ICON_FULL_AC);
     } else {
-        icon = QIcon::fromTheme(man->OnBattery()?DEFAULT_BATTERY_ICON_FULL:DEFAULT_BATTERY_ICON_CHARGED);
+        icon = LIconDiskCache::icon(man->OnBattery()?DEFAULT_BATTERY_ICON_FULL:DEFAULT_BATTERY_ICON_CHARGED);
         if (left >= 100 && !man->OnBattery()) {
-            icon = QIcon::fromTheme(DEFAULT_AC_ICON);
+            icon = LIconDiskCache::icon(DEFAULT_AC_ICON);
         }
     }
     tray->setIcon(icon);
 }
 
-// timeout, check if idle
+// timeout, check if idle (only used if there is no IDLETIME counter)
 // timeouts and xss must be >= user value and service has to be empty before suspend
 void SysTray::timeout()
 {
@@ -719,6 +753,8 @@ void SysTray::timeout()
         !tray->isVisible() &&
         showTray) { tray->show(); }
 
+    if (Screens::hasIdleCounter()) { return; } // handled by idle alarms
+
     int uIdle = xIdle();
 
     qDebug() << "timeout?" << timeouts << "idle?" << uIdle << "inhibit?" << pm->HasInhibit() << pmInhibitors << ssInhibitors;
@@ -742,39 +778,75 @@ void SysTray::timeout()
     if (!doSuspend) { timeouts++; }
     else {
         timeouts = 0;
-        qDebug() << "auto suspend activated" << autoSuspendAction;
-        switch (autoSuspendAction) {
-        case suspendSleep:
-            man->Suspend();
-            break;
-        case suspendHibernate:
-            man->Hibernate();
-            break;
-        case suspendShutdown:
-            man->PowerOff();
-            break;
-        case suspendHybrid:
-            man->HybridSleep();
-            break;
-        default: break;
-        }
+        doAutoSuspend(autoSuspendAction);
+    }
+}
+
+// run auto suspend action
+void SysTray::doAutoSuspend(int action)
+{
+    qDebug() << "auto suspend activated" << action;
+    switch (action) {
+    case suspendSleep:
+        man->Suspend();
+        break;
+    case suspendHibernate:
+        man->Hibernate();
+        break;
+    case suspendShutdown:
+        man->PowerOff();
+        break;
+    case suspendHybrid:
+        man->HybridSleep();
+        break;
+    default: break;
     }
 }
 
+// arm the idle alarm for the current power source
+void SysTray::setupIdle()
+{
+    if (!Screens::hasIdleCounter()) { return; }
+    int autoSuspend = man->OnBattery()?autoSuspendBattery:autoSuspendAC;
+    QList<int> thresholds;
+    if (autoSuspend>0) { thresholds << autoSuspend*60; }
+    // already past the threshold? then wait a full period from now,
+    // the offset only lasts until the next user activity
+    long offset = 0;
+    long idle = Screens::idle();
+    if (autoSuspend>0 && idle>=(long)autoSuspend*60*1000) { offset = idle; }
+    Screens::instance()->setIdleThresholds(thresholds, offset);
+}
+
+// idle threshold reached
+void SysTray::handleIdle(int seconds)
+{
+    qDebug() << "idle?" << seconds << "inhibit?" << pm->HasInhibit() << pmInhibitors << ssInhibitors;
+    if (pm->HasInhibit()) { return; } // re-armed when the inhibit is released
+    int autoSuspend = 0;
+    int autoSuspendAction = suspendNone;
+    if (man->OnBattery()) {
+        autoSuspend = autoSuspendBattery;
+        autoSuspendAction = autoSuspendBatteryAction;
+    }
+    else {
+        autoSuspend = autoSuspendAC;
+        autoSuspendAction = autoSuspendACAction;
+    }
+    if (autoSuspend<=0 || seconds<autoSuspend*60) { return; }
+    doAutoSuspend(autoSuspendAction);
+}
+
+// user activity after idle
+void SysTray::handleIdleReset()
+{
+    resetTimer();
+}
+
 // get user idle time
 int SysTray::xIdle()
 {
-    long idle = 0;
-    Display *display = XOpenDisplay(0);
-    if (display != 0) {
-        XScreenSaverInfo *info = XScreenSaverAllocInfo();
-        XScreenSaverQueryInfo(display, DefaultRootWindow(display), info);
-        if (info) {
-            idle = info->idle;
-            XFree(info);
-        }
-    }
-    XCloseDisplay(display);
+    long idle = Screens::idle();
     int minutes = (idle-(1000*60))/(1000*60);
     return minutes;
 }
@@ -989,14 +1061,20 @@ void SysTray::handleTrayWheel(TrayIcon::WheelAction action)
     if (backlightDevice.isEmpty() || !backlightMouseWheel) { return; }
     switch (action) {
     case TrayIcon::WheelUp:
-        man->setDisplayBacklight(backlightDevice,
-                                 PowerBacklight::getCurrentBrightness(backlightDevice)+BACKLIGHT_MOVE_VALUE);
+        backlightWheelDelta += BACKLIGHT_MOVE_VALUE;
         break;
     case TrayIcon::WheelDown:
-        man->setDisplayBacklight(backlightDevice,
-                                 PowerBacklight::getCurrentBrightness(backlightDevice)-BACKLIGHT_MOVE_VALUE);
+        backlightWheelDelta -= BACKLIGHT_MOVE_VALUE;
         break;
     }
+    if (!backlightWheelTimer->isActive()) { backlightWheelTimer->start(); }
+}
+
+void SysTray::handleTrayWheelTimeout()
+{
+    if (backlightWheelDelta == 0) { return; }
+    man->adjustDisplayBacklight(backlightDevice, backlightWheelDelta);
+    backlightWheelDelta = 0;
 }
 
 // check devices if changed
@@ -43,19 +43,6 @@
 #include "org.dracolinux.Power.ScreenX11.h"
 #include "org.dracolinux.Power.Manager.h"
 
-#include <X11/extensions/scrnsaver.h>
-#undef CursorShape
-#undef Bool
-#undef None
-#undef KeyPress
-#undef KeyRelease
-#undef FocusIn
-#undef FocusOut
-#undef FontChange
-#undef Expose
-#undef FrameFeature
-#undef Unsorted
-
 #define XSCREENSAVER_RUN "xscreensaver -no-splash"
 
 #define DEVICE_UUID Qt::UserRole+1
@@ -135,6 +122,8 @@ private:
     bool notifyOnAC;
     bool backlightMouseWheel;
     bool ignoreKernelResume;
+    int backlightWheelDelta;
+    QTimer *backlightWheelTimer;
 
 private slots:
     void trayActivated(QSystemTrayIcon::ActivationReason reason);
@@ -151,6 +140,10 @@ private slots:
     void handleCritical(double left);
     void drawBattery(double left);
     void timeout();
+    void doAutoSuspend(int action);
+    void setupIdle();
+    void handleIdle(int seconds);
+    void handleIdleReset();
     int xIdle();
     void resetTimer();
     void setInternalMonitor();
@@ -175,6 +168,7 @@ private slots:
     void handlePrepareForResume();
     void switchInternalMonitor(bool toggle);
     void handleTrayWheel(TrayIcon::WheelAction action);
+    void handleTrayWheelTimeout();
     void handleDeviceChanged(const QString &path);
 };
 
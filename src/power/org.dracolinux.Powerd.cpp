@@ -43,6 +43,12 @@ int main(int argc, char *argv[])
     qDebug() << "Registered service" << Draco::powerdSessionName();
 
     Manager man;
+    // point the backends at a fake tree (for testing)
+    QString sysRoot = qgetenv("POWERD_SYSFS_ROOT");
+    if (!sysRoot.isEmpty()) { man.setSysRoot(sysRoot); }
+    QString procRoot = qgetenv("POWERD_PROCFS_ROOT");
+    if (!procRoot.isEmpty()) { man.setProcRoot(procRoot); }
+
     if (!QDBusConnection::systemBus().registerObject(Draco::powerdSessionPath(),
                                                      &man,
                                                      QDBusConnection::ExportAllContents)) {
@@ -5,7 +5,7 @@
 //  See the LICENSE file for full details
 //===========================================
 #include "ScreenSettings.h"
-#include <LUtils.h>
+#include <LuminaRandR.h>
 #include <QDebug>
 #include <QSettings>
 #include "draco.h"
@@ -19,7 +19,7 @@ void RRSettings::ApplyPrevious(){
   QString profile = set.value("default_profile","").toString();
   if(profile.isEmpty() || !savedProfiles().contains(profile) ){ screens = PreviousSettings(); }
   else{ screens = PreviousSettings(profile); }
-  //Now reset the display with xrandr
+  //Now reset the display
   RRSettings::Apply(screens);
 }
 
@@ -69,65 +69,41 @@ void RRSettings::MirrorAll(){
     screens[i].rotation = 0;
     if(!screens[i].isactive){ screens[i].applyChange = 2; } //activate it
   }
-  //Now reset the display with xrandr
+  //Now reset the display
   RRSettings::Apply(screens);
 }
 
-//Read the current screen config from xrandr
+//Read the current screen config from RandR
 QList<ScreenInfo> RRSettings::CurrentScreens(){
   QList<ScreenInfo> SCREENS;
-  QStringList info = LUtils::getCmdOutput("xrandr -q");
-  ScreenInfo cscreen;
-  for(int i=0; i<info.length(); i++){
-    if(info[i].contains("connected") ){
-      //qDebug() << "xrandr info:" << info[i];
-      if(!cscreen.ID.isEmpty()){
-	SCREENS << cscreen; //current screen finished - save it into the array
-	cscreen = ScreenInfo(); //Now create a new structure
-      }
-      //qDebug() << "Line:" << info[i];
-      QString dev = info[i].section(" ",0,0); //device ID
-      //The device resolution can be either the 3rd or 4th output - check both
-      QString devres = info[i].section(" ",2,2, QString::SectionSkipEmpty);
-      if(!devres.contains("x")){ devres = info[i].section(" ",3,3,QString::SectionSkipEmpty); }
-      if(!devres.contains("x")){ devres.clear(); }
-      //Pull the monitor rotation mode out as well (last word before the parenthesis)
-      QString devrotate = info[i].section("(",0,0).split(" ",QString::SkipEmptyParts).last();
-      //qDebug() << " - ID:" <<dev << "Current Geometry:" << devres;
-      //qDebug() << " - Res:" << devres;
-      if( !devres.contains("x") || !devres.contains("+") ){ devres.clear(); }
-      //qDebug() << " - Res (modified):" << devres;
-      if(info[i].contains(" disconnected ") && !devres.isEmpty() ){
-        //Device disconnected, but still active on X
-	cscreen.isavailable = false;
-        cscreen.isactive = true;
-     }else if( !devres.isEmpty() ){
-        cscreen.isprimary = info[i].contains(" primary ");
-	//Device that is connected and attached (has a resolution)
-	//qDebug() << "Create new Screen entry:" << dev << devres << devrotate << info[i].section("(",0,0);
-	cscreen.ID = dev;
-	//Note: devres format: "<width>x<height>+<xoffset>+<yoffset>"
-	cscreen.geom.setRect( devres.section("+",-2,-2).toInt(), devres.section("+",-1,-1).toInt(), devres.section("x",0,0).toInt(), devres.section("+",0,0).section("x",1,1).toInt() ); 
-	cscreen.isavailable = true;
-        cscreen.isactive = true;
-        if(devrotate=="left"){ cscreen.rotation = -90; }
-        else if(devrotate=="right"){ cscreen.rotation = 90; }
-        else if(devrotate=="inverted"){ cscreen.rotation = 180; }
-        else{ cscreen.rotation = 0; }
-      }else if(info[i].contains(" connected")){
-        //Device that is connected, but not attached
-	//qDebug() << "Create new Screen entry:" << dev << "none";
-	cscreen.ID = dev;
-	//cscreen.order = -2; //flag this right now as a non-active screen
-        cscreen.isavailable = true;
-        cscreen.isactive = false;
-      }
-    }else if( !cscreen.ID.isEmpty() && info[i].section("\t",0,0,QString::SectionSkipEmpty).contains("x")){
-      //available resolution for a device
-      cscreen.resList << info[i].section("\t",0,0,QString::SectionSkipEmpty);
+  OutputDeviceList devs; //all outputs/crtcs are loaded with a single batch of requests
+  for(int i=0; i<devs.length(); i++){
+    OutputDevice *dev = devs.at(i);
+    if(!dev->isConnected() && !dev->isEnabled()){ continue; } //nothing attached to this output
+    ScreenInfo cscreen;
+    cscreen.ID = dev->ID();
+    cscreen.isavailable = dev->isConnected(); //disconnected, but still active on X otherwise
+    cscreen.isactive = dev->isEnabled();
+    if(cscreen.isactive){
+      cscreen.geom = dev->currentGeometry();
+      cscreen.rotation = dev->currentRotation();
+      cscreen.isprimary = dev->isPrimary() && cscreen.isavailable;
     }
-  } //end loop over primary info lines
-  if(!cscreen.ID.isEmpty()){ SCREENS << cscreen; } //make sure to add the last screen to the array
+    //Available resolutions: "<width>x<height>" with "*" for the current one and "+" for the preferred one
+    QSize current = dev->currentResolution();
+    if(cscreen.rotation==90 || cscreen.rotation==-90){ current.transpose(); }
+    QSize preferred = dev->preferredResolution();
+    QList<QSize> res = dev->availableResolutions();
+    for(int r=0; r<res.length(); r++){
+      QString flags;
+      if(cscreen.isactive && res[r]==current){ flags.append("*"); }
+      if(res[r]==preferred){ flags.append("+"); }
+      QString entry = QString::number(res[r].width())+"x"+QString::number(res[r].height());
+      if(!flags.isEmpty()){ entry.append(" "+flags); }
+      cscreen.resList << entry;
+    }
+    SCREENS << cscreen;
+  }
   return SCREENS;
 }
 
@@ -231,23 +207,20 @@ void RRSettings::Apply(QList<ScreenInfo> screens){
     else{ foundactive = (screens[i].applyChange==2); }
   }
   if(!foundactive){ return; } //never disable all screens
-  //Read all the settings and create the xrandr options to maintain these settings
-  QStringList opts;
-  //qDebug() << "Apply:" << screens.length();
+  //Convert the settings into a layout which gets applied as a single RandR change
+  QList<output_config> layout;
   for(int i=0; i<screens.length(); i++){
     qDebug() << " -- Screen:" << i << screens[i].ID << screens[i].isactive;
-    if( !screens[i].isactive){ continue; } //skip this screen - non-active
-    else if(screens[i].applyChange==1){ opts << "--output" << screens[i].ID << "--off"; continue; } //deactivate a screen
-    opts << "--output" << screens[i].ID;
-    if(screens[i].applyChange==2){ opts << "--auto"; }
-    else{ opts << "--mode" << QString::number(screens[i].geom.width())+"x"+QString::number(screens[i].geom.height()); }
-    opts << "--pos" << QString::number(screens[i].geom.x())+"x"+QString::number(screens[i].geom.y());
-      if(screens[i].rotation==-90){ opts << "--rotate" << "left"; }
-      else if(screens[i].rotation==90){ opts << "--rotate" << "right"; }
-      else if(screens[i].rotation==180){ opts << "--rotate" << "inverted"; }
-      else{ opts << "--rotate" << "normal"; }
-    if(screens[i].isprimary){ opts << "--primary"; }
+    bool enable = (screens[i].applyChange==2) || (screens[i].isactive && screens[i].applyChange!=1);
+    if( !screens[i].isactive && !enable){ continue; } //skip this screen - non-active
+    output_config cfg;
+    cfg.id = screens[i].ID;
+    cfg.enabled = enable;
+    cfg.geometry = screens[i].geom;
+    cfg.rotation = screens[i].rotation;
+    cfg.primary = screens[i].isprimary;
+    layout << cfg;
   }
-  qDebug() << "Run command: xrandr" << opts;
-  LUtils::runCmd("xrandr", opts);
+  OutputDeviceList devs(false); //the screens were just read - no need to probe the hardware again
+  if(!devs.applyLayout(layout)){ qDebug() << "[ERROR] Could not apply the screen configuration"; }
 }
@@ -43,8 +43,8 @@ public:
 	//Setup all the connected monitors as a single mirror
 	static void MirrorAll();
 
-	//Read the current screen config from xrandr
-	static QList<ScreenInfo> CurrentScreens(); //reads xrandr information
+	//Read the current screen config from RandR
+	static QList<ScreenInfo> CurrentScreens();
 	static QList<ScreenInfo> PreviousSettings(QString profile="");
 	static QStringList savedProfiles();
 	static void removeProfile(QString profile);
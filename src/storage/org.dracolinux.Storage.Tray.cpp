@@ -23,6 +23,7 @@
 #include "LuminaXDG.h"
 #include "XDGMime.h"
 #include "LUtils.h"
+#include "LIconDiskCache.h"
 
 #include <QIcon>
 #include <QProcess>
@@ -47,7 +48,7 @@ SysTray::SysTray(QObject *parent)
 
     menu = new QMenu();
 
-    disktray = new QSystemTrayIcon(QIcon::fromTheme("drive-removable-media"),
+    disktray = new QSystemTrayIcon(LIconDiskCache::icon("drive-removable-media"),
                                    this);
     disktray->setToolTip(tr("Removable Devices"));
 
@@ -130,12 +131,12 @@ void SysTray::generateContextMenu()
         menu->addAction(deviceAction);
 
         if (device.value()->mountpoint.isEmpty()) {
-            deviceAction->setIcon(QIcon::fromTheme(device.value()->isOptical?"drive-optical":"drive-removable-media"));
+            deviceAction->setIcon(LIconDiskCache::icon(device.value()->isOptical?"drive-optical":"drive-removable-media"));
             bool hasAudio = device.value()->opticalAudioTracks>0?true:false;
             bool hasData = device.value()->opticalDataTracks>0?true:false;
             if (device.value()->isBlankDisc ||
-                (hasAudio && !hasData)) { deviceAction->setIcon(QIcon::fromTheme("media-eject")); }
-        } else { deviceAction->setIcon(QIcon::fromTheme("media-eject")); }
+                (hasAudio && !hasData)) { deviceAction->setIcon(LIconDiskCache::icon("media-eject")); }
+        } else { deviceAction->setIcon(LIconDiskCache::icon("media-eject")); }
     }
 
     qDebug() << menu->actions();
@@ -0,0 +1,133 @@
+/*
+#
+# Draco Desktop Environment <https://dracolinux.org>
+# Copyright (c) 2019, Ole-André Rodlie <ole.andre.rodlie@gmail.com>
+# All rights reserved.
+#
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser Public License as published by
+* the Free Software Foundation; either version 2.1 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>
+#
+*/
+
+#include <QtTest>
+#include <QTemporaryDir>
+
+#include "fakesysfs.h"
+#include "org.dracolinux.Powerd.Manager.CPU.h"
+#include "org.dracolinux.Powerd.Manager.Backlight.h"
+
+// cost of the cpufreq and backlight paths as the cpu count grows,
+// run with -tickcounter or -iterations N for steadier numbers
+class BenchPowerd : public QObject
+{
+    Q_OBJECT
+
+private:
+    QTemporaryDir *dir;
+    FakeSysfs *tree;
+
+    void createTree(int cpus)
+    {
+        delete tree;
+        delete dir;
+        dir = new QTemporaryDir();
+        QVERIFY(dir->isValid());
+        tree = new FakeSysfs(dir->path());
+        QVERIFY(tree->addCpus(cpus));
+        QVERIFY(tree->addBacklight("intel_backlight", 1000, 500));
+        PowerCpu::setSysRoot(tree->sysRoot());
+        PowerBacklight::setSysRoot(tree->sysRoot());
+    }
+
+    void cpuData()
+    {
+        QTest::addColumn<int>("cpus");
+        QTest::newRow("4") << 4;
+        QTest::newRow("16") << 16;
+        QTest::newRow("64") << 64;
+        QTest::newRow("256") << 256;
+    }
+
+private slots:
+    void initTestCase()
+    {
+        dir = nullptr;
+        tree = nullptr;
+    }
+
+    void cleanupTestCase()
+    {
+        delete tree;
+        delete dir;
+    }
+
+    void refresh_data() { cpuData(); }
+    void refresh()
+    {
+        QFETCH(int, cpus);
+        createTree(cpus);
+        QBENCHMARK { PowerCpu::refresh(); }
+        QCOMPARE(PowerCpu::getTotal(), cpus);
+    }
+
+    void getGovernors_data() { cpuData(); }
+    void getGovernors()
+    {
+        QFETCH(int, cpus);
+        createTree(cpus);
+        QBENCHMARK { PowerCpu::getGovernors(); }
+        QCOMPARE(PowerCpu::getGovernors().size(), cpus);
+    }
+
+    void setGovernor_data() { cpuData(); }
+    void setGovernor()
+    {
+        QFETCH(int, cpus);
+        createTree(cpus);
+        bool performance = false;
+        QBENCHMARK {
+            performance = !performance;
+            PowerCpu::setGovernor(performance?"performance":"powersave");
+        }
+    }
+
+    void setFrequency_data() { cpuData(); }
+    void setFrequency()
+    {
+        QFETCH(int, cpus);
+        createTree(cpus);
+        bool high = false;
+        bool ok = true;
+        QBENCHMARK {
+            high = !high;
+            ok = PowerCpu::setFrequency(high?"2400000":"800000") && ok;
+        }
+        QVERIFY(ok);
+    }
+
+    void setBacklight_data() { cpuData(); }
+    void setBacklight()
+    {
+        QFETCH(int, cpus);
+        createTree(cpus);
+        QString device = PowerBacklight::getDevice();
+        int value = 0;
+        QBENCHMARK {
+            value = (value+10)%1000;
+            PowerBacklight::setCurrentBrightness(device, value);
+        }
+    }
+};
+
+QTEST_GUILESS_MAIN(BenchPowerd)
+#include "bench_powerd.moc"
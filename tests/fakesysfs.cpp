@@ -0,0 +1,174 @@
+/*
+#
+# Draco Desktop Environment <https://dracolinux.org>
+# Copyright (c) 2019, Ole-André Rodlie <ole.andre.rodlie@gmail.com>
+# All rights reserved.
+#
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser Public License as published by
+* the Free Software Foundation; either version 2.1 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>
+#
+*/
+
+#include "fakesysfs.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+#define FAKE_CPU "sys/devices/system/cpu"
+#define FAKE_GOVERNORS "performance powersave userspace"
+#define FAKE_FREQUENCIES "800000 1600000 2400000"
+#define FAKE_FREQ_MIN 800000
+#define FAKE_FREQ_MAX 2400000
+#define FAKE_PREFERENCES "default performance balance_performance balance_power power"
+
+static const QString cpuRange(int first, int last)
+{
+    if (first == last) { return QString::number(first); }
+    return QString("%1-%2").arg(first).arg(last);
+}
+
+FakeSysfs::FakeSysfs(const QString &root)
+    : _root(root)
+{
+    QDir().mkpath(sysRoot());
+    QDir().mkpath(procRoot());
+}
+
+const QString FakeSysfs::sysRoot()
+{
+    return QString("%1/sys").arg(_root);
+}
+
+const QString FakeSysfs::procRoot()
+{
+    return QString("%1/proc").arg(_root);
+}
+
+const QString FakeSysfs::read(const QString &path)
+{
+    QString result;
+    QFile file(QString("%1/%2").arg(_root).arg(path));
+    if (file.open(QIODevice::ReadOnly|QIODevice::Text)) {
+        result = file.readAll().trimmed();
+        file.close();
+    }
+    return result;
+}
+
+bool FakeSysfs::write(const QString &path, const QString &value)
+{
+    QFileInfo info(QString("%1/%2").arg(_root).arg(path));
+    if (!QDir().mkpath(info.absolutePath())) { return false; }
+    QFile file(info.absoluteFilePath());
+    if (!file.open(QIODevice::WriteOnly|QIODevice::Truncate)) { return false; }
+    bool result = file.write(value.toUtf8()+"\n")>0;
+    file.close();
+    return result;
+}
+
+bool FakeSysfs::addCpus(int cpus, int cpusPerPolicy, bool pstate)
+{
+    if (cpus<1 || cpusPerPolicy<1) { return false; }
+    QString all = cpuRange(0, cpus-1);
+    bool ok = write(QString("%1/possible").arg(FAKE_CPU), all) &&
+              write(QString("%1/present").arg(FAKE_CPU), all) &&
+              write(QString("%1/online").arg(FAKE_CPU), all);
+
+    for (int first=0;ok && first<cpus;first+=cpusPerPolicy) {
+        int last = qMin(first+cpusPerPolicy, cpus)-1;
+        QString policy = QString("%1/cpufreq/policy%2").arg(FAKE_CPU).arg(first);
+        QString range = cpuRange(first, last);
+        ok = write(QString("%1/related_cpus").arg(policy), range) &&
+             write(QString("%1/affected_cpus").arg(policy), range) &&
+             write(QString("%1/scaling_available_governors").arg(policy), FAKE_GOVERNORS) &&
+             write(QString("%1/scaling_governor").arg(policy), "powersave") &&
+             write(QString("%1/scaling_available_frequencies").arg(policy), FAKE_FREQUENCIES) &&
+             write(QString("%1/scaling_setspeed").arg(policy), QString::number(FAKE_FREQ_MIN)) &&
+             write(QString("%1/scaling_min_freq").arg(policy), QString::number(FAKE_FREQ_MIN)) &&
+             write(QString("%1/scaling_max_freq").arg(policy), QString::number(FAKE_FREQ_MAX)) &&
+             write(QString("%1/cpuinfo_min_freq").arg(policy), QString::number(FAKE_FREQ_MIN)) &&
+             write(QString("%1/cpuinfo_max_freq").arg(policy), QString::number(FAKE_FREQ_MAX)) &&
+             write(QString("%1/energy_performance_available_preferences").arg(policy), FAKE_PREFERENCES) &&
+             write(QString("%1/energy_performance_preference").arg(policy), "balance_performance");
+        // there is no kernel behind the tree, so scaling_cur_freq
+        // mirrors whatever was written to scaling_setspeed
+        ok = ok && QFile::link(QString("%1/%2/scaling_setspeed").arg(_root).arg(policy),
+                               QString("%1/%2/scaling_cur_freq").arg(_root).arg(policy));
+        // cpuN/cpufreq is a link to its policy, like on a real system
+        for (int cpu=first;ok && cpu<=last;++cpu) {
+            QString dir = QString("%1/%2/cpu%3").arg(_root).arg(FAKE_CPU).arg(cpu);
+            ok = QDir().mkpath(dir) &&
+                 QFile::link(QString("%1/%2").arg(_root).arg(policy),
+                             QString("%1/cpufreq").arg(dir));
+        }
+    }
+    if (ok && pstate) {
+        QString dir = QString("%1/intel_pstate").arg(FAKE_CPU);
+        ok = write(QString("%1/status").arg(dir), "active") &&
+             write(QString("%1/no_turbo").arg(dir), "0") &&
+             write(QString("%1/max_perf_pct").arg(dir), "100") &&
+             write(QString("%1/min_perf_pct").arg(dir), "10");
+    }
+    return ok;
+}
+
+bool FakeSysfs::setOnline(const QString &range)
+{
+    return write(QString("%1/online").arg(FAKE_CPU), range);
+}
+
+bool FakeSysfs::addBacklight(const QString &name, int max, int value)
+{
+    QString dir = QString("sys/class/backlight/%1").arg(name);
+    return write(QString("%1/max_brightness").arg(dir), QString::number(max)) &&
+           write(QString("%1/brightness").arg(dir), QString::number(value)) &&
+           write(QString("%1/actual_brightness").arg(dir), QString::number(value));
+}
+
+bool FakeSysfs::addBattery(const QString &name, double energy, double full)
+{
+    // values in µWh, like the kernel
+    QString dir = QString("sys/class/power_supply/%1").arg(name);
+    return write(QString("%1/type").arg(dir), "Battery") &&
+           write(QString("%1/present").arg(dir), "1") &&
+           write(QString("%1/status").arg(dir), "Discharging") &&
+           write(QString("%1/energy_now").arg(dir), QString::number(qRound64(energy*1000000))) &&
+           write(QString("%1/energy_full").arg(dir), QString::number(qRound64(full*1000000)));
+}
+
+bool FakeSysfs::addMains(const QString &name, bool online)
+{
+    QString dir = QString("sys/class/power_supply/%1").arg(name);
+    return write(QString("%1/type").arg(dir), "Mains") &&
+           write(QString("%1/online").arg(dir), online?"1":"0");
+}
+
+bool FakeSysfs::addRtc()
+{
+    return write("sys/class/rtc/rtc0/wakealarm", "");
+}
+
+bool FakeSysfs::setStat(qulonglong busy, qulonglong idle)
+{
+    // cpu  user nice system idle iowait irq softirq steal guest guest_nice
+    return write("proc/stat", QString("cpu  %1 0 0 %2 0 0 0 0 0 0").arg(busy).arg(idle));
+}
+
+bool FakeSysfs::setPressure(double avg10)
+{
+    return write("proc/pressure/cpu",
+                 QString("some avg10=%1 avg60=0.00 avg300=0.00 total=0\n"
+                         "full avg10=0.00 avg60=0.00 avg300=0.00 total=0")
+                 .arg(avg10, 0, 'f', 2));
+}
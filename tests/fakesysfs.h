@@ -0,0 +1,53 @@
+/*
+#
+# Draco Desktop Environment <https://dracolinux.org>
+# Copyright (c) 2019, Ole-André Rodlie <ole.andre.rodlie@gmail.com>
+# All rights reserved.
+#
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser Public License as published by
+* the Free Software Foundation; either version 2.1 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>
+#
+*/
+
+#ifndef FAKESYSFS_H
+#define FAKESYSFS_H
+
+#include <QString>
+
+// generates a minimal sysfs/procfs tree for the powerd backends,
+// point PowerCpu/PowerBacklight/PowerPolicy (or powerd through
+// POWERD_SYSFS_ROOT and POWERD_PROCFS_ROOT) at sysRoot()/procRoot().
+class FakeSysfs
+{
+public:
+    explicit FakeSysfs(const QString &root);
+    const QString sysRoot();
+    const QString procRoot();
+
+    bool addCpus(int cpus, int cpusPerPolicy = 1, bool pstate = true);
+    bool setOnline(const QString &range);
+    bool addBacklight(const QString &name, int max, int value);
+    bool addBattery(const QString &name, double energy, double full);
+    bool addMains(const QString &name, bool online);
+    bool addRtc();
+    bool setStat(qulonglong busy, qulonglong idle);
+    bool setPressure(double avg10);
+
+    const QString read(const QString &path);
+    bool write(const QString &path, const QString &value);
+
+private:
+    QString _root;
+};
+
+#endif // FAKESYSFS_H
@@ -0,0 +1,57 @@
+/*
+#
+# Draco Desktop Environment <https://dracolinux.org>
+# Copyright (c) 2019, Ole-André Rodlie <ole.andre.rodlie@gmail.com>
+# All rights reserved.
+#
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser Public License as published by
+* the Free Software Foundation; either version 2.1 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>
+#
+*/
+
+#include "fakesysfs.h"
+
+#include <QCoreApplication>
+#include <QStringList>
+#include <QTextStream>
+
+// draco-fake-sysfs <dir> [cpus] [cpus per policy]
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QStringList args = a.arguments();
+    QTextStream out(stdout);
+    if (args.size()<2) {
+        out << "usage: " << args.first() << " <dir> [cpus] [cpus per policy]\n";
+        return 1;
+    }
+    int cpus = args.size()>2?args.at(2).toInt():4;
+    int perPolicy = args.size()>3?args.at(3).toInt():1;
+
+    FakeSysfs tree(args.at(1));
+    if (!tree.addCpus(cpus, perPolicy) ||
+        !tree.addBacklight("intel_backlight", 1000, 500) ||
+        !tree.addBacklight("acpi_video0", 15, 7) ||
+        !tree.addBattery("BAT0", 40, 50) ||
+        !tree.addBattery("BAT1", 20, 25) ||
+        !tree.addMains("AC", true) ||
+        !tree.addRtc() ||
+        !tree.setStat(1000, 9000) ||
+        !tree.setPressure(0)) {
+        out << "failed to create tree in " << args.at(1) << "\n";
+        return 1;
+    }
+    out << "POWERD_SYSFS_ROOT=" << tree.sysRoot() << "\n";
+    out << "POWERD_PROCFS_ROOT=" << tree.procRoot() << "\n";
+    return 0;
+}
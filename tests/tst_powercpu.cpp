@@ -0,0 +1,171 @@
+/*
+#
+# Draco Desktop Environment <https://dracolinux.org>
+# Copyright (c) 2019, Ole-André Rodlie <ole.andre.rodlie@gmail.com>
+# All rights reserved.
+#
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser Public License as published by
+* the Free Software Foundation; either version 2.1 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>
+#
+*/
+
+#include <QtTest>
+#include <QTemporaryDir>
+
+#include "fakesysfs.h"
+#include "org.dracolinux.Powerd.Manager.CPU.h"
+#include "org.dracolinux.Powerd.Manager.Backlight.h"
+
+#define CPU_POLICY "sys/devices/system/cpu/cpufreq/policy%1/%2"
+
+class TestPowerCpu : public QObject
+{
+    Q_OBJECT
+
+private:
+    QTemporaryDir *dir;
+    FakeSysfs *tree;
+
+private slots:
+    void init()
+    {
+        dir = new QTemporaryDir();
+        QVERIFY(dir->isValid());
+        tree = new FakeSysfs(dir->path());
+        QVERIFY(tree->addCpus(8, 2));
+        PowerCpu::setSysRoot(tree->sysRoot());
+        PowerBacklight::setSysRoot(tree->sysRoot());
+    }
+
+    void cleanup()
+    {
+        delete tree;
+        delete dir;
+    }
+
+    void topology()
+    {
+        QCOMPARE(PowerCpu::getTotal(), 8);
+        QCOMPARE(PowerCpu::getOnline().size(), 8);
+        QList<cpu_policy> policies = PowerCpu::getPolicies();
+        QCOMPARE(policies.size(), 4);
+        QCOMPARE(policies.at(1).cpus, QList<int>() << 2 << 3);
+        QCOMPARE(policies.at(1).governors, QString("performance powersave userspace").split(" "));
+        QCOMPARE(policies.at(1).minFreq, 800000);
+        QCOMPARE(policies.at(1).maxFreq, 2400000);
+    }
+
+    void parseRanges()
+    {
+        QVERIFY(tree->setOnline("0-2,4-5,7"));
+        QCOMPARE(PowerCpu::getOnline(), QList<int>() << 0 << 1 << 2 << 4 << 5 << 7);
+        QVERIFY(tree->setOnline("3"));
+        QCOMPARE(PowerCpu::getOnline(), QList<int>() << 3);
+        QVERIFY(tree->setOnline("junk,1"));
+        QCOMPARE(PowerCpu::getOnline(), QList<int>() << 1);
+    }
+
+    void governors()
+    {
+        QCOMPARE(PowerCpu::getGovernor(5), QString("powersave"));
+        QVERIFY(PowerCpu::setGovernor("performance"));
+        for (int i=0;i<8;i+=2) {
+            QCOMPARE(tree->read(QString(CPU_POLICY).arg(i).arg("scaling_governor")),
+                     QString("performance"));
+        }
+        QCOMPARE(PowerCpu::getGovernors().size(), 4);
+        QVERIFY(!PowerCpu::setGovernor("ondemand"));
+        QVERIFY(PowerCpu::setGovernor("userspace", 3));
+        QCOMPARE(PowerCpu::getGovernor(2), QString("userspace"));
+        QCOMPARE(PowerCpu::getGovernor(4), QString("performance"));
+    }
+
+    void frequencies()
+    {
+        QCOMPARE(PowerCpu::getFrequency(3), QString("800000"));
+        QVERIFY(PowerCpu::setFrequency("1600000"));
+        for (int i=0;i<8;i+=2) {
+            QCOMPARE(tree->read(QString(CPU_POLICY).arg(i).arg("scaling_governor")),
+                     QString("userspace"));
+            QCOMPARE(tree->read(QString(CPU_POLICY).arg(i).arg("scaling_cur_freq")),
+                     QString("1600000"));
+        }
+        QCOMPARE(PowerCpu::getFrequencies().size(), 4);
+        QVERIFY(!PowerCpu::setFrequency("1000000"));
+        QVERIFY(PowerCpu::setFrequency("2400000", 5));
+        QCOMPARE(PowerCpu::getFrequency(4), QString("2400000"));
+        QCOMPARE(PowerCpu::getFrequency(6), QString("1600000"));
+    }
+
+    void hotplug()
+    {
+        QCOMPARE(PowerCpu::getGovernors().size(), 4);
+        // take the last policy offline
+        QVERIFY(tree->write(QString(CPU_POLICY).arg(6).arg("affected_cpus"), ""));
+        QVERIFY(tree->setOnline("0-5"));
+        QCOMPARE(PowerCpu::getOnline().size(), 6);
+        QCOMPARE(PowerCpu::getGovernors().size(), 3);
+        QVERIFY(PowerCpu::setGovernor("performance"));
+        QCOMPARE(tree->read(QString(CPU_POLICY).arg(6).arg("scaling_governor")),
+                 QString("powersave"));
+    }
+
+    void preferences()
+    {
+        cpu_policy policy = PowerCpu::getPolicies().at(0);
+        QVERIFY(PowerCpu::setPreference(policy, "power"));
+        QCOMPARE(PowerCpu::getPreference(policy), QString("power"));
+        QVERIFY(!PowerCpu::setPreference(policy, "bogus"));
+        QCOMPARE(PowerCpu::getPreference(policy), QString("power"));
+    }
+
+    void maxPerf()
+    {
+        cpu_policy policy = PowerCpu::getPolicies().at(0);
+        QVERIFY(PowerCpu::setMaxPerf(policy, 50));
+        QCOMPARE(tree->read(QString(CPU_POLICY).arg(0).arg("scaling_max_freq")),
+                 QString("1200000"));
+        QVERIFY(PowerCpu::setMaxPerf(policy, 10)); // clamped to cpuinfo_min_freq
+        QCOMPARE(tree->read(QString(CPU_POLICY).arg(0).arg("scaling_max_freq")),
+                 QString("800000"));
+        QVERIFY(PowerCpu::setMaxPerf(policy, 150));
+        QCOMPARE(tree->read(QString(CPU_POLICY).arg(0).arg("scaling_max_freq")),
+                 QString("2400000"));
+    }
+
+    void pstate()
+    {
+        QVERIFY(PowerCpu::hasPState());
+        QVERIFY(PowerCpu::hasTurbo());
+        QVERIFY(PowerCpu::setTurbo(false));
+        QCOMPARE(tree->read("sys/devices/system/cpu/intel_pstate/no_turbo"), QString("1"));
+        QVERIFY(!PowerCpu::hasTurbo());
+        QVERIFY(PowerCpu::setPStateMax(80));
+        QCOMPARE(PowerCpu::getPStateMax(), 80);
+        QVERIFY(!PowerCpu::setPStateMin(101));
+        QCOMPARE(PowerCpu::getPStateMin(), 10);
+    }
+
+    void backlight()
+    {
+        QVERIFY(tree->addBacklight("intel_backlight", 1000, 500));
+        QString device = PowerBacklight::getDevice();
+        QVERIFY(device.endsWith("intel_backlight"));
+        QCOMPARE(PowerBacklight::getMaxBrightness(device), 1000);
+        QVERIFY(PowerBacklight::setCurrentBrightness(device, 250));
+        QCOMPARE(PowerBacklight::getCurrentBrightness(device), 250);
+    }
+};
+
+QTEST_GUILESS_MAIN(TestPowerCpu)
+#include "tst_powercpu.moc"
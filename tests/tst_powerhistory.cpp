@@ -0,0 +1,277 @@
+/*
+#
+# Draco Desktop Environment <https://dracolinux.org>
+# Copyright (c) 2019, Ole-André Rodlie <ole.andre.rodlie@gmail.com>
+# All rights reserved.
+#
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser Public License as published by
+* the Free Software Foundation; either version 2.1 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>
+#
+*/
+
+#include <QtTest>
+#include <QTemporaryDir>
+#include <qmath.h>
+#include <string.h>
+
+#include "org.dracolinux.Power.History.h"
+
+#define HEADER_SIZE (qint64)sizeof(history_header)
+#define FILE_SIZE (HEADER_SIZE+(qint64)sizeof(history_sample)*HISTORY_CAPACITY)
+#define SEQUENCE_OFFSET 5*sizeof(quint32)
+
+class TestPowerHistory : public QObject
+{
+    Q_OBJECT
+
+private:
+    QTemporaryDir *dir;
+    QString path;
+
+    history_sample createSample(qint64 time, float energy, bool ac = false)
+    {
+        history_sample sample;
+        memset(&sample, 0, sizeof(sample));
+        sample.time = time;
+        sample.energy = energy;
+        sample.rate = 10;
+        sample.percentage = energy;
+        sample.ac = ac;
+        return sample;
+    }
+
+    bool patchFile(qint64 offset, quint32 value)
+    {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadWrite) || !file.seek(offset)) { return false; }
+        bool result = file.write(reinterpret_cast<const char*>(&value), sizeof(value)) == sizeof(value);
+        file.close();
+        return result;
+    }
+
+private slots:
+    void init()
+    {
+        dir = new QTemporaryDir();
+        QVERIFY(dir->isValid());
+        path = QString("%1/%2").arg(dir->path()).arg(HISTORY_FILE);
+    }
+
+    void cleanup()
+    {
+        delete dir;
+    }
+
+    void create()
+    {
+        PowerHistory reader(false, path);
+        QVERIFY(!reader.isValid()); // no file yet
+        PowerHistory writer(true, path);
+        QVERIFY(writer.isValid());
+        QCOMPARE(QFileInfo(path).size(), FILE_SIZE);
+        QCOMPARE(writer.count(), 0);
+        QCOMPARE(writer.last().time, (qint64)0);
+        QVERIFY(writer.samples().isEmpty());
+    }
+
+    void appendAndRead()
+    {
+        PowerHistory writer(true, path);
+        for (int i=1;i<=10;++i) { QVERIFY(writer.append(createSample(i*60, 100-i))); }
+        QCOMPARE(writer.count(), 10);
+        QCOMPARE(writer.last().time, (qint64)600);
+
+        PowerHistory reader(false, path);
+        QVERIFY(reader.isValid());
+        QVERIFY(!reader.append(createSample(660, 50)));
+        QCOMPARE(reader.count(), 10);
+        QVector<history_sample> samples = reader.samples();
+        QCOMPARE(samples.size(), 10);
+        QCOMPARE(samples.first().time, (qint64)60);
+        QCOMPARE(samples.last().energy, 90.0f);
+
+        // the reader sees new samples without reopening
+        QVERIFY(writer.append(createSample(660, 89)));
+        QCOMPARE(reader.count(), 11);
+        QCOMPARE(reader.last().time, (qint64)660);
+    }
+
+    void wraparound()
+    {
+        PowerHistory writer(true, path);
+        int total = HISTORY_CAPACITY+100;
+        for (int i=0;i<total;++i) { QVERIFY(writer.append(createSample(i+1, 50))); }
+        QCOMPARE(writer.count(), HISTORY_CAPACITY);
+        QVector<history_sample> samples = writer.samples();
+        QCOMPARE(samples.size(), HISTORY_CAPACITY);
+        QCOMPARE(samples.first().time, (qint64)101); // oldest 100 were overwritten
+        QCOMPARE(samples.last().time, (qint64)total);
+        for (int i=1;i<samples.size();++i) { QVERIFY(samples.at(i).time>samples.at(i-1).time); }
+    }
+
+    void sinceAndMaxPoints()
+    {
+        PowerHistory writer(true, path);
+        for (int i=1;i<=100;++i) { writer.append(createSample(i*10, 50)); }
+        QVector<history_sample> samples = writer.samples(505);
+        QCOMPARE(samples.size(), 50);
+        QCOMPARE(samples.first().time, (qint64)510);
+        QCOMPARE(writer.samples(1001).size(), 0);
+
+        samples = writer.samples(0, 10);
+        QCOMPARE(samples.size(), 10);
+        QCOMPARE(samples.first().time, (qint64)10);
+        QCOMPARE(samples.at(1).time, (qint64)110);
+        QVERIFY(writer.samples(0, 30).size()<=30);
+        QCOMPARE(writer.samples(0, 200).size(), 100);
+    }
+
+    void persistent()
+    {
+        {
+            PowerHistory writer(true, path);
+            writer.append(createSample(60, 80));
+            writer.append(createSample(120, 79));
+        }
+        PowerHistory writer(true, path);
+        QCOMPARE(writer.count(), 2);
+        QCOMPARE(writer.last().energy, 79.0f);
+    }
+
+    void resetOnBadHeader()
+    {
+        {
+            PowerHistory writer(true, path);
+            writer.append(createSample(60, 80));
+        }
+        QVERIFY(patchFile(sizeof(quint32), HISTORY_VERSION+1)); // version
+        PowerHistory reader(false, path);
+        QVERIFY(!reader.isValid());
+        QCOMPARE(reader.count(), 0);
+        PowerHistory writer(true, path);
+        QVERIFY(writer.isValid());
+        QCOMPARE(writer.count(), 0);
+    }
+
+    void resetOnInterruptedWrite()
+    {
+        {
+            PowerHistory writer(true, path);
+            writer.append(createSample(60, 80));
+        }
+        // writer died half way through an append
+        QVERIFY(patchFile(SEQUENCE_OFFSET, 3));
+        PowerHistory reader(false, path);
+        QVERIFY(reader.isValid());
+        QCOMPARE(reader.count(), 0); // gives up after HISTORY_READ_RETRIES
+        QVERIFY(reader.samples().isEmpty());
+        PowerHistory writer(true, path);
+        QCOMPARE(writer.count(), 0);
+        QVERIFY(writer.append(createSample(120, 79)));
+        QCOMPARE(reader.count(), 1);
+    }
+
+    void resetOnBadSize()
+    {
+        {
+            QFile file(path);
+            QVERIFY(file.open(QIODevice::WriteOnly));
+            file.write("garbage");
+        }
+        PowerHistory reader(false, path);
+        QVERIFY(!reader.isValid());
+        PowerHistory writer(true, path);
+        QVERIFY(writer.isValid());
+        QCOMPARE(QFileInfo(path).size(), FILE_SIZE);
+    }
+
+    void dischargeSeed()
+    {
+        PowerDischarge discharge;
+        QCOMPARE(discharge.rate(), 0.0);
+        QCOMPARE(discharge.timeToEmpty(50, 0), (qlonglong)-1);
+        discharge.add(1000, 50, 10, false);
+        QCOMPARE(discharge.rate(), 10.0); // reported rate until a real delta
+        discharge.add(1000, 50, 12, false); // same reading
+        QCOMPARE(discharge.rate(), 10.0);
+    }
+
+    void dischargeSmoothing()
+    {
+        PowerDischarge discharge;
+        discharge.add(1000, 50, 0, false);
+        QCOMPARE(discharge.rate(), 0.0);
+        discharge.add(1060, 49.9, 0, false); // 6 W
+        QVERIFY(qAbs(discharge.rate()-6.0)<0.001);
+
+        // a 12 W delta moves the rate by alpha = 1-exp(-dt/tau)
+        discharge.add(1120, 49.7, 0, false);
+        double alpha = 1-qExp(-60.0/DISCHARGE_TAU);
+        QVERIFY(qAbs(discharge.rate()-(6.0+alpha*6.0))<0.001);
+
+        // converges on a steady load
+        double energy = 49.7;
+        for (qint64 time=1180;time<1180+DISCHARGE_TAU*10;time+=60) {
+            energy -= 0.2;
+            discharge.add(time, energy, 0, false);
+        }
+        QVERIFY(qAbs(discharge.rate()-12.0)<0.01);
+    }
+
+    void dischargeAc()
+    {
+        PowerDischarge discharge;
+        discharge.add(1000, 50, 10, false);
+        discharge.add(1060, 49.9, 10, false);
+        QVERIFY(discharge.rate()>0);
+        discharge.add(1120, 49.9, 10, true);
+        QCOMPARE(discharge.rate(), 0.0);
+        // charging (energy going up) only rebases
+        discharge.add(1180, 51, 0, false);
+        discharge.add(1240, 52, 0, false);
+        QCOMPARE(discharge.rate(), 0.0);
+    }
+
+    void dischargeRestart()
+    {
+        PowerDischarge discharge;
+        discharge.add(1000, 50, 0, false);
+        discharge.add(1060, 49.9, 0, false);
+        double rate = discharge.rate();
+        discharge.restart();
+        // slept for an hour, the energy lost meanwhile isn't a rate
+        discharge.add(4660, 40, 0, false);
+        QCOMPARE(discharge.rate(), rate);
+        discharge.add(4720, 39.9, 0, false);
+        QVERIFY(qAbs(discharge.rate()-rate)<0.001);
+    }
+
+    void estimate()
+    {
+        PowerDischarge discharge;
+        discharge.add(1000, 50, 0, false);
+        discharge.add(1060, 49.9, 0, false); // 6 W
+        QCOMPARE(discharge.timeToEmpty(49.9, 1.9), (qlonglong)(48*600));
+        QCOMPARE(discharge.timeToEmpty(1, 2), (qlonglong)0);
+
+        // 6 W of 60 Wh is 10% per hour
+        QVERIFY(qAbs(discharge.batteryLeft(80, 60, 3600)-70)<0.001);
+        QVERIFY(qAbs(discharge.batteryLeft(80, 60, 0)-80)<0.001);
+        QCOMPARE(discharge.batteryLeft(5, 60, 3600*10), 1.0);
+        QCOMPARE(discharge.batteryLeft(0.5, 60, 3600), 0.5);
+        QCOMPARE(discharge.batteryLeft(80, 0, 3600), 80.0);
+    }
+};
+
+QTEST_GUILESS_MAIN(TestPowerHistory)
+#include "tst_powerhistory.moc"
@@ -0,0 +1,158 @@
+/*
+#
+# Draco Desktop Environment <https://dracolinux.org>
+# Copyright (c) 2019, Ole-André Rodlie <ole.andre.rodlie@gmail.com>
+# All rights reserved.
+#
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser Public License as published by
+* the Free Software Foundation; either version 2.1 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>
+#
+*/
+
+#include <QtTest>
+#include <QTemporaryDir>
+
+#include "fakesysfs.h"
+#include "org.dracolinux.Powerd.Manager.CPU.h"
+#include "org.dracolinux.Powerd.Manager.Policy.h"
+
+#define CPU_EPP "sys/devices/system/cpu/cpufreq/policy0/energy_performance_preference"
+#define CPU_MAX_FREQ "sys/devices/system/cpu/cpufreq/policy0/scaling_max_freq"
+#define CPU_NO_TURBO "sys/devices/system/cpu/intel_pstate/no_turbo"
+
+class TestPowerPolicy : public QObject
+{
+    Q_OBJECT
+
+private:
+    QTemporaryDir *dir;
+    FakeSysfs *tree;
+    PowerPolicy *policy;
+    qulonglong busy;
+    qulonglong idle;
+
+    void sample(qulonglong addBusy, qulonglong addIdle)
+    {
+        busy += addBusy;
+        idle += addIdle;
+        QVERIFY(tree->setStat(busy, idle));
+        QMetaObject::invokeMethod(policy, "sample", Qt::DirectConnection);
+    }
+
+private slots:
+    void init()
+    {
+        dir = new QTemporaryDir();
+        QVERIFY(dir->isValid());
+        tree = new FakeSysfs(dir->path());
+        busy = 1000;
+        idle = 9000;
+        QVERIFY(tree->addCpus(4));
+        QVERIFY(tree->addMains("AC", true));
+        QVERIFY(tree->addBattery("BAT0", 40, 50));
+        QVERIFY(tree->setStat(busy, idle));
+        QVERIFY(tree->setPressure(0));
+        policy = new PowerPolicy();
+        policy->setSysRoot(tree->sysRoot());
+        policy->setProcRoot(tree->procRoot());
+    }
+
+    void cleanup()
+    {
+        delete policy;
+        delete tree;
+        delete dir;
+    }
+
+    void profiles()
+    {
+        QVERIFY(!policy->setProfile("turbo"));
+        QCOMPARE(policy->profile(), (int)cpuProfileNone);
+        QVERIFY(policy->setProfile("balanced"));
+        QCOMPARE(policy->profileName(), QString("balanced"));
+        QVERIFY(!policy->onBattery());
+        QCOMPARE(policy->level(), (int)cpuLevelMid);
+        QCOMPARE(tree->read(CPU_EPP), QString("balance_performance"));
+        QCOMPARE(tree->read(CPU_MAX_FREQ), QString("2400000"));
+        QCOMPARE(tree->read(CPU_NO_TURBO), QString("0"));
+
+        QVERIFY(policy->setProfile("performance"));
+        QCOMPARE(policy->level(), (int)cpuLevelHigh);
+        QCOMPARE(tree->read(CPU_EPP), QString("performance"));
+
+        QVERIFY(policy->setProfile("powersave"));
+        QCOMPARE(policy->level(), (int)cpuLevelMid);
+    }
+
+    void stepUpAndDown()
+    {
+        QVERIFY(policy->setProfile("balanced"));
+        sample(1000, 100); // 91% busy
+        QCOMPARE(policy->level(), (int)cpuLevelHigh);
+        QCOMPARE(tree->read(CPU_EPP), QString("performance"));
+        sample(500, 500); // 50%, stays
+        QCOMPARE(policy->level(), (int)cpuLevelHigh);
+        for (int i=1;i<POLICY_DOWN_SAMPLES;++i) {
+            sample(10, 990);
+            QCOMPARE(policy->level(), (int)cpuLevelHigh);
+        }
+        sample(10, 990);
+        QCOMPARE(policy->level(), (int)cpuLevelMid); // never below the profile
+        for (int i=0;i<POLICY_DOWN_SAMPLES*2;++i) { sample(10, 990); }
+        QCOMPARE(policy->level(), (int)cpuLevelMid);
+    }
+
+    void pressure()
+    {
+        QVERIFY(policy->setProfile("balanced"));
+        QVERIFY(tree->setPressure(75));
+        sample(10, 990); // idle, but stalled
+        QCOMPARE(policy->level(), (int)cpuLevelHigh);
+    }
+
+    void battery()
+    {
+        QVERIFY(policy->setProfile("balanced"));
+        QVERIFY(tree->addMains("AC", false));
+        sample(10, 990);
+        QVERIFY(policy->onBattery());
+        QCOMPARE(policy->level(), (int)cpuLevelMid);
+        QCOMPARE(tree->read(CPU_EPP), QString("balance_power"));
+        QCOMPARE(tree->read(CPU_NO_TURBO), QString("1"));
+
+        QVERIFY(policy->setProfile("powersave"));
+        QCOMPARE(policy->level(), (int)cpuLevelLow);
+        QCOMPARE(tree->read(CPU_EPP), QString("power"));
+        QCOMPARE(tree->read(CPU_MAX_FREQ),
+                 QString::number(2400000*POLICY_LOW_MAX_PERF/100));
+        sample(1000, 0); // busy, but capped on battery
+        QCOMPARE(policy->level(), (int)cpuLevelLow);
+    }
+
+    void disable()
+    {
+        QVERIFY(tree->addMains("AC", false));
+        QVERIFY(policy->setProfile("powersave"));
+        QCOMPARE(tree->read(CPU_EPP), QString("power"));
+        QVERIFY(policy->setProfile(""));
+        QCOMPARE(policy->level(), -1);
+        QCOMPARE(tree->read(CPU_EPP), QString("default"));
+        QCOMPARE(tree->read(CPU_MAX_FREQ), QString("2400000"));
+        QCOMPARE(tree->read(CPU_NO_TURBO), QString("0"));
+        sample(1000, 0); // disabled, nothing changes
+        QCOMPARE(tree->read(CPU_EPP), QString("default"));
+    }
+};
+
+QTEST_GUILESS_MAIN(TestPowerPolicy)
+#include "tst_powerpolicy.moc"